@@ -0,0 +1,113 @@
+;; The MIT License (MIT)
+;;
+;; Copyright (c) 2016 Hironori Ishibashi
+;;
+;; Permission is hereby granted, free of charge, to any person obtaining a copy
+;; of this software and associated documentation files (the "Software"), to
+;; deal in the Software without restriction, including without limitation the
+;; rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+;; sell copies of the Software, and to permit persons to whom the Software is
+;; furnished to do so, subject to the following conditions:
+;;
+;; The above copyright notice and this permission notice shall be included in
+;; all copies or substantial portions of the Software.
+;;
+;; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+;; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+;; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+;; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+;; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+;; FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+;; IN THE SOFTWARE.
+
+;;;;;;;;;;;;;;
+;; Settings ;;
+;;;;;;;;;;;;;; You can edit this section.
+;;-----------------------------------------------------------------------------
+;; List of numbers of threads.
+(define thread-list (list 1 2 4 8))
+
+;; Size of hash table. (MB)
+(define hash-size 512)
+
+;; Number of repeat.
+(define repeat 3)
+
+;; Position. (FEN)
+(define fen "r1bq1r1k/p1pnbpp1/1p2p3/6p1/3PB3/5N2/PPPQ1PPP/2KR3R w - - 0 1")
+
+;; Depth. (Ply)
+(define depth 13)
+;;-----------------------------------------------------------------------------
+
+;; Generate Engine.
+(define engine (gen-engine))
+
+;; The last "info depth .." line, which is the result of a search.
+(define output "")
+
+;; If str is "info depth ..", then update output.
+(define (info?-update str)
+        (if (not (null? (regex-search "^info depth" str)))
+            (set! output str)
+            ()))
+
+;; Value next to key in li.
+(define (value-of key li)
+        (cond ((not (pair? li)) 0)
+              ((equal? (car li) key) (parse (cadr li)))
+              (else (value-of key (cdr li)))))
+
+;; Mean.
+(define (mean li)
+        (/ (apply + li) (length li)))
+
+;; Listener.
+(define (output-listener message)
+        (stderr (append message "\n"))
+        (info?-update message))
+
+;; Measure one setting and print a line.
+(define (measure lazy-smp threads)
+        (define data-time ())
+        (define data-nodes ())
+        (define data-nps ())
+        (engine '@input-uci-command
+                (append "setoption name lazy smp value " lazy-smp))
+        (engine '@input-uci-command
+                (append "setoption name threads value " (to-string threads)))
+        (for (x (range repeat))
+             (engine '@input-uci-command "ucinewgame")
+             (engine '@input-uci-command (append "position fen " fen))
+             (engine '@go-depth depth)
+             (define result (string-split output " "))
+             (push-back! data-time (value-of "time" result))
+             (push-back! data-nodes (value-of "nodes" result))
+             (push-back! data-nps (value-of "nps" result)))
+        (display (if (equal? lazy-smp "true") "Lazy SMP" "    YBWC")
+                 " | Threads: " threads
+                 " | Time: " (mean data-time)
+                 " | Nodes: " (mean data-nodes)
+                 " | NPS: " (mean data-nps)))
+
+;; --- Run --- ;;
+;; Get ready.
+(engine '@add-uci-output-listener output-listener)
+(engine '@input-uci-command
+        (append "setoption name hash value " (to-string hash-size)))
+
+;; Go.
+(stderr "\n")
+(display "##########")
+(display "# Result #")
+(display "##########")
+(display "")
+(display "Settings:")
+(display "    Hash Size: " hash-size)
+(display "       Repeat: " repeat)
+(display "     Position: " fen)
+(display "        Depth: " depth)
+(display "")
+(for (threads thread-list)
+     (measure "false" threads)
+     (measure "true" threads))
@@ -22,6 +22,8 @@
 # FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 # IN THE SOFTWARE.
 
+import random
+
 def CountBits(bits):
     count = 0
     while bits != 0:
@@ -77,269 +79,61 @@ def GenIs2StepMove(src, dst):
     if SquareToRank(src) == 6:
         if (src - dst) == 16: return "true"
     return "false"
-ROT = [\
-    [\
-         0,  1,  2,  3,  4,  5,  6,  7,\
-         8,  9, 10, 11, 12, 13, 14, 15,\
-        16, 17, 18, 19, 20, 21, 22, 23,\
-        24, 25, 26, 27, 28, 29, 30, 31,\
-        32, 33, 34, 35, 36, 37, 38, 39,\
-        40, 41, 42, 43, 44, 45, 46, 47,\
-        48, 49, 50, 51, 52, 53, 54, 55,\
-        56, 57, 58, 59, 60, 61, 62, 63\
-    ],\
-    [\
-        28, 21, 15, 10,  6,  3,  1,  0,\
-        36, 29, 22, 16, 11,  7,  4,  2,\
-        43, 37, 30, 23, 17, 12,  8,  5,\
-        49, 44, 38, 31, 24, 18, 13,  9,\
-        54, 50, 45, 39, 32, 25, 19, 14,\
-        58, 55, 51, 46, 40, 33, 26, 20,\
-        61, 59, 56, 52, 47, 41, 34, 27,\
-        63, 62, 60, 57, 53, 48, 42, 35\
-    ],\
-    [\
-         7, 15, 23, 31, 39, 47, 55, 63,\
-         6, 14, 22, 30, 38, 46, 54, 62,\
-         5, 13, 21, 29, 37, 45, 53, 61,\
-         4, 12, 20, 28, 36, 44, 52, 60,\
-         3, 11, 19, 27, 35, 43, 51, 59,\
-         2, 10, 18, 26, 34, 42, 50, 58,\
-         1,  9, 17, 25, 33, 41, 49, 57,\
-         0,  8, 16, 24, 32, 40, 48, 56\
-    ],\
-    [\
-         0,  2,  5,  9, 14, 20, 27, 35,\
-         1,  4,  8, 13, 19, 26, 34, 42,\
-         3,  7, 12, 18, 25, 33, 41, 48,\
-         6, 11, 17, 24, 32, 40, 47, 53,\
-        10, 16, 23, 31, 39, 46, 52, 57,\
-        15, 22, 30, 38, 45, 51, 56, 60,\
-        21, 29, 37, 44, 50, 55, 59, 62,\
-        28, 36, 43, 49, 54, 58, 61, 63\
-    ]\
-]
-R_ROT = [
-    [\
-         0,  1,  2,  3,  4,  5,  6,  7,\
-         8,  9, 10, 11, 12, 13, 14, 15,\
-        16, 17, 18, 19, 20, 21, 22, 23,\
-        24, 25, 26, 27, 28, 29, 30, 31,\
-        32, 33, 34, 35, 36, 37, 38, 39,\
-        40, 41, 42, 43, 44, 45, 46, 47,\
-        48, 49, 50, 51, 52, 53, 54, 55,\
-        56, 57, 58, 59, 60, 61, 62, 63\
-    ],\
-    [\
-         7,\
-         6, 15,\
-         5, 14, 23,\
-         4, 13, 22, 31,\
-         3, 12, 21, 30, 39,\
-         2, 11, 20, 29, 38, 47,\
-         1, 10, 19, 28, 37, 46, 55,\
-         0,  9, 18, 27, 36, 45, 54, 63,\
-         8, 17, 26, 35, 44, 53, 62,\
-        16, 25, 34, 43, 52, 61,\
-        24, 33, 42, 51, 60,\
-        32, 41, 50, 59,\
-        40, 49, 58,\
-        48, 57,\
-        56\
-    ],\
-    [\
-        56, 48, 40, 32, 24, 16,  8,  0,
-        57, 49, 41, 33, 25, 17,  9,  1,
-        58, 50, 42, 34, 26, 18, 10,  2,
-        59, 51, 43, 35, 27, 19, 11,  3,
-        60, 52, 44, 36, 28, 20, 12,  4,
-        61, 53, 45, 37, 29, 21, 13,  5,
-        62, 54, 46, 38, 30, 22, 14,  6,
-        63, 55, 47, 39, 31, 23, 15,  7
-    ],\
-    [\
-         0,\
-         8,  1,\
-        16,  9,  2,\
-        24, 17, 10,  3,\
-        32, 25, 18, 11,  4,\
-        40, 33, 26, 19, 12,  5,\
-        48, 41, 34, 27, 20, 13,  6,\
-        56, 49, 42, 35, 28, 21, 14,  7,\
-        57, 50, 43, 36, 29, 22, 15,\
-        58, 51, 44, 37, 30, 23,\
-        59, 52, 45, 38, 31,\
-        60, 53, 46, 39,\
-        61, 54, 47,\
-        62, 55,\
-        63\
-    ]\
-]
-MAGIC_SHIFT_V = [\
-     0,  0,  0,  0,  0,  0,  0,  0,\
-     8,  8,  8,  8,  8,  8,  8,  8,\
-    16, 16, 16, 16, 16, 16, 16, 16,\
-    24, 24, 24, 24, 24, 24, 24, 24,\
-    32, 32, 32, 32, 32, 32, 32, 32,\
-    40, 40, 40, 40, 40, 40, 40, 40,\
-    48, 48, 48, 48, 48, 48, 48, 48,\
-    56, 56, 56, 56, 56, 56, 56, 56\
-]
-MAGIC_SHIFT_D = [\
-     0,\
-     1,  1,\
-     3,  3,  3,\
-     6,  6,  6,  6,\
-    10, 10, 10, 10, 10,\
-    15, 15, 15, 15, 15, 15,\
-    21, 21, 21, 21, 21, 21, 21,\
-    28, 28, 28, 28, 28, 28, 28, 28,\
-    36, 36, 36, 36, 36, 36, 36,\
-    43, 43, 43, 43, 43, 43,\
-    49, 49, 49, 49, 49,\
-    54, 54, 54, 54,\
-    58, 58, 58,\
-    61, 61,\
-    63\
-]
-MAGIC_SHIFT = []
-for square in range(64):
-    MAGIC_SHIFT += [[\
-        MAGIC_SHIFT_V[ROT[0][square]], MAGIC_SHIFT_D[ROT[1][square]], \
-        MAGIC_SHIFT_V[ROT[2][square]], MAGIC_SHIFT_D[ROT[3][square]]\
-    ]]
-MAGIC_MASK_V = [\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff\
-]
-MAGIC_MASK_D = [\
-    0x1,\
-    0x3, 0x3,\
-    0x7, 0x7, 0x7,\
-    0xf, 0xf, 0xf, 0xf,\
-    0x1f, 0x1f, 0x1f, 0x1f, 0x1f,\
-    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,\
-    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,\
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,\
-    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,\
-    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,\
-    0x1f, 0x1f, 0x1f, 0x1f, 0x1f,\
-    0xf, 0xf, 0xf, 0xf,\
-    0x7, 0x7, 0x7,\
-    0x3, 0x3,\
-    0x1\
-]
-MAGIC_MASK = []
-for square in range(64):
-    MAGIC_MASK += [[\
-        MAGIC_MASK_V[ROT[0][square]], MAGIC_MASK_D[ROT[1][square]], \
-        MAGIC_MASK_V[ROT[2][square]], MAGIC_MASK_D[ROT[3][square]]\
-    ]]
-
-def BBToSquare(bb): return CountBits((bb & (-bb)) - 1)
-def GetPoint(square, rot):
-    return (SquareToBB(ROT[rot][square]) >> MAGIC_SHIFT[square][rot]) \
-    & MAGIC_MASK[square][rot]
-def ToBitboard(bit, square, rot):
-    return SquareToBB(R_ROT[rot][BBToSquare(bit\
-    << MAGIC_SHIFT[square][rot])])
-def GenAttackMagic(square, pattern):
-    ret0 = 0
-    ret45 = 0
-    ret90 = 0
-    ret135 = 0
-    bit0 = GetPoint(square, 0)
-    bit45 = GetPoint(square, 1)
-    bit90 = GetPoint(square, 2)
-    bit135 = GetPoint(square, 3)
-    for i in range(8):
-        bit0 = (bit0 << 1) & MAGIC_MASK[square][0]
-        bit45 = (bit45 << 1) & MAGIC_MASK[square][1]
-        bit90 = (bit90 << 1) & MAGIC_MASK[square][2]
-        bit135 = (bit135 << 1) & MAGIC_MASK[square][3]
-        if bit0 != 0:
-            ret0 |= ToBitboard(bit0, square, 0)
-            if (bit0 & pattern) != 0: bit0 = 0
-        if bit45 != 0:
-            ret45 |= ToBitboard(bit45, square, 1)
-            if (bit45 & pattern) != 0: bit45 = 0
-        if bit90 != 0:
-            ret90 |= ToBitboard(bit90, square, 2)
-            if (bit90 & pattern) != 0: bit90 = 0
-        if bit135 != 0:
-            ret135 |= ToBitboard(bit135, square, 3)
-            if (bit135 & pattern) != 0: bit135 = 0
-    bit0 = GetPoint(square, 0)
-    bit45 = GetPoint(square, 1)
-    bit90 = GetPoint(square, 2)
-    bit135 = GetPoint(square, 3)
-    for i in range(8):
-        bit0 = (bit0 >> 1) & MAGIC_MASK[square][0]
-        bit45 = (bit45 >> 1) & MAGIC_MASK[square][1]
-        bit90 = (bit90 >> 1) & MAGIC_MASK[square][2]
-        bit135 = (bit135 >> 1) & MAGIC_MASK[square][3]
-        if bit0 != 0:
-            ret0 |= ToBitboard(bit0, square, 0)
-            if (bit0 & pattern) != 0: bit0 = 0
-        if bit45 != 0:
-            ret45 |= ToBitboard(bit45, square, 1)
-            if (bit45 & pattern) != 0: bit45 = 0
-        if bit90 != 0:
-            ret90 |= ToBitboard(bit90, square, 2)
-            if (bit90 & pattern) != 0: bit90 = 0
-        if bit135 != 0:
-            ret135 |= ToBitboard(bit135, square, 3)
-            if (bit135 & pattern) != 0: bit135 = 0
-    return "{" + hex(ret0) + "ULL," + hex(ret45) + "ULL," \
-    + hex(ret90) + "ULL," + hex(ret135) + "ULL}"
-
-def GenPawnMovable(side, square, pattern):
-    if side == 0:
-        return "0x0ULL"
 
+BISHOP_DIRS = [(1, 1), (1, -1), (-1, 1), (-1, -1)]
+ROOK_DIRS = [(1, 0), (-1, 0), (0, 1), (0, -1)]
+def GenSlidingAttack(square, blocker, dirs):
     ret = 0
-    rank = SquareToRank(square)
-    if side == 1:
-        if rank == 1:
-            if (GetPoint(square + 8, 2) & pattern) == 0:
-                ret |= SquareToBB(square + 8)
-                if (GetPoint(square + 16, 2)& pattern) == 0:
-                    ret |= SquareToBB(square + 16)
-            return hex(ret) + "ULL"
-        elif rank == 7:
-            return "0x0ULL"
-        else:
-            if (GetPoint(square + 8, 2)& pattern) == 0:
-                ret |= SquareToBB(square + 8)
-            return hex(ret) + "ULL"
-    elif side == 2:
-        if rank == 6:
-            if (GetPoint(square - 8, 2) & pattern) == 0:
-                ret |= SquareToBB(square - 8)
-                if (GetPoint(square - 16, 2) & pattern) == 0:
-                    ret |= SquareToBB(square - 16)
-            return hex(ret) + "ULL"
-        elif rank == 0:
-            return "0x0ULL"
-        else:
-            if (GetPoint(square - 8, 2)& pattern) == 0:
-                ret |= SquareToBB(square - 8)
-            return hex(ret) + "ULL"
+    for d_fyle, d_rank in dirs:
+        fyle = SquareToFyle(square) + d_fyle
+        rank = SquareToRank(square) + d_rank
+        while (0 <= fyle < 8) and (0 <= rank < 8):
+            bb = CoordToBB(fyle, rank)
+            ret |= bb
+            if (bb & blocker) != 0: break
+            fyle += d_fyle
+            rank += d_rank
+    return ret
+def GenMagicMask(square, dirs):
+    edge = 0
+    for rank in [0, 7]:
+        if rank != SquareToRank(square): edge |= 0xff << (8 * rank)
+    for fyle in [0, 7]:
+        if fyle != SquareToFyle(square): edge |= 0x0101010101010101 << fyle
+    return GenSlidingAttack(square, 0, dirs) & ~edge & 0xffffffffffffffff
+def GenMagic(square, dirs, rng):
+    mask = GenMagicMask(square, dirs)
+    shift = 64 - CountBits(mask)
+
+    # マスクの部分集合を全て列挙する。 (Carry-Rippler)
+    patterns = []
+    blocker = 0
+    while True:
+        patterns += [(blocker, GenSlidingAttack(square, blocker, dirs))]
+        blocker = (blocker - mask) & mask
+        if blocker == 0: break
 
-    return "0x0ULL"
+    # 衝突の無いマジックナンバーが見つかるまで探す。
+    while True:
+        magic = rng.getrandbits(64) & rng.getrandbits(64) \
+        & rng.getrandbits(64)
+        if CountBits(((mask * magic) & 0xffffffffffffffff) >> 56) < 6:
+            continue
+        table = {}
+        is_ok = True
+        for blocker, attack in patterns:
+            index = ((blocker * magic) & 0xffffffffffffffff) >> shift
+            if table.setdefault(index, attack) != attack:
+                is_ok = False
+                break
+        if is_ok: return hex(magic) + "ULL"
 
 
 if __name__ == "__main__":
     frame = """\
 /* The MIT License (MIT)
  *
- * Copyright (c) 2013-2016 Hironori Ishibashi
+ * Copyright (c) 2013-2018 Hironori Ishibashi
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to
@@ -371,7 +165,7 @@ if __name__ == "__main__":
 
 namespace Sayuri {{
   namespace MetaUtil {{
-    /** CountBits()で使う、立っているビットの数のテーブル。 */
+    /** CountBitsByTable()で使う、立っているビットの数のテーブル。 */
     constexpr char NUM_BIT16_TABLE[0xffff + 1] {{
       {0}
     }};
@@ -400,14 +194,14 @@ namespace Sayuri {{
     constexpr bool IS_2STEP_MOVE[NUM_SQUARES][NUM_SQUARES] {{
       {5}
     }};
-
-    /** ライン攻撃のマジック用テーブル。 */
-    constexpr Bitboard ATTACK_TABLE[NUM_SQUARES][0xff + 1][NUM_ROTS] {{
+ 
+    /** ビショップのマジックナンバー。 */
+    constexpr Bitboard BISHOP_MAGIC[NUM_SQUARES] {{
       {6}
     }};
-
-    /** ポーンの動きのマジック用テーブル。 */
-    constexpr Bitboard PAWN_MOVABLE_TABLE[NUM_SIDES][NUM_SQUARES][0xff + 1] {{
+ 
+    /** ルークのマジックナンバー。 */
+    constexpr Bitboard ROOK_MAGIC[NUM_SQUARES] {{
       {7}
     }};
   }}
@@ -455,29 +249,12 @@ namespace Sayuri {{
     elms4 = elms4[:-1]
     elms5 = elms5[:-1]
 
-    # ATTACK_TABLE
-    elms6 = ""
-    for square in range(64):
-        elms6 += "{"
-        for pattern in range(0xff + 1):
-            elms6 += GenAttackMagic(square, pattern) + ","
-        elms6 = elms6[:-1]
-        elms6 += "},"
-    elms6 = elms6[:-1]
-
-    # PAWN_MOVABLE_TABLE
-    elms7 = ""
-    for side in range(3):
-        elms7 += "{"
-        for square in range(64):
-            elms7 += "{"
-            for pattern in range(0xff + 1):
-                elms7 += GenPawnMovable(side, square, pattern) + ","
-            elms7 = elms7[:-1]
-            elms7 += "},"
-        elms7 = elms7[:-1]
-        elms7 += "},"
-    elms7 = elms7[:-1]
+    # BISHOP_MAGIC ROOK_MAGIC (毎回同じ結果になるよう乱数を固定。)
+    rng = random.Random(0x5a7e1ed5ca1ab1e5)
+    elms6 = ",".join([GenMagic(square, BISHOP_DIRS, rng) \
+    for square in range(64)])
+    elms7 = ",".join([GenMagic(square, ROOK_DIRS, rng) \
+    for square in range(64)])
 
     # 出力。
     print(frame.format(elms0, elms1, elms2, elms3, elms4, elms5, elms6, elms7))
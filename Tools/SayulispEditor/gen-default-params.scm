@@ -45,6 +45,7 @@
                       @enable-history
                       @enable-killer
                       @enable-hash-table
+                      @enable-quiesce-hash-table
                       @enable-iid
                       @iid-limit-depth
                       @iid-search-depth
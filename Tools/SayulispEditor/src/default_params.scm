@@ -15,6 +15,7 @@
 (my-engine (quote @enable-history) (quote #t))
 (my-engine (quote @enable-killer) (quote #t))
 (my-engine (quote @enable-hash-table) (quote #t))
+(my-engine (quote @enable-quiesce-hash-table) (quote #t))
 (my-engine (quote @enable-iid) (quote #t))
 (my-engine (quote @iid-limit-depth) (quote 5))
 (my-engine (quote @iid-search-depth) (quote 4))
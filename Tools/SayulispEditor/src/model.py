@@ -48,6 +48,7 @@ class Model:
     ENABLE_HISTORY_SYMBOL = "@enable-history"
     ENABLE_KILLER_SYMBOL = "@enable-killer"
     ENABLE_HASH_TABLE_SYMBOL = "@enable-hash-table"
+    ENABLE_QUIESCE_HASH_TABLE_SYMBOL = "@enable-quiesce-hash-table"
     ENABLE_IID_SYMBOL = "@enable-iid"
     IID_LIMIT_DEPTH_SYMBOL = "@iid-limit-depth"
     IID_SEARCH_DEPTH_SYMBOL = "@iid-search-depth"
@@ -211,6 +212,8 @@ class Model:
         self.enable_killer)
         ret += to_sexpr(Model.ENABLE_HASH_TABLE_SYMBOL, \
         self.enable_hash_table)
+        ret += to_sexpr(Model.ENABLE_QUIESCE_HASH_TABLE_SYMBOL, \
+        self.enable_quiesce_hash_table)
         ret += to_sexpr(Model.ENABLE_IID_SYMBOL, \
         self.enable_iid)
         ret += to_sexpr(Model.IID_LIMIT_DEPTH_SYMBOL, \
@@ -487,6 +490,8 @@ class Model:
                     self.enable_killer = tup[2]
                 elif tup[1] == Model.ENABLE_HASH_TABLE_SYMBOL:
                     self.enable_hash_table = tup[2]
+                elif tup[1] == Model.ENABLE_QUIESCE_HASH_TABLE_SYMBOL:
+                    self.enable_quiesce_hash_table = tup[2]
                 elif tup[1] == Model.ENABLE_IID_SYMBOL:
                     self.enable_iid = tup[2]
                 elif tup[1] == Model.IID_LIMIT_DEPTH_SYMBOL:
@@ -225,8 +225,14 @@ class TranspositionTableConfig(BaseWindow):
         self.btn.Set(self.model.enable_hash_table)
         self.btn.pack()
 
+        self.quiesce_btn = MyCheckbutton(self.content_frame, \
+        "Use Transposition Table in Quiescence Search")
+        self.quiesce_btn.Set(self.model.enable_quiesce_hash_table)
+        self.quiesce_btn.pack()
+
     def OnOk(self):
         self.model.enable_hash_table = self.btn.Get()
+        self.model.enable_quiesce_hash_table = self.quiesce_btn.Get()
         self.OnCancel()
 
 class IIDConfig(BaseWindow):
@@ -48,17 +48,17 @@ namespace Sayuri {
       {0, 0, 0, 0, 0, 0, 0},
       {
         0, Util::RANK[RANK_2],
-        Util::SQUARE[B1][R0] | Util::SQUARE[G1][R0],
-        Util::SQUARE[C1][R0] | Util::SQUARE[F1][R0],
-        Util::SQUARE[A1][R0] | Util::SQUARE[H1][R0],
-        Util::SQUARE[D1][R0], Util::SQUARE[E1][R0]
+        Util::SQUARE[B1] | Util::SQUARE[G1],
+        Util::SQUARE[C1] | Util::SQUARE[F1],
+        Util::SQUARE[A1] | Util::SQUARE[H1],
+        Util::SQUARE[D1], Util::SQUARE[E1]
       },
       {
         0, Util::RANK[RANK_7],
-        Util::SQUARE[B8][R0] | Util::SQUARE[G8][R0],
-        Util::SQUARE[C8][R0] | Util::SQUARE[F8][R0],
-        Util::SQUARE[A8][R0] | Util::SQUARE[H8][R0],
-        Util::SQUARE[D8][R0], Util::SQUARE[E8][R0]
+        Util::SQUARE[B8] | Util::SQUARE[G8],
+        Util::SQUARE[C8] | Util::SQUARE[F8],
+        Util::SQUARE[A8] | Util::SQUARE[H8],
+        Util::SQUARE[D8], Util::SQUARE[E8]
       }
     };
     constexpr Bitboard NOT_START_POSITION[NUM_SIDES][NUM_PIECE_TYPES] {
@@ -92,23 +92,19 @@ namespace Sayuri {
 
     // ボードの状態からビショップの利き筋を作る。
     Bitboard GetBishopAttack(const Board& board, Square square) {
-      return Util::GetBishopMagic(square, board.blocker_[R45],
-      board.blocker_[R135]);
+      return Util::GetBishopMagic(square, board.blocker_);
     }
     // ボードの状態からルークの利き筋を作る。
     Bitboard GetRookAttack(const Board& board, Square square) {
-      return Util::GetRookMagic(square, board.blocker_[R0],
-      board.blocker_[R90]);
+      return Util::GetRookMagic(square, board.blocker_);
     }
     // ボードの状態からクイーンの利き筋を作る。
     Bitboard GetQueenAttack(const Board& board, Square square) {
-      return Util::GetQueenMagic
-      (square, board.blocker_[R0], board.blocker_[R45],
-      board.blocker_[R90], board.blocker_[R135]);
+      return Util::GetQueenMagic(square, board.blocker_);
     }
     // ボードの状態からポーンの動ける位置を作る。
     Bitboard GetPawnStep(const Board& board, Side side, Square square) {
-      return Util::GetPawnMovable(side, square, board.blocker_[R90]);
+      return Util::GetPawnMovable(side, square, board.blocker_);
     }
 
     // その位置が他の位置の駒に攻撃されているかどうかチェックする。
@@ -140,9 +136,9 @@ namespace Sayuri {
     // 白のショートキャスリングが出来るかどうか判定する。
     bool CanWhiteShortCastling(const Board& board) {
       return (board.castling_rights_ & WHITE_SHORT_CASTLING)
-      && !((board.blocker_[R0]
-      & (Util::SQUARE[F1][R0]
-      | Util::SQUARE[G1][R0]))
+      && !((board.blocker_
+      & (Util::SQUARE[F1]
+      | Util::SQUARE[G1]))
       || IsAttacked(board, E1, BLACK)
       || IsAttacked(board, F1, BLACK)
       || IsAttacked(board, G1, BLACK));
@@ -154,10 +150,10 @@ namespace Sayuri {
      */
     bool CanWhiteLongCastling(const Board& board) {
       return (board.castling_rights_ & WHITE_LONG_CASTLING)
-      && !((board.blocker_[R0]
-      & (Util::SQUARE[D1][R0]
-      | Util::SQUARE[C1][R0]
-      | Util::SQUARE[B1][R0]))
+      && !((board.blocker_
+      & (Util::SQUARE[D1]
+      | Util::SQUARE[C1]
+      | Util::SQUARE[B1]))
       || IsAttacked(board, E1, BLACK)
       || IsAttacked(board, D1, BLACK)
       || IsAttacked(board, C1, BLACK));
@@ -169,9 +165,9 @@ namespace Sayuri {
      */
     bool CanBlackShortCastling(const Board& board) {
       return (board.castling_rights_ & BLACK_SHORT_CASTLING)
-      && !((board.blocker_[R0]
-      & (Util::SQUARE[F8][R0]
-      | Util::SQUARE[G8][R0]))
+      && !((board.blocker_
+      & (Util::SQUARE[F8]
+      | Util::SQUARE[G8]))
       || IsAttacked(board, E8, WHITE)
       || IsAttacked(board, F8, WHITE)
       || IsAttacked(board, G8, WHITE));
@@ -183,10 +179,10 @@ namespace Sayuri {
      */
     bool CanBlackLongCastling(const Board& board) {
       return (board.castling_rights_ & BLACK_LONG_CASTLING)
-      && !((board.blocker_[R0]
-      & (Util::SQUARE[D8][R0]
-      | Util::SQUARE[C8][R0]
-      | Util::SQUARE[B8][R0]))
+      && !((board.blocker_
+      & (Util::SQUARE[D8]
+      | Util::SQUARE[C8]
+      | Util::SQUARE[B8]))
       || IsAttacked(board, E8, WHITE)
       || IsAttacked(board, D8, WHITE)
       || IsAttacked(board, C8, WHITE));
@@ -249,7 +245,7 @@ namespace Sayuri {
             if (((piece_side == WHITE) && (rank == RANK_6))
             || ((piece_side == BLACK) && (rank == RANK_3))) {
               ret |= Util::PAWN_ATTACK[piece_side][square]
-              & Util::SQUARE[square][R0];
+              & Util::SQUARE[square];
             }
 
             // 通常の動き。
@@ -266,24 +262,24 @@ namespace Sayuri {
             for (Bitboard bb = ret; bb; NEXT_BITBOARD(bb)) {
               Square square = Util::GetSquare(bb);
               if (IsAttacked(board, square, enemy_side)) {
-                ret &= ~Util::SQUARE[square][R0];
+                ret &= ~Util::SQUARE[square];
               }
             }
 
             // キャスリング。
             if (piece_side == WHITE) {
               if (CanWhiteShortCastling(board)) {
-                ret |= Util::SQUARE[G1][R0];
+                ret |= Util::SQUARE[G1];
               }
               if (CanWhiteLongCastling(board)) {
-                ret |= Util::SQUARE[C1][R0];
+                ret |= Util::SQUARE[C1];
               }
             } else {
               if (CanBlackShortCastling(board)) {
-                ret |= Util::SQUARE[G8][R0];
+                ret |= Util::SQUARE[G8];
               }
               if (CanBlackLongCastling(board)) {
-                ret |= Util::SQUARE[C8][R0];
+                ret |= Util::SQUARE[C8];
               }
             }
           }
@@ -384,14 +380,14 @@ namespace Sayuri {
   // センターのコントロール。
   ResultSquares AnalyseCenterControl(const Board& board, Square piece_square) {
     static const Bitboard CENTER_BB =
-    Util::SQUARE[C3][R0] | Util::SQUARE[C4][R0]
-    | Util::SQUARE[C5][R0] | Util::SQUARE[C6][R0]
-    | Util::SQUARE[D3][R0] | Util::SQUARE[D4][R0]
-    | Util::SQUARE[D5][R0] | Util::SQUARE[D6][R0]
-    | Util::SQUARE[E3][R0] | Util::SQUARE[E4][R0]
-    | Util::SQUARE[E5][R0] | Util::SQUARE[E6][R0]
-    | Util::SQUARE[F3][R0] | Util::SQUARE[F4][R0]
-    | Util::SQUARE[F5][R0] | Util::SQUARE[F6][R0];
+    Util::SQUARE[C3] | Util::SQUARE[C4]
+    | Util::SQUARE[C5] | Util::SQUARE[C6]
+    | Util::SQUARE[D3] | Util::SQUARE[D4]
+    | Util::SQUARE[D5] | Util::SQUARE[D6]
+    | Util::SQUARE[E3] | Util::SQUARE[E4]
+    | Util::SQUARE[E5] | Util::SQUARE[E6]
+    | Util::SQUARE[F3] | Util::SQUARE[F4]
+    | Util::SQUARE[F5] | Util::SQUARE[F6];
 
     return BBToResult(GenAttackBB(board, piece_square) & CENTER_BB);
   }
@@ -400,8 +396,8 @@ namespace Sayuri {
   ResultSquares AnalyseSweetCenterControl(const Board& board,
   Square piece_square) {
     static const Bitboard CENTER_BB = 
-    Util::SQUARE[D4][R0] | Util::SQUARE[D5][R0]
-    | Util::SQUARE[E4][R0] | Util::SQUARE[E5][R0];
+    Util::SQUARE[D4] | Util::SQUARE[D5]
+    | Util::SQUARE[E4] | Util::SQUARE[E5];
 
     return BBToResult(GenAttackBB(board, piece_square) & CENTER_BB);
   }
@@ -539,7 +535,7 @@ namespace Sayuri {
       temp &= FRONT_RANKS[side][rank];
 
       if (!(enemy_pawns & temp)) {
-        result |= Util::SQUARE[square][R0];
+        result |= Util::SQUARE[square];
       }
     }
 
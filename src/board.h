@@ -47,8 +47,8 @@ namespace Sayuri {
     Side side_board_[NUM_SQUARES];
     /** 各サイドの駒の配置のビットボード。 [サイド] */
     Bitboard side_pieces_[NUM_SIDES];
-    /** 全駒の配置のビットボード。 [角度]。 */
-    Bitboard blocker_[NUM_ROTS];
+    /** 全駒の配置のビットボード。 */
+    Bitboard blocker_;
     /** 各サイドのキングの位置。 [サイド] */
     Square king_[NUM_SIDES];
     /** 手番。 */
@@ -52,6 +52,7 @@ namespace Sayuri {
   enable_history_(false),
   enable_killer_(false),
   enable_ttable_(false),
+  enable_quiesce_ttable_(false),
   enable_iid_(false),
   iid_limit_depth_(0),
   iid_search_depth_(0),
@@ -83,6 +84,8 @@ namespace Sayuri {
     INIT_ARRAY(to_move_hash_value_table_);
     INIT_ARRAY(castling_hash_value_table_);
     INIT_ARRAY(en_passant_hash_value_table_);
+    INIT_ARRAY(opening_position_value_);
+    INIT_ARRAY(ending_position_value_);
     INIT_ARRAY(eval_cache_);
   }
   // コピーコンストラクタ。
@@ -119,6 +122,7 @@ namespace Sayuri {
     enable_history_ = params.enable_history();
     enable_killer_ = params.enable_killer();
     enable_ttable_ = params.enable_ttable();
+    enable_quiesce_ttable_ = params.enable_quiesce_ttable();
     enable_iid_ = params.enable_iid();
     iid_limit_depth_ = params.iid_limit_depth();
     iid_search_depth_ = params.iid_search_depth();
@@ -174,20 +178,35 @@ namespace Sayuri {
 
   // EvalParamsをキャッシュする。
   void Cache::CacheEvalParams(const EvalParams& params) {
+    // 駒の配置の価値。 (重みは駒の数毎のキャッシュで掛ける。)
+    FOR_PIECE_TYPES(piece_type) {
+      FOR_SQUARES(square) {
+        opening_position_value_[NO_SIDE][piece_type][square] = 0;
+        opening_position_value_[WHITE][piece_type][square] =
+        256.0 * params.opening_position_value_table()[piece_type][square];
+        opening_position_value_[BLACK][piece_type][square] =
+        -static_cast<int>(256.0 * params.opening_position_value_table()
+        [piece_type][Util::FLIP[square]]);
+
+        ending_position_value_[NO_SIDE][piece_type][square] = 0;
+        ending_position_value_[WHITE][piece_type][square] =
+        256.0 * params.ending_position_value_table()[piece_type][square];
+        ending_position_value_[BLACK][piece_type][square] =
+        -static_cast<int>(256.0 * params.ending_position_value_table()
+        [piece_type][Util::FLIP[square]]);
+      }
+    }
+
     for (unsigned int num_pieces = 0; num_pieces < (NUM_SQUARES + 1);
     ++num_pieces) {
       EvalCache* ptr = &(eval_cache_[num_pieces]);
 
       FOR_PIECE_TYPES(piece_type) {
-        FOR_SQUARES(square) {
-          ptr->opening_position_cache_[piece_type][square] =
-          256.0 * params.opening_position_value_table()[piece_type][square]
-          * params.weight_opening_position()[piece_type](num_pieces);
-
-          ptr->ending_position_cache_[piece_type][square] =
-          256.0 * params.ending_position_value_table()[piece_type][square]
-          * params.weight_ending_position()[piece_type](num_pieces);
-        }
+        ptr->opening_position_weight_cache_[piece_type] =
+        params.weight_opening_position()[piece_type](num_pieces);
+
+        ptr->ending_position_weight_cache_[piece_type] =
+        params.weight_ending_position()[piece_type](num_pieces);
 
         for (unsigned int num_attacks = 0;
         num_attacks < (EvalCache::MAX_ATTACKS + 1); ++num_attacks) {
@@ -307,6 +326,7 @@ namespace Sayuri {
     enable_history_ = cache.enable_history_;
     enable_killer_ = cache.enable_killer_;
     enable_ttable_ = cache.enable_ttable_;
+    enable_quiesce_ttable_ = cache.enable_quiesce_ttable_;
     enable_iid_ = cache.enable_iid_;
     iid_limit_depth_ = cache.iid_limit_depth_;
     iid_search_depth_ = cache.iid_search_depth_;
@@ -339,6 +359,8 @@ namespace Sayuri {
     max_nodes_ = cache.max_nodes_;
     max_depth_ = cache.max_depth_;
     thinking_time_ = cache.thinking_time_;
+    COPY_ARRAY(opening_position_value_, cache.opening_position_value_);
+    COPY_ARRAY(ending_position_value_, cache.ending_position_value_);
     COPY_ARRAY(eval_cache_, cache.eval_cache_);
   }
 }  // namespace Sayuri
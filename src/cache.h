@@ -50,10 +50,10 @@ namespace Sayuri {
     /** キング周辺のマスの数。 */
     static constexpr unsigned int NUM_AROUND_KING = 8;
 
-    /** キャッシュ - オープニングの配置。 */
-    int opening_position_cache_[NUM_PIECE_TYPES][NUM_SQUARES];
-    /** キャッシュ - エンディングの配置。 */
-    int ending_position_cache_[NUM_PIECE_TYPES][NUM_SQUARES];
+    /** キャッシュ - オープニングの配置の重み。 */
+    double opening_position_weight_cache_[NUM_PIECE_TYPES];
+    /** キャッシュ - エンディングの配置の重み。 */
+    double ending_position_weight_cache_[NUM_PIECE_TYPES];
     /** キャッシュ - 機動力。 */
     int mobility_cache_[NUM_PIECE_TYPES][MAX_ATTACKS + 1];
     /** キャッシュ - センターコントロール。 */
@@ -197,6 +197,11 @@ namespace Sayuri {
        * トランスポジションテーブル - 有効無効。
        */
       bool enable_ttable_;
+      /**
+       * 探索関数用キャッシュ。
+       * トランスポジションテーブル - クイース探索で使うかどうか。
+       */
+      bool enable_quiesce_ttable_;
       /**
        * 探索関数用キャッシュ。
        * Internal Iterative Deepening - 有効無効。
@@ -348,6 +353,19 @@ namespace Sayuri {
        */
       Chrono::milliseconds thinking_time_;
 
+      /**
+       * 評価関数用キャッシュ。
+       * オープニングの配置の価値。 (256倍、黒は符号を反転)
+       * [サイド][駒の種類][マス]
+       */
+      int opening_position_value_[NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
+      /**
+       * 評価関数用キャッシュ。
+       * エンディングの配置の価値。 (256倍、黒は符号を反転)
+       * [サイド][駒の種類][マス]
+       */
+      int ending_position_value_[NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
+
       /** キャッシュの配列。 */
       EvalCache eval_cache_[NUM_SQUARES + 1];
 
@@ -43,6 +43,29 @@ namespace Sayuri {
 
 #pragma warning(disable: 4146)  // 符号なしへのマイナス符号の警告を無効。
 
+#endif
+
+// ビット演算のバックエンドの選択。
+// SAYURI_NO_BUILTIN_BITOPSが定義されていなければ、
+// GCC/Clangの組み込み関数 (POPCNT、BSF/TZCNT命令) を使う。
+// 定義されていれば、16ビットのテーブルを引く。
+#if !defined(SAYURI_NO_BUILTIN_BITOPS) \
+&& (defined(__GNUC__) || defined(__clang__))
+
+// 最下位ビットの探索。 (BSFはx86-64の全てのCPUにある。)
+#define SAYURI_BUILTIN_CTZ
+
+// POPCNT命令が無いCPUでは、ライブラリ関数よりテーブルの方が速い。
+#if defined(__POPCNT__) || defined(__aarch64__)
+#define SAYURI_BUILTIN_POPCOUNT
+#endif
+
+#endif
+
+// マジックビットボードのインデックスの計算にPEXT命令 (BMI2) を使う。
+// (PEXT命令が遅いCPUもあるので、SAYURI_USE_PEXTで明示的に選ぶ。)
+#if defined(SAYURI_USE_PEXT) && !defined(__BMI2__)
+#undef SAYURI_USE_PEXT
 #endif
 
   // ============ //
@@ -111,6 +134,18 @@ IN THE SOFTWARE.)...";
 
 #endif
 
+  /**
+   * トランスポジションテーブルにラージページを使うかどうかのデフォルト設定。
+   * (使えない環境では通常のメモリを使う。)
+   */
+  constexpr bool UCI_DEFAULT_LARGE_PAGES = true;
+
+  /** 評価値のハッシュテーブルのデフォルトサイズ。 (スレッド毎) */
+  constexpr std::size_t UCI_DEFAULT_EVAL_TABLE_SIZE = 1ULL * 1024ULL * 1024ULL;
+
+  /** 評価値のハッシュテーブルの最大サイズ。 (スレッド毎) */
+  constexpr std::size_t UCI_MAX_EVAL_TABLE_SIZE = 64ULL * 1024ULL * 1024ULL;
+
   /** Ponder機能のデフォルト設定。 */
   constexpr bool UCI_DEFAULT_PONDER = true;
 
@@ -120,9 +155,25 @@ IN THE SOFTWARE.)...";
   /** スレッドの最大数。 */
   constexpr int UCI_MAX_THREADS = 64;
 
+  /**
+   * 並列探索にLazy SMPを使うかどうかのデフォルト設定。
+   * falseならYBWCを使う。
+   */
+  constexpr bool UCI_DEFAULT_LAZY_SMP = false;
+
   /** アナライズモードのデフォルト設定。 */
   constexpr bool UCI_DEFAULT_ANALYSE_MODE = false;
 
+  /** トランスポジションテーブルを保存するファイルのデフォルト。 */
+  constexpr const char* UCI_DEFAULT_HASH_FILE = "sayuri.hash";
+
+  /**
+   * 局面のハッシュ値を生成する種のデフォルト。
+   * 種が同じならハッシュ値は毎回同じになり、探索ノード数も再現でき、
+   * 保存したトランスポジションテーブルも読み込んで使える。
+   */
+  constexpr std::uint64_t UCI_DEFAULT_HASH_KEY_SEED = 0x5a7e1ed5ca1ab1e5ULL;
+
   // ====== //
   // マクロ //
   // ====== //
@@ -379,19 +430,6 @@ for (PieceType var_name = 0; var_name < NUM_PIECE_TYPES; ++var_name)
   /** 引き分けの評価値。 */
   constexpr int SCORE_DRAW = 0;
 
-  // 回転の角度を表す。
-  enum {
-    /** 0度。 */
-    R0,
-    /** 45度。 */
-    R45,
-    /** 90度。 */
-    R90,
-    /** 135度。 */
-    R135
-  };
-  constexpr int NUM_ROTS = 4;
-
   // ======================= //
   // Transposition Table関連 //
   // ======================= //
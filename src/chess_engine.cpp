@@ -31,7 +31,6 @@
 
 #include <iostream>
 #include <sstream>
-#include <random>
 #include <cstddef>
 #include <utility>
 #include <memory>
@@ -51,6 +50,7 @@
 #include "helper_queue.h"
 #include "params.h"
 #include "cache.h"
+#include "thread_pool.h"
 
 /** Sayuri 名前空間。 */
 namespace Sayuri {
@@ -63,7 +63,9 @@ namespace Sayuri {
   is_null_searching_(false),
   table_ptr_(nullptr),
   evaluator_(*this),
-  notice_cut_level_(MAX_PLYS + 1) {
+  notice_cut_level_(MAX_PLYS + 1),
+  thread_id_(0),
+  next_node_check_(0) {
     SetNewGame();
 
     // 探索関数用パラメータ。
@@ -88,12 +90,26 @@ namespace Sayuri {
       job_table_[i].client_ptr_ = this;
       job_table_[i].level_ = i;
     }
+
+    // 分岐点の局面。
+    split_st_table_.reset(new BasicStruct[MAX_PLYS + 1]);
+
+#if defined(SAYURI_COPY_MAKE)
+    // Copy-Make用の局面のテーブル。
+    state_table_.reset(new BoardState[MAX_PLYS + 1]);
+#endif
+
+    // 手の並び替え用テーブル。
+    order_st_ptr_.reset(new OrderStruct());
+    order_st_ptr_->Clear();
   }
 
   // プライベートコンストラクタ。
   ChessEngine::ChessEngine() : 
   is_null_searching_(false),
-  evaluator_(*this) {
+  evaluator_(*this),
+  thread_id_(0),
+  next_node_check_(0) {
     SetNewGame();
 
     // ムーブメーカー。
@@ -111,13 +127,27 @@ namespace Sayuri {
       job_table_[i].client_ptr_ = this;
       job_table_[i].level_ = i;
     }
+
+    // 分岐点の局面。
+    split_st_table_.reset(new BasicStruct[MAX_PLYS + 1]);
+
+#if defined(SAYURI_COPY_MAKE)
+    // Copy-Make用の局面のテーブル。
+    state_table_.reset(new BoardState[MAX_PLYS + 1]);
+#endif
+
+    // 手の並び替え用テーブル。
+    order_st_ptr_.reset(new OrderStruct());
+    order_st_ptr_->Clear();
   }
 
   // コピーコンストラクタ。
   ChessEngine::ChessEngine(const ChessEngine& engine) :
   is_null_searching_(false),
   evaluator_(*this),
-  notice_cut_level_(MAX_PLYS + 1) {
+  notice_cut_level_(MAX_PLYS + 1),
+  thread_id_(0),
+  next_node_check_(0) {
     // 基本メンバをコピー。
     basic_st_ = engine.basic_st_;
 
@@ -139,13 +169,27 @@ namespace Sayuri {
       job_table_[i].client_ptr_ = this;
       job_table_[i].level_ = i;
     }
+
+    // 分岐点の局面。
+    split_st_table_.reset(new BasicStruct[MAX_PLYS + 1]);
+
+#if defined(SAYURI_COPY_MAKE)
+    // Copy-Make用の局面のテーブル。
+    state_table_.reset(new BoardState[MAX_PLYS + 1]);
+#endif
+
+    // 手の並び替え用テーブル。
+    order_st_ptr_.reset(new OrderStruct());
+    order_st_ptr_->Clear();
   }
 
   // ムーブコンストラクタ。
   ChessEngine::ChessEngine(ChessEngine&& engine) :
   is_null_searching_(false),
   evaluator_(*this),
-  notice_cut_level_(MAX_PLYS + 1)  {
+  notice_cut_level_(MAX_PLYS + 1),
+  thread_id_(0),
+  next_node_check_(0) {
     // 基本メンバをコピー。
     basic_st_ = engine.basic_st_;
 
@@ -167,6 +211,18 @@ namespace Sayuri {
       job_table_[i].client_ptr_ = this;
       job_table_[i].level_ = i;
     }
+
+    // 分岐点の局面。
+    split_st_table_.reset(new BasicStruct[MAX_PLYS + 1]);
+
+#if defined(SAYURI_COPY_MAKE)
+    // Copy-Make用の局面のテーブル。
+    state_table_.reset(new BoardState[MAX_PLYS + 1]);
+#endif
+
+    // 手の並び替え用テーブル。
+    order_st_ptr_.reset(new OrderStruct());
+    order_st_ptr_->Clear();
   }
 
   // コピー代入演算子。
@@ -217,7 +273,7 @@ namespace Sayuri {
       basic_st_.piece_board_[square] = EMPTY;
       basic_st_.side_board_[square] = NO_SIDE;
     }
-    INIT_ARRAY(basic_st_.blocker_);
+    basic_st_.blocker_ = 0;
 
     // 駒を配置する。
     for (Side side = WHITE; side <= BLACK; ++side) {
@@ -230,11 +286,8 @@ namespace Sayuri {
           Square square = Util::GetSquare(bb);
           basic_st_.side_board_[square] = side;
           basic_st_.piece_board_[square] = piece_type;
-          basic_st_.side_pieces_[side] |= Util::SQUARE[square][R0];
-          basic_st_.blocker_[R0] |= Util::SQUARE[square][R0];
-          basic_st_.blocker_[R45] |= Util::SQUARE[square][R45];
-          basic_st_.blocker_[R90] |= Util::SQUARE[square][R90];
-          basic_st_.blocker_[R135] |= Util::SQUARE[square][R135];
+          basic_st_.side_pieces_[side] |= Util::SQUARE[square];
+          basic_st_.blocker_ |= Util::SQUARE[square];
           if (piece_type == KING) {
             basic_st_.king_[side] = square;
           }
@@ -249,14 +302,17 @@ namespace Sayuri {
     basic_st_.clock_ = fen.clock();
     basic_st_.ply_ = fen.ply();
 
+    // キャスリングの権利を更新。
+    UpdateCastlingRights();
+
+    // ハッシュを計算する。
+    CalHashes();
+
     // 履歴を設定。
     shared_st_ptr_->clock_history_.clear();
     shared_st_ptr_->clock_history_.push_back(basic_st_.clock_);
     shared_st_ptr_->position_history_.clear();
     shared_st_ptr_->position_history_.push_back(PositionRecord(*this));
-
-    // キャスリングの権利を更新。
-    UpdateCastlingRights();
   }
 
   // PositionRecordから局面読み込む。
@@ -264,6 +320,9 @@ namespace Sayuri {
     Board& this_base = basic_st_;
     this_base = record;
     COPY_ARRAY(basic_st_.position_memo_, record.position_memo_);
+
+    // ハッシュを計算し直す。
+    CalHashes();
   }
 
   // 駒を初期配置にセットする。
@@ -274,20 +333,20 @@ namespace Sayuri {
       {
         0,
         Util::RANK[RANK_2],
-        Util::SQUARE[B1][R0] | Util::SQUARE[G1][R0],
-        Util::SQUARE[C1][R0] | Util::SQUARE[F1][R0],
-        Util::SQUARE[A1][R0] | Util::SQUARE[H1][R0],
-        Util::SQUARE[D1][R0],
-        Util::SQUARE[E1][R0]
+        Util::SQUARE[B1] | Util::SQUARE[G1],
+        Util::SQUARE[C1] | Util::SQUARE[F1],
+        Util::SQUARE[A1] | Util::SQUARE[H1],
+        Util::SQUARE[D1],
+        Util::SQUARE[E1]
       },
       {
         0,
         Util::RANK[RANK_7],
-        Util::SQUARE[B8][R0] | Util::SQUARE[G8][R0],
-        Util::SQUARE[C8][R0] | Util::SQUARE[F8][R0],
-        Util::SQUARE[A8][R0] | Util::SQUARE[H8][R0],
-        Util::SQUARE[D8][R0],
-        Util::SQUARE[E8][R0]
+        Util::SQUARE[B8] | Util::SQUARE[G8],
+        Util::SQUARE[C8] | Util::SQUARE[F8],
+        Util::SQUARE[A8] | Util::SQUARE[H8],
+        Util::SQUARE[D8],
+        Util::SQUARE[E8]
       }
     };
     COPY_ARRAY(basic_st_.position_, STARTING_POSITION);
@@ -298,18 +357,8 @@ namespace Sayuri {
     basic_st_.side_pieces_[BLACK] = Util::RANK[RANK_8] | Util::RANK[RANK_7];
 
     // ブロッカーのビットボードを作る。
-    basic_st_.blocker_[R0] = Util::RANK[RANK_1] | Util::RANK[RANK_2]
+    basic_st_.blocker_ = Util::RANK[RANK_1] | Util::RANK[RANK_2]
     | Util::RANK[RANK_8] | Util::RANK[RANK_7];
-    basic_st_.blocker_[R45] = 0;
-    basic_st_.blocker_[R90] = 0;
-    basic_st_.blocker_[R135] = 0;
-    for (Bitboard bb = basic_st_.blocker_[R0]; bb; NEXT_BITBOARD(bb)) {
-      Square square = Util::GetSquare(bb);
-
-      basic_st_.blocker_[R45] |= Util::SQUARE[square][R45];
-      basic_st_.blocker_[R90] |= Util::SQUARE[square][R90];
-      basic_st_.blocker_[R135] |= Util::SQUARE[square][R135];
-    }
 
     // 駒の種類とサイドの配置を作る。
     constexpr static const PieceType STARTING_PIECE_BOARD[NUM_SQUARES] {
@@ -363,7 +412,19 @@ namespace Sayuri {
     // 駒の配置のメモを初期化。
     INIT_ARRAY(basic_st_.position_memo_);
 
+    // ハッシュを初期化。 (共有メンバがあれば計算し直す。)
+    basic_st_.pos_hash_ = 0;
+    basic_st_.pawn_hash_ = 0;
+    basic_st_.material_hash_ = 0;
+
+    // 駒の配置の価値の合計を初期化。 (探索開始時に計算し直す。)
+    INIT_ARRAY(basic_st_.opening_position_sum_);
+    INIT_ARRAY(basic_st_.ending_position_sum_);
+
     if (shared_st_ptr_) {
+      // ハッシュを計算する。
+      CalHashes();
+
       // 50手ルールの履歴を初期化。
       shared_st_ptr_->clock_history_.clear();
       shared_st_ptr_->clock_history_.push_back(0);
@@ -383,15 +444,27 @@ namespace Sayuri {
     const SearchParams* temp_sp_ptr = nullptr;
     const EvalParams* temp_ep_ptr = nullptr;
     TranspositionTable* temp_table_ptr = nullptr;
+    Hash temp_seed = UCI_DEFAULT_HASH_KEY_SEED;
+    std::size_t temp_eval_table_size = UCI_DEFAULT_EVAL_TABLE_SIZE;
     if (shared_st_ptr_) {
       temp_sp_ptr = shared_st_ptr_->search_params_ptr_;  // 一時待避。
       temp_ep_ptr = shared_st_ptr_->eval_params_ptr_;  // 一時待避。
       temp_table_ptr = shared_st_ptr_->table_ptr_;  // 一時待避。
+      temp_seed = shared_st_ptr_->hash_key_seed_;  // 一時待避。
+      temp_eval_table_size = shared_st_ptr_->eval_table_size_;  // 一時待避。
     }
     shared_st_ptr_.reset(new SharedStruct());
     shared_st_ptr_->search_params_ptr_ = temp_sp_ptr;  // 復帰。
     shared_st_ptr_->eval_params_ptr_ = temp_ep_ptr;  // 復帰。
     shared_st_ptr_->table_ptr_ = temp_table_ptr; // 復帰。
+    shared_st_ptr_->eval_table_size_ = temp_eval_table_size;  // 復帰。
+    if (temp_seed != shared_st_ptr_->hash_key_seed_) {
+      shared_st_ptr_->hash_key_seed_ = temp_seed;  // 復帰。
+      shared_st_ptr_->InitHashValueTable();
+    }
+
+    // ハッシュを計算する。
+    CalHashes();
 
     // 50手ルールの履歴を初期化。
     shared_st_ptr_->clock_history_.push_back(0);
@@ -400,13 +473,70 @@ namespace Sayuri {
     shared_st_ptr_->position_history_.push_back(PositionRecord(*this));
   }
 
+  // 局面のハッシュ値を生成する種を設定する。
+  void ChessEngine::SetHashKeySeed(Hash seed) {
+    shared_st_ptr_->hash_key_seed_ = seed;
+    shared_st_ptr_->InitHashValueTable();
+
+    // 局面のハッシュも新しいテーブルで計算し直す。
+    CalHashes();
+
+    // 千日手の判定に使うので、記録した局面のハッシュも計算し直す。
+    for (auto& record : shared_st_ptr_->position_history_) {
+      record.pos_hash_ = CalPosHash(record);
+    }
+
+    // 古いハッシュ値のエントリーは使えない。
+    if (shared_st_ptr_->table_ptr_) shared_st_ptr_->table_ptr_->Clear();
+  }
+
+  // 評価値のハッシュテーブルのサイズを設定する。
+  void ChessEngine::SetEvalTableSize(std::size_t table_size) {
+    Util::UpdateMin(table_size, UCI_MAX_EVAL_TABLE_SIZE);
+    shared_st_ptr_->eval_table_size_ = table_size;
+  }
+
   // 探索を開始する。
-  PVLine ChessEngine::Calculate(int num_threads,
+  PVLine ChessEngine::Calculate(int num_threads, bool enable_lazy_smp,
   const std::vector<Move>& moves_to_search, UCIShell& shell) {
+    // 探索中はスレッドのプールを作り直させない。
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+
+    PrepareThreads(num_threads);
+    shared_st_ptr_->enable_lazy_smp_ = enable_lazy_smp;
+    return SearchRoot(moves_to_search, shell);
+  }
+
+  // 探索用スレッドを準備する。
+  void ChessEngine::SetNumThreads(int num_threads) {
+    // 探索中ならCalculate()に任せる。
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);  // ロック。
+    if (!(lock.owns_lock())) return;
+
+    PrepareThreads(num_threads);
+  }
+
+  // 子エンジンとスレッドのプールを準備する。
+  void ChessEngine::PrepareThreads(int num_threads) {
     Util::UpdateMax(num_threads, 1);
     Util::UpdateMin(num_threads, UCI_MAX_THREADS);
-    thread_vec_.resize(num_threads);
-    return SearchRoot(moves_to_search, shell);
+
+    // 数が同じなら使い回す。
+    if (thread_pool_ptr_
+    && (child_vec_.size() == static_cast<std::size_t>(num_threads))) {
+      return;
+    }
+
+    // 先に古いスレッドを終了させてから子エンジンを作り直す。
+    thread_pool_ptr_.reset();
+    child_vec_.clear();
+    for (int i = 0; i < num_threads; ++i) {
+      child_vec_.push_back
+      (std::unique_ptr<ChessEngine>(new ChessEngine(*this)));
+    }
+
+    // 子エンジン毎に1つと、定期処理用に1つ。
+    thread_pool_ptr_.reset(new ThreadPool(num_threads + 1));
   }
 
   // 探索を終了させる。
@@ -416,69 +546,149 @@ namespace Sayuri {
 
   // 合法手かどうか判定。
   bool ChessEngine::IsLegalMove(Move& move) const {
-    // 合法手かどうか調べる。
-    // 手を展開する。
-    shared_st_ptr_->history_max_ = 1;  // makerが0の除算をしないように。
+    // 手を展開する。 (合法手だけ。)
     MoveMaker maker(*this);
-    maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
-
-    // 合法手かどうか調べる。
-    ChessEngine* self = const_cast<ChessEngine*>(this);
-    bool is_legal = false;
-    Side side = basic_st_.to_move_;
-    Side enemy_side = Util::GetOppositeSide(side);
-    for (Move temp_move = maker.PickMove(); temp_move;
-    temp_move = maker.PickMove()) {
-      self->MakeMove(temp_move);
-      // temp_moveが合法手かどうか調べる。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        self->UnmakeMove(temp_move);
-        continue;
-      }
+    maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0, 0);
 
-      // temp_moveと同じ手かどうか調べる。
+    // 同じ手があるかどうか調べる。
+    for (Move temp_move = maker.PopMove(); temp_move;
+    temp_move = maker.PopMove()) {
       if (EqualMove(move, temp_move)) {
-        self->UnmakeMove(temp_move);
         move = temp_move;
-        is_legal = true;
-        break;
+        return true;
       }
-      self->UnmakeMove(temp_move);
     }
 
-    return is_legal;
+    return false;
   }
 
   // 合法手のベクトルを得る。
   std::vector<Move> ChessEngine::GetLegalMoves() const {
-    // 手を展開する。
-    shared_st_ptr_->history_max_ = 1;  // makerが0の除算をしないように。
+    // 手を展開する。 (合法手だけ。)
     MoveMaker maker(*this);
-    maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
+    maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0, 0);
 
-    // 合法手かどうか調べながらベクトルに格納していく。
-    ChessEngine* self = const_cast<ChessEngine*>(this);
+    // 点数順にベクトルに格納していく。
     std::vector<Move> ret_vec;
-    Side side = basic_st_.to_move_;
-    Side enemy_side = Util::GetOppositeSide(side);
     for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
-      self->MakeMove(move);
+      ret_vec.push_back(move);
+    }
+
+    return ret_vec;
+  }
+
+  // Perft。
+  std::vector<std::pair<Move, u64>> ChessEngine::Perft(int depth,
+  int num_threads, std::size_t hash_size) {
+    std::vector<std::pair<Move, u64>> ret_vec;
+    Util::UpdateMin(depth, static_cast<int>(MAX_PLYS));
+    if (depth <= 0) return ret_vec;
+    Util::UpdateMin(hash_size, UCI_MAX_TABLE_SIZE);
+
+    // ルートの合法手を格納する。
+    for (auto move : GetLegalMoves()) {
+      ret_vec.push_back(std::pair<Move, u64>(move, 0));
+    }
 
-      // 動かした結果、チェックされているかどうか。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        // チェックされていれば違法。
-        self->UnmakeMove(move);
-        continue;
+    // 探索中はスレッドのプールを作り直させない。
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    PrepareThreads(num_threads);
+
+    // GetNextHash()はキャッシュのハッシュ値のテーブルを使う。
+    shared_st_ptr_->CacheParams();
+
+    // ハッシュテーブルを準備する。 エントリーの数は2の累乗にする。
+    std::unique_ptr<PerftEntry[]> table;
+    Hash table_mask = 0;
+    std::size_t num_entries = hash_size / sizeof(PerftEntry);
+    if (num_entries) {
+      std::size_t table_size = 1;
+      while ((table_size << 1) <= num_entries) table_size <<= 1;
+
+      table.reset(new PerftEntry[table_size]);
+      for (std::size_t i = 0; i < table_size; ++i) {
+        table[i].key_.store(0, std::memory_order_relaxed);
+        table[i].data_.store(0, std::memory_order_relaxed);
       }
+      table_mask = table_size - 1;
+    }
+    PerftEntry* table_ptr = table.get();
+
+    // 子エンジンがアトミックなカウンターでルートの合法手を取り合う。
+    Hash pos_hash = GetCurrentHash();
+    std::atomic<std::size_t> next_index(0);
+    for (unsigned int i = 0; i < child_vec_.size(); ++i) {
+      ChessEngine* child_ptr = child_vec_[i].get();
+      child_ptr->basic_st_ = basic_st_;
+      child_ptr->shared_st_ptr_ = shared_st_ptr_;
+
+      thread_pool_ptr_->Run(i, [child_ptr, depth, pos_hash, table_ptr,
+      table_mask, &ret_vec, &next_index]() {
+        for (std::size_t index = next_index++; index < ret_vec.size();
+        index = next_index++) {
+          Move move = ret_vec[index].first;
+          if (depth <= 1) {
+            ret_vec[index].second = 1;
+            continue;
+          }
 
-      // 合法手。
-      ret_vec.push_back(move);
-      self->UnmakeMove(move);
+          Hash next_hash = table_ptr ?
+          child_ptr->GetNextHash(pos_hash, move) : 0;
+          child_ptr->MakeMoveOnLevel(move, 0);
+          ret_vec[index].second = child_ptr->PerftCore(depth - 1, 1,
+          next_hash, table_ptr, table_mask);
+          child_ptr->UnmakeMoveOnLevel(move, 0);
+        }
+      });
     }
+    thread_pool_ptr_->WaitForAll();
 
     return ret_vec;
   }
 
+  // Perftの本体。
+  u64 ChessEngine::PerftCore(int depth, u32 level, Hash pos_hash,
+  PerftEntry* table, Hash table_mask) {
+    // ハッシュテーブルを調べる。
+    // キーはdata_と排他的論理和をとってあるので、
+    // 他のスレッドに書き換えられ途中のエントリーは一致しない。
+    PerftEntry* entry_ptr = nullptr;
+    if (table && (depth >= 2)) {
+      entry_ptr = &(table[pos_hash & table_mask]);
+      u64 data = entry_ptr->data_.load(std::memory_order_relaxed);
+      if (((entry_ptr->key_.load(std::memory_order_relaxed) ^ data)
+      == pos_hash) && (static_cast<int>(data & 0xff) == depth)) {
+        return data >> 8;
+      }
+    }
+
+    // 手を展開する。 (合法手だけ。)
+    // 深さ1なら、その先の局面は展開せずに合法手の数を返す。
+    MoveMaker& maker = maker_table_[level];
+    int num_moves = maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0, 0);
+    if (depth <= 1) return num_moves;
+
+    // 順番は関係ないので点数はつけない。
+    u64 num_nodes = 0;
+    for (Move move = maker.PopMove(); move; move = maker.PopMove()) {
+      Hash next_hash = (entry_ptr && (depth >= 3)) ?
+      GetNextHash(pos_hash, move) : 0;
+      MakeMoveOnLevel(move, level);
+      num_nodes +=
+      PerftCore(depth - 1, level + 1, next_hash, table, table_mask);
+      UnmakeMoveOnLevel(move, level);
+    }
+
+    // ハッシュテーブルに記録する。
+    if (entry_ptr) {
+      u64 data = (num_nodes << 8) | depth;
+      entry_ptr->key_.store(pos_hash ^ data, std::memory_order_relaxed);
+      entry_ptr->data_.store(data, std::memory_order_relaxed);
+    }
+
+    return num_nodes;
+  }
+
   // Algebraic Notetionの指し手を予測する。
   std::vector<Move> ChessEngine::GuessNote(const std::string& note) const {
     // パース。
@@ -771,7 +981,9 @@ namespace Sayuri {
     PutPiece(square, piece_type, piece_side);
 
     // キャスリングの権利を更新。
+    basic_st_.pos_hash_ ^= GetStateHash();
     UpdateCastlingRights();
+    basic_st_.pos_hash_ ^= GetStateHash();
   }
 
   // 手を指す。
@@ -784,9 +996,10 @@ namespace Sayuri {
       } else {
         ++(basic_st_.clock_);
       }
+      // MakeMove()で戻すための情報を記録した手を履歴に残す。
+      MakeMove(move);
       shared_st_ptr_->move_history_.push_back(move);
       shared_st_ptr_->clock_history_.push_back(basic_st_.clock_);
-      MakeMove(move);
       shared_st_ptr_->position_history_.push_back(PositionRecord(*this));
 
       return true;
@@ -866,11 +1079,26 @@ namespace Sayuri {
     // 置く位置の現在の駒のサイドを得る。
     Side placed_side = basic_st_.side_board_[square];
 
+    const Cache& cache = shared_st_ptr_->cache_;
+
     // 置く位置のメンバを消す。
     if (placed_piece) {
       basic_st_.position_[placed_side][placed_piece] &=
-      ~Util::SQUARE[square][R0];
-      basic_st_.side_pieces_[placed_side] &= ~Util::SQUARE[square][R0];
+      ~Util::SQUARE[square];
+      basic_st_.side_pieces_[placed_side] &= ~Util::SQUARE[square];
+      basic_st_.pos_hash_ ^= shared_st_ptr_->piece_hash_value_table_
+      [placed_side][placed_piece][square];
+      basic_st_.material_hash_ ^= shared_st_ptr_->material_hash_value_table_
+      [placed_side][placed_piece]
+      [Util::CountBits(basic_st_.position_[placed_side][placed_piece])];
+      if (placed_piece == PAWN) {
+        basic_st_.pawn_hash_ ^=
+        shared_st_ptr_->piece_hash_value_table_[placed_side][PAWN][square];
+      }
+      basic_st_.opening_position_sum_[placed_piece] -=
+      cache.opening_position_value_[placed_side][placed_piece][square];
+      basic_st_.ending_position_sum_[placed_piece] -=
+      cache.ending_position_value_[placed_side][placed_piece][square];
     }
 
     // 置く駒がEMPTYか置くサイドがNO_SIDEなら
@@ -879,10 +1107,7 @@ namespace Sayuri {
       basic_st_.piece_board_[square] = EMPTY;
       basic_st_.side_board_[square] = NO_SIDE;
       if (placed_piece) {
-        basic_st_.blocker_[R0] &= ~Util::SQUARE[square][R0];
-        basic_st_.blocker_[R45] &= ~Util::SQUARE[square][R45];
-        basic_st_.blocker_[R90] &= ~Util::SQUARE[square][R90];
-        basic_st_.blocker_[R135] &= ~Util::SQUARE[square][R135];
+        basic_st_.blocker_ &= ~Util::SQUARE[square];
       }
       return;
     }
@@ -892,13 +1117,28 @@ namespace Sayuri {
     // 置く位置のサイドを書き変える。
     basic_st_.side_board_[square] = side;
 
+    // 局面と駒の数のハッシュを更新する。
+    basic_st_.pos_hash_ ^=
+    shared_st_ptr_->piece_hash_value_table_[side][piece_type][square];
+    basic_st_.material_hash_ ^= shared_st_ptr_->material_hash_value_table_
+    [side][piece_type][Util::CountBits(basic_st_.position_[side][piece_type])];
+
+    // ポーンの配置のハッシュを更新する。
+    if (piece_type == PAWN) {
+      basic_st_.pawn_hash_ ^=
+      shared_st_ptr_->piece_hash_value_table_[side][PAWN][square];
+    }
+
+    // 駒の配置の価値の合計を更新する。
+    basic_st_.opening_position_sum_[piece_type] +=
+    cache.opening_position_value_[side][piece_type][square];
+    basic_st_.ending_position_sum_[piece_type] +=
+    cache.ending_position_value_[side][piece_type][square];
+
     // 置く位置のビットボードをセットする。
-    basic_st_.position_[side][piece_type] |= Util::SQUARE[square][R0];
-    basic_st_.side_pieces_[side] |= Util::SQUARE[square][R0];
-    basic_st_.blocker_[R0] |= Util::SQUARE[square][R0];
-    basic_st_.blocker_[R45] |= Util::SQUARE[square][R45];
-    basic_st_.blocker_[R90] |= Util::SQUARE[square][R90];
-    basic_st_.blocker_[R135] |= Util::SQUARE[square][R135];
+    basic_st_.position_[side][piece_type] |= Util::SQUARE[square];
+    basic_st_.side_pieces_[side] |= Util::SQUARE[square];
+    basic_st_.blocker_ |= Util::SQUARE[square];
 
     // キングの位置を更新する。
     if (piece_type == KING) {
@@ -911,6 +1151,9 @@ namespace Sayuri {
     // 動かす側のサイドを得る。
     Side side = basic_st_.to_move_;
 
+    // 手番、キャスリングの権利、アンパッサンのハッシュを一旦消す。
+    basic_st_.pos_hash_ ^= GetStateHash();
+
     // 手番を反転させる。
     basic_st_.to_move_ = Util::GetOppositeSide(basic_st_.to_move_);
 
@@ -983,6 +1226,9 @@ namespace Sayuri {
 
     // キャスリングの権利をアップデート。
     UpdateCastlingRights();
+
+    // 新しい手番、キャスリングの権利、アンパッサンのハッシュを加える。
+    basic_st_.pos_hash_ ^= GetStateHash();
   }
 
   // MakeMove()で動かした手を元に戻す。
@@ -990,6 +1236,9 @@ namespace Sayuri {
     // 相手のサイドを得る。
     Side enemy_side = basic_st_.to_move_;
 
+    // 手番、キャスリングの権利、アンパッサンのハッシュを一旦消す。
+    basic_st_.pos_hash_ ^= GetStateHash();
+
     // 手番を反転させる。
     basic_st_.to_move_ = Util::GetOppositeSide(basic_st_.to_move_);
 
@@ -1040,6 +1289,9 @@ namespace Sayuri {
         basic_st_.has_castled_[BLACK] = false;
         break;
     }
+
+    // 元の手番、キャスリングの権利、アンパッサンのハッシュを加える。
+    basic_st_.pos_hash_ ^= GetStateHash();
   }
 
   // その位置が他の位置の駒に攻撃されているかどうかチェックする。
@@ -1085,28 +1337,68 @@ namespace Sayuri {
     return material;
   }
 
-  // 現在の局面のハッシュを計算する。
-  Hash ChessEngine::GetCurrentHash() const {
-    Hash hash = 0;
+  // 現在の局面から各ハッシュを計算し直す。
+  void ChessEngine::CalHashes() {
+    const SharedStruct& shared_st = *shared_st_ptr_;
+
+    // 局面のハッシュ。
+    basic_st_.pos_hash_ = CalPosHash(basic_st_);
+
+    // ポーンの配置のハッシュ。
+    basic_st_.pawn_hash_ = 0;
+    for (Side side = WHITE; side <= BLACK; ++side) {
+      for (Bitboard bb = basic_st_.position_[side][PAWN]; bb;
+      NEXT_BITBOARD(bb)) {
+        basic_st_.pawn_hash_ ^=
+        shared_st.piece_hash_value_table_[side][PAWN][Util::GetSquare(bb)];
+      }
+    }
+
+    // 駒の数のハッシュ。
+    basic_st_.material_hash_ = 0;
+    for (Side side = WHITE; side <= BLACK; ++side) {
+      for (PieceType piece_type = PAWN; piece_type <= KING; ++piece_type) {
+        int num_pieces =
+        Util::CountBits(basic_st_.position_[side][piece_type]);
+        for (int i = 0; i < num_pieces; ++i) {
+          basic_st_.material_hash_ ^=
+          shared_st.material_hash_value_table_[side][piece_type][i];
+        }
+      }
+    }
+  }
+
+  // ボードから局面のハッシュを計算する。
+  Hash ChessEngine::CalPosHash(const Board& board) const {
+    const SharedStruct& shared_st = *shared_st_ptr_;
 
     // 駒の情報からハッシュを得る。
+    Hash pos_hash = 0;
     FOR_SQUARES(square) {
-      hash ^= shared_st_ptr_->piece_hash_value_table_
-      [basic_st_.side_board_[square]][basic_st_.piece_board_[square]][square];
+      pos_hash ^= shared_st.piece_hash_value_table_
+      [board.side_board_[square]][board.piece_board_[square]][square];
     }
 
-    // 手番からハッシュを得る。
-    hash ^= shared_st_ptr_->to_move_hash_value_table_[basic_st_.to_move_];
-
-    // キャスリングの権利からハッシュを得る。
-    hash ^= shared_st_ptr_->castling_hash_value_table_
-    [basic_st_.castling_rights_];
+    // 手番、キャスリングの権利、アンパッサンからハッシュを得る。
+    return pos_hash ^ shared_st.to_move_hash_value_table_[board.to_move_]
+    ^ shared_st.castling_hash_value_table_[board.castling_rights_]
+    ^ shared_st.en_passant_hash_value_table_[board.en_passant_square_];
+  }
 
-    // アンパッサンからハッシュを得る。
-    hash ^= shared_st_ptr_->en_passant_hash_value_table_
-    [basic_st_.en_passant_square_];
+  // 現在の局面から駒の配置の価値の合計を計算し直す。
+  void ChessEngine::CalPositionSums() {
+    const Cache& cache = shared_st_ptr_->cache_;
 
-    return hash;
+    INIT_ARRAY(basic_st_.opening_position_sum_);
+    INIT_ARRAY(basic_st_.ending_position_sum_);
+    FOR_SQUARES(square) {
+      PieceType piece_type = basic_st_.piece_board_[square];
+      Side side = basic_st_.side_board_[square];
+      basic_st_.opening_position_sum_[piece_type] +=
+      cache.opening_position_value_[side][piece_type][square];
+      basic_st_.ending_position_sum_[piece_type] +=
+      cache.ending_position_value_[side][piece_type][square];
+    }
   }
 
   // 次の局面のハッシュを得る。
@@ -1130,6 +1422,7 @@ namespace Sayuri {
       case EN_PASSANT:  // アンパッサン。
         {
           target_type = PAWN;
+          target_side = Util::GetOppositeSide(piece_side);
           target_square = Util::EN_PASSANT_TRANS_TABLE[to];
         }
         break;
@@ -1200,6 +1493,15 @@ namespace Sayuri {
           }
       }
 
+      // 初期位置のルークを取った時も、相手のキャスリングの権利が消える。
+      // (UpdateCastlingRights()と同じ結果にする。)
+      switch (to) {
+        case H1: next_rights &= ~WHITE_SHORT_CASTLING; break;
+        case A1: next_rights &= ~WHITE_LONG_CASTLING; break;
+        case H8: next_rights &= ~BLACK_SHORT_CASTLING; break;
+        case A8: next_rights &= ~BLACK_LONG_CASTLING; break;
+      }
+
       // 現在のキャスリングのハッシュを消す。
       current_hash ^= cache.castling_hash_value_table_
       [basic_st_.castling_rights_];
@@ -1222,14 +1524,28 @@ namespace Sayuri {
     return current_hash;
   }
 
+  // ============================== //
+  // 手の並び替え用テーブルの構造体 //
+  // ============================== //
+  // 全てのテーブルを0にする。
+  void ChessEngine::OrderStruct::Clear() {
+    INIT_ARRAY(history_);
+    history_max_ = 1;  // makerが0の除算をしないように。
+    INIT_ARRAY(iid_stack_);
+    INIT_ARRAY(killer_stack_);
+    INIT_ARRAY(counter_move_);
+    INIT_ARRAY(cont_history_);
+    INIT_ARRAY(current_move_stack_);
+  }
+
   // ================ //
   // 共有メンバ構造体 //
   // ================ //
   // コンストラクタ。
   ChessEngine::SharedStruct::SharedStruct() :
-  history_max_(1),
   i_depth_(1),
-  searched_nodes_(0),
+  remaining_nodes_(ULLONG_MAX),
+  num_threads_(1),
   searched_level_(0),
   stop_now_(false),
   max_nodes_(ULLONG_MAX),
@@ -1237,27 +1553,16 @@ namespace Sayuri {
   end_time_(Chrono::milliseconds(INT_MAX)),
   is_time_over_(false),
   infinite_thinking_(false),
+  enable_lazy_smp_(UCI_DEFAULT_LAZY_SMP),
+  eval_table_size_(UCI_DEFAULT_EVAL_TABLE_SIZE),
   move_history_(0),
   clock_history_(0),
   position_history_(0),
   search_params_ptr_(nullptr),
   eval_params_ptr_(nullptr),
-  table_ptr_(nullptr) {
-    // volatileは 'void*' にできない。
-    FOR_SIDES(side) {
-      FOR_SQUARES(from) {
-        FOR_SQUARES(to) {
-          history_[side][from][to] = 0;
-        }
-      }
-    }
-    for (unsigned int i = 0; i < (MAX_PLYS + 1); ++i) {
-      iid_stack_[i] = 0;
-      killer_stack_[i][0] = 0;
-      killer_stack_[i][1] = 0;
-      killer_stack_[i + 2][0] = 0;
-      killer_stack_[i + 2][1] = 0;
-    }
+  table_ptr_(nullptr),
+  hash_key_seed_(UCI_DEFAULT_HASH_KEY_SEED) {
+    ResetNodes();
     helper_queue_ptr_.reset(new HelperQueue());
     InitHashValueTable();
   }
@@ -1288,24 +1593,14 @@ namespace Sayuri {
 
   // メンバをコピーする。
   void ChessEngine::SharedStruct::ScanMember(const SharedStruct& shared_st) {
-    // volatileは 'void*' にできない。
-    FOR_SIDES(side) {
-      FOR_SQUARES(from) {
-        FOR_SQUARES(to) {
-          history_[side][from][to] = shared_st.history_[side][from][to];
-        }
-      }
-    }
-    for (unsigned int i = 0; i < (MAX_PLYS + 1); ++i) {
-      iid_stack_[i] = shared_st.iid_stack_[i];
-      killer_stack_[i][0] = shared_st.killer_stack_[i][0];
-      killer_stack_[i][1] = shared_st.killer_stack_[i][1];
-      killer_stack_[i + 2][0] = shared_st.killer_stack_[i + 2][0];
-      killer_stack_[i + 2][1] = shared_st.killer_stack_[i + 2][1];
-    }
-
     i_depth_ = shared_st.i_depth_;
-    searched_nodes_ = shared_st.searched_nodes_;
+    for (unsigned int i = 0; i < (UCI_MAX_THREADS + 1); ++i) {
+      node_counter_table_[i].nodes_.store(shared_st.node_counter_table_[i]
+      .nodes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    remaining_nodes_.store(shared_st.remaining_nodes_
+    .load(std::memory_order_relaxed), std::memory_order_relaxed);
+    num_threads_ = shared_st.num_threads_;
     searched_level_ = shared_st.searched_level_;
     start_time_ = shared_st.start_time_;
     stop_now_ = shared_st.stop_now_;
@@ -1314,6 +1609,8 @@ namespace Sayuri {
     end_time_ = shared_st.end_time_;
     is_time_over_ = shared_st.is_time_over_;
     infinite_thinking_ = shared_st.infinite_thinking_;
+    enable_lazy_smp_ = shared_st.enable_lazy_smp_;
+    eval_table_size_ = shared_st.eval_table_size_;
     move_history_ = shared_st.move_history_;
     clock_history_ = shared_st.clock_history_;
     position_history_ = shared_st.position_history_;
@@ -1323,6 +1620,7 @@ namespace Sayuri {
     table_ptr_ = shared_st.table_ptr_;
 
     // ハッシュ関連。
+    hash_key_seed_ = shared_st.hash_key_seed_;
     COPY_ARRAY(piece_hash_value_table_, shared_st.piece_hash_value_table_);
 
     COPY_ARRAY(to_move_hash_value_table_, shared_st.to_move_hash_value_table_);
@@ -1333,38 +1631,19 @@ namespace Sayuri {
     COPY_ARRAY(en_passant_hash_value_table_,
     shared_st.en_passant_hash_value_table_);
 
+    COPY_ARRAY(material_hash_value_table_,
+    shared_st.material_hash_value_table_);
+
     // キャッシュ。
     cache_ = shared_st.cache_;
   }
 
   // ハッシュ値のテーブルを初期化する。
   void ChessEngine::SharedStruct::InitHashValueTable() {
-    // ダブリのないハッシュを生成。
-    constexpr int LENGTH =
-    (NUM_SIDES * NUM_PIECE_TYPES * NUM_SQUARES) + 1 + 16 + NUM_SQUARES;
-    Hash temp_table[LENGTH];
+    // 種と通し番号からハッシュ値を計算する。
+    // (Util::GetHashKey()は番号が違えば必ず違う値を返すので、
+    // ダブリを調べる必要は無い。)
     int temp_count = 0;
-    for (int i = 0; i < LENGTH; ++i) {
-      // ダブリを調べる。
-      bool loop = true;
-      Hash hash = 0;
-      while (loop) {
-        hash = Util::GetRandomHash();
-        loop = false;
-        if (hash == 0) {
-          loop = true;
-          continue;
-        }
-        for (int j = 0; j < i; ++j) {
-          if (hash == temp_table[j]) {
-            loop = true;
-            break;
-          }
-        }
-      }
-
-      temp_table[i] = hash;
-    }
 
     // 駒の情報の配列を初期化。
     FOR_SIDES(side) {
@@ -1374,7 +1653,7 @@ namespace Sayuri {
             piece_hash_value_table_[side][piece_type][square] = 0;
           } else {
             piece_hash_value_table_[side][piece_type][square] =
-            temp_table[temp_count++];
+            Util::GetHashKey(hash_key_seed_, temp_count++);
           }
         }
       }
@@ -1383,17 +1662,34 @@ namespace Sayuri {
     // 手番の配列を初期化。
     to_move_hash_value_table_[NO_SIDE] = 0;
     to_move_hash_value_table_[WHITE] = 0;
-    to_move_hash_value_table_[BLACK] = temp_table[temp_count++];
+    to_move_hash_value_table_[BLACK] =
+    Util::GetHashKey(hash_key_seed_, temp_count++);
 
     // キャスリングの配列を初期化。
     for (int i = 0; i < 16; ++i) {
-      castling_hash_value_table_[i] = temp_table[temp_count++];
+      castling_hash_value_table_[i] =
+      Util::GetHashKey(hash_key_seed_, temp_count++);
     }
 
     // アンパッサンの配列を初期化。
     en_passant_hash_value_table_[0] = 0;
     for (Square square = 1; square < NUM_SQUARES; ++square) {
-      en_passant_hash_value_table_[square] = temp_table[temp_count++];
+      en_passant_hash_value_table_[square] =
+      Util::GetHashKey(hash_key_seed_, temp_count++);
+    }
+
+    // 駒の数の配列を初期化。
+    FOR_SIDES(side) {
+      FOR_PIECE_TYPES(piece_type) {
+        for (u32 i = 0; i < NUM_SQUARES; ++i) {
+          if ((side == NO_SIDE) || (piece_type == EMPTY)) {
+            material_hash_value_table_[side][piece_type][i] = 0;
+          } else {
+            material_hash_value_table_[side][piece_type][i] =
+            Util::GetHashKey(hash_key_seed_, temp_count++);
+          }
+        }
+      }
     }
   }
 
@@ -1404,7 +1700,12 @@ namespace Sayuri {
     TimePoint next_point = SysClock::now() + INTERVAL;
 
     while (!stop_now_) {
-      std::this_thread::sleep_for(SLEEP_TIME);
+      {
+        // 探索が終われば WakeUpPeriodicProcess() で起こされる。
+        std::unique_lock<std::mutex> lock(periodic_mutex_);  // ロック。
+        periodic_cond_.wait_for(lock, SLEEP_TIME,
+        [this]() {return this->stop_now_;});
+      }
       if (stop_now_) break;
 
       TimePoint now = SysClock::now();
@@ -1418,7 +1719,7 @@ namespace Sayuri {
       if (now >= next_point) {
         shell.PrintOtherInfo
         (Chrono::duration_cast<Chrono::milliseconds>(now - start_time_),
-        searched_nodes_, table_ptr_->GetUsedPermill());
+        CountNodes(), table_ptr_->GetUsedPermill());
         next_point = now + INTERVAL;
       }
       if (stop_now_) break;
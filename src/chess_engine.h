@@ -32,10 +32,12 @@
 
 #include <iostream>
 #include <vector>
+#include <utility>
 #include <memory>
 #include <array>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <climits>
@@ -47,6 +49,7 @@
 #include "helper_queue.h"
 #include "params.h"
 #include "cache.h"
+#include "thread_pool.h"
 
 /** Sayuri 名前空間。 */
 namespace Sayuri {
@@ -59,6 +62,7 @@ namespace Sayuri {
   class PositionRecord;
   class Job;
   class HelperQueue;
+  class ThreadPool;
   class SearchParams;
   class EvalParams;
 
@@ -141,6 +145,30 @@ namespace Sayuri {
       /** 新しいゲームの準備をする。 */
       void SetNewGame();
 
+      /**
+       * 局面のハッシュ値を生成する種を設定し、ハッシュ値のテーブルを作り直す。
+       * トランスポジションテーブルはクリアされる。
+       * 対局中の局面の履歴のハッシュ値は変わらないので、
+       * 対局を始める前(ucinewgameやpositionの前)に設定すること。
+       * @param seed 種。
+       */
+      void SetHashKeySeed(Hash seed);
+
+      /**
+       * 評価値のハッシュテーブルのサイズを設定する。 (スレッド毎)
+       * 次の探索の開始時に各スレッドのテーブルが作り直される。
+       * @param table_size テーブルのサイズ。 (バイト) 0なら使わない。
+       */
+      void SetEvalTableSize(std::size_t table_size);
+
+      /**
+       * 探索用スレッドを準備する。
+       * スレッドは次に数が変わるまで待機し、探索の度に使い回される。
+       * 探索中は何もしない。 (次の探索の開始時に準備される。)
+       * @param num_threads 探索用のスレッド数。
+       */
+      void SetNumThreads(int num_threads);
+
       /**
        * 探索のストップ条件を設定する。
        * @param max_depth 最大の探索深さ。
@@ -160,11 +188,12 @@ namespace Sayuri {
       /**
        * 探索を開始する。
        * @param num_threads 探索用のスレッド数。
+       * @param enable_lazy_smp trueならLazy SMP、falseならYBWCで並列探索する。
        * @param moves_to_search 探索する候補手。 空ならすべての候補手を探索。
        * @param shell Infoコマンドを出力するUCIShell。
        * @return 探索結果のPVライン。
        */
-      PVLine Calculate(int num_threads,
+      PVLine Calculate(int num_threads, bool enable_lazy_smp,
       const std::vector<Move>& moves_to_search, UCIShell& shell);
 
       /** 探索を終了させる。 */
@@ -197,6 +226,19 @@ namespace Sayuri {
        */
       std::vector<Move> GetLegalMoves() const;
 
+      /**
+       * Perft。 現在の局面から指定の深さまでの末端ノード数を数える。
+       * 深さ1の局面では末端ノードを作らずに合法手の数だけ数える。
+       * ルートの合法手は子エンジンのスレッドに分けて数える。
+       * @param depth 数える深さ。
+       * @param num_threads 使うスレッド数。
+       * @param hash_size 部分木のノード数を記録するハッシュテーブルの
+       * サイズ。 (バイト) 0ならハッシュテーブルを使わない。
+       * @return ルートの合法手と、その手以下の末端ノード数のペアのベクトル。
+       */
+      std::vector<std::pair<Move, u64>> Perft(int depth, int num_threads,
+      std::size_t hash_size);
+
       /**
        * 現在の局面からAlgebraic Notationの指し手を予測する。
        * @param note 予測するAlgebraic Notation。
@@ -267,8 +309,7 @@ namespace Sayuri {
        * @return ビショップの利き筋。
        */
       Bitboard GetBishopAttack(Square square) const {
-        return Util::GetBishopMagic(square, basic_st_.blocker_[R45],
-        basic_st_.blocker_[R135]);
+        return Util::GetBishopMagic(square, basic_st_.blocker_);
       }
       /**
        * ボードの状態からルークの利き筋を作る。
@@ -276,8 +317,7 @@ namespace Sayuri {
        * @return ルークの利き筋。
        */
       Bitboard GetRookAttack(Square square) const {
-        return Util::GetRookMagic(square, basic_st_.blocker_[R0],
-        basic_st_.blocker_[R90]);
+        return Util::GetRookMagic(square, basic_st_.blocker_);
       }
       /**
        * ボードの状態からクイーンの利き筋を作る。
@@ -285,9 +325,7 @@ namespace Sayuri {
        * @return クイーンの利き筋。
        */
       Bitboard GetQueenAttack(Square square) const {
-        return Util::GetQueenMagic
-        (square, basic_st_.blocker_[R0], basic_st_.blocker_[R45],
-        basic_st_.blocker_[R90], basic_st_.blocker_[R135]);
+        return Util::GetQueenMagic(square, basic_st_.blocker_);
       }
       /**
        * ボードの状態からポーンの動ける位置を作る。
@@ -296,7 +334,7 @@ namespace Sayuri {
        * @return ポーンの動ける位置。
        */
       Bitboard GetPawnStep(Side side, Square square) const {
-        return Util::GetPawnMovable(side, square, basic_st_.blocker_[R90]);
+        return Util::GetPawnMovable(side, square, basic_st_.blocker_);
       }
 
       /**
@@ -305,9 +343,9 @@ namespace Sayuri {
        */
       bool CanWhiteShortCastling() const {
         return (basic_st_.castling_rights_ & WHITE_SHORT_CASTLING)
-        && !((basic_st_.blocker_[R0]
-        & (Util::SQUARE[F1][R0]
-        | Util::SQUARE[G1][R0]))
+        && !((basic_st_.blocker_
+        & (Util::SQUARE[F1]
+        | Util::SQUARE[G1]))
         || IsAttacked(E1, BLACK)
         || IsAttacked(F1, BLACK)
         || IsAttacked(G1, BLACK));
@@ -319,10 +357,10 @@ namespace Sayuri {
        */
       bool CanWhiteLongCastling() const {
         return (basic_st_.castling_rights_ & WHITE_LONG_CASTLING)
-        && !((basic_st_.blocker_[R0]
-        & (Util::SQUARE[D1][R0]
-        | Util::SQUARE[C1][R0]
-        | Util::SQUARE[B1][R0]))
+        && !((basic_st_.blocker_
+        & (Util::SQUARE[D1]
+        | Util::SQUARE[C1]
+        | Util::SQUARE[B1]))
         || IsAttacked(E1, BLACK)
         || IsAttacked(D1, BLACK)
         || IsAttacked(C1, BLACK));
@@ -334,9 +372,9 @@ namespace Sayuri {
        */
       bool CanBlackShortCastling() const {
         return (basic_st_.castling_rights_ & BLACK_SHORT_CASTLING)
-        && !((basic_st_.blocker_[R0]
-        & (Util::SQUARE[F8][R0]
-        | Util::SQUARE[G8][R0]))
+        && !((basic_st_.blocker_
+        & (Util::SQUARE[F8]
+        | Util::SQUARE[G8]))
         || IsAttacked(E8, WHITE)
         || IsAttacked(F8, WHITE)
         || IsAttacked(G8, WHITE));
@@ -348,10 +386,10 @@ namespace Sayuri {
        */
       bool CanBlackLongCastling() const {
         return (basic_st_.castling_rights_ & BLACK_LONG_CASTLING)
-        && !((basic_st_.blocker_[R0]
-        & (Util::SQUARE[D8][R0]
-        | Util::SQUARE[C8][R0]
-        | Util::SQUARE[B8][R0]))
+        && !((basic_st_.blocker_
+        & (Util::SQUARE[D8]
+        | Util::SQUARE[C8]
+        | Util::SQUARE[B8]))
         || IsAttacked(E8, WHITE)
         || IsAttacked(D8, WHITE)
         || IsAttacked(C8, WHITE));
@@ -366,10 +404,10 @@ namespace Sayuri {
           if (basic_st_.king_[WHITE] != E1) {
             basic_st_.castling_rights_ &= ~WHITE_CASTLING;
           } else {
-            if (!(basic_st_.position_[WHITE][ROOK] & Util::SQUARE[H1][R0])) {
+            if (!(basic_st_.position_[WHITE][ROOK] & Util::SQUARE[H1])) {
               basic_st_.castling_rights_ &= ~WHITE_SHORT_CASTLING;
             }
-            if (!(basic_st_.position_[WHITE][ROOK] & Util::SQUARE[A1][R0])) {
+            if (!(basic_st_.position_[WHITE][ROOK] & Util::SQUARE[A1])) {
               basic_st_.castling_rights_ &= ~WHITE_LONG_CASTLING;
             }
           }
@@ -379,10 +417,10 @@ namespace Sayuri {
           if (basic_st_.king_[BLACK] != E8) {
             basic_st_.castling_rights_ &= ~BLACK_CASTLING;
           } else {
-            if (!(basic_st_.position_[BLACK][ROOK] & Util::SQUARE[H8][R0])) {
+            if (!(basic_st_.position_[BLACK][ROOK] & Util::SQUARE[H8])) {
               basic_st_.castling_rights_ &= ~BLACK_SHORT_CASTLING;
             }
-            if (!(basic_st_.position_[BLACK][ROOK] & Util::SQUARE[A8][R0])) {
+            if (!(basic_st_.position_[BLACK][ROOK] & Util::SQUARE[A8])) {
               basic_st_.castling_rights_ &= ~BLACK_LONG_CASTLING;
             }
           }
@@ -435,7 +473,7 @@ namespace Sayuri {
        */
       bool HasSufficientMaterial() const {
         // キング以外の駒のビットボード。
-        Bitboard bb = basic_st_.blocker_[R0]
+        Bitboard bb = basic_st_.blocker_
         & ~(basic_st_.position_[WHITE][KING]
         | basic_st_.position_[BLACK][KING]);
 
@@ -457,16 +495,49 @@ namespace Sayuri {
 
       /**
        * SEEで候補手を評価する。
+       * 駒を取る手のマスでの取り合いを、安い駒から順に最後まで読む。
        * @param move 評価したい手。
-       * @return 計算後の候補手の評価。
+       * @return 計算後の候補手の評価。 (マイナスなら損する交換。)
        */
-      u32 SEE(Move move) const;
+      int SEE(Move move) const;
 
       /**
-       * 現在の局面のハッシュを計算する。
+       * 現在の局面のハッシュを得る。 (差分更新されているので計算しない。)
        * @return 現在の局面のハッシュ。
        */
-      Hash GetCurrentHash() const;
+      Hash GetCurrentHash() const {return basic_st_.pos_hash_;}
+
+      /**
+       * 現在の局面のポーンの配置だけのハッシュを得る。
+       * @return 現在の局面のポーンの配置のハッシュ。
+       */
+      Hash GetCurrentPawnHash() const {return basic_st_.pawn_hash_;}
+
+      /**
+       * 現在の局面の駒の数だけのハッシュを得る。
+       * @return 現在の局面の駒の数のハッシュ。
+       */
+      Hash GetCurrentMaterialHash() const {return basic_st_.material_hash_;}
+
+      /**
+       * 現在の局面から各ハッシュを計算し直す。
+       * (PutPiece()やMakeMove()を通さずに局面を変えた後に呼ぶ。)
+       */
+      void CalHashes();
+
+      /**
+       * ボードから局面のハッシュを計算する。
+       * (記録した局面のハッシュを計算し直す時にも使う。)
+       * @param board 対象のボード。
+       * @return 局面のハッシュ。
+       */
+      Hash CalPosHash(const Board& board) const;
+
+      /**
+       * 現在の局面から駒の配置の価値の合計を計算し直す。
+       * (探索開始時、パラメータをキャッシュした後に呼ぶ。)
+       */
+      void CalPositionSums();
 
       /**
        * 現在の局面のハッシュと候補手から、次の局面のハッシュを得る。
@@ -513,10 +584,10 @@ namespace Sayuri {
         return basic_st_.side_pieces_;
       }
       /**
-       * アクセサ - 全駒の配置のビットボード。 [角度]
+       * アクセサ - 全駒の配置のビットボード。
        * @return 全駒の配置のビットボード。
        */
-      const Bitboard (& blocker() const)[NUM_ROTS] {
+      Bitboard blocker() const {
         return basic_st_.blocker_;
       }
       /**
@@ -568,29 +639,26 @@ namespace Sayuri {
        * @return ヒストリー。 [サイド][from][to]。
        */
       const u64 (& history() const)[NUM_SIDES][NUM_SQUARES][NUM_SQUARES] {
-        return const_cast<const u64 (&)[NUM_SIDES][NUM_SQUARES][NUM_SQUARES]>
-        (shared_st_ptr_->history_);
+        return order_st_ptr_->history_;
       }
       /**
        * アクセサ - ヒストリーの最大値。
        * @return ヒストリーの最大値。
        */
-      u64 history_max() const {return shared_st_ptr_->history_max_;}
+      u64 history_max() const {return order_st_ptr_->history_max_;}
       /**
        * アクセサ - IIDでの最善手のスタック。
        * @return IIDでの最善手のスタック。 [探索レベル]
        */
       const Move (& iid_stack() const)[MAX_PLYS + 1] {
-        return const_cast<const Move (&) [MAX_PLYS + 1]>
-        (shared_st_ptr_->iid_stack_);
+        return order_st_ptr_->iid_stack_;
       }
       /**
        * アクセサ - キラームーブのスタック。
        * @return キラームーブのスタック。 [探索レベル][index * 2 プライ前]
        */
       const Move (& killer_stack() const)[MAX_PLYS + 2 + 1][2] {
-        return const_cast<const Move (&) [MAX_PLYS + 2 + 1][2]>
-        (shared_st_ptr_->killer_stack_);
+        return order_st_ptr_->killer_stack_;
       }
       /**
        * アクセサ - 探索関数用パラメータ。
@@ -613,6 +681,18 @@ namespace Sayuri {
       TranspositionTable& table() {
         return *(shared_st_ptr_->table_ptr_);
       }
+      /**
+       * アクセサ - 局面のハッシュ値を生成した種。
+       * @return 局面のハッシュ値を生成した種。
+       */
+      Hash hash_key_seed() const {return shared_st_ptr_->hash_key_seed_;}
+      /**
+       * アクセサ - 評価値のハッシュテーブルのサイズ。 (スレッド毎)
+       * @return 評価値のハッシュテーブルのサイズ。 (バイト)
+       */
+      std::size_t eval_table_size() const {
+        return shared_st_ptr_->eval_table_size_;
+      }
       /**
        * アクセサ - 駒の情報のハッシュ値のテーブル。
        * [サイド][駒の種類][駒の位置]
@@ -654,16 +734,20 @@ namespace Sayuri {
       void to_move(Side to_move) {
         if (!to_move) return;
         if (to_move >= NUM_SIDES) return;
+        basic_st_.pos_hash_ ^= GetStateHash();
         basic_st_.to_move_ = to_move;
+        basic_st_.pos_hash_ ^= GetStateHash();
       }
       /**
        * ミューテータ - キャスリングの権利。
        * @param castling_rights キャスリングの権利。
        */
       void castling_rights(Castling castling_rights) {
+        basic_st_.pos_hash_ ^= GetStateHash();
         basic_st_.castling_rights_ = castling_rights;
 
         UpdateCastlingRights();
+        basic_st_.pos_hash_ ^= GetStateHash();
       }
       /**
        * ミューテータ - アンパッサンの位置。
@@ -672,11 +756,11 @@ namespace Sayuri {
       void en_passant_square(Square en_passant_square) {
         // 0の場合は0。
         if (!en_passant_square) {
-          basic_st_.en_passant_square_ = en_passant_square;
+          SetEnPassantSquare(en_passant_square);
           return;
         }
 
-        if ((basic_st_.blocker_[R0] & Util::SQUARE[en_passant_square][R0])) {
+        if ((basic_st_.blocker_ & Util::SQUARE[en_passant_square])) {
           // 駒があるのでアンパッサンの位置に指定できない。
           return;
         }
@@ -686,16 +770,16 @@ namespace Sayuri {
           // すぐ上に白ポーンがいなければならない。
           Square en_passant_target = en_passant_square + 8;
           if ((basic_st_.position_[WHITE][PAWN]
-          & Util::SQUARE[en_passant_target][R0])) {
-            basic_st_.en_passant_square_ = en_passant_square;
+          & Util::SQUARE[en_passant_target])) {
+            SetEnPassantSquare(en_passant_square);
             return;
           }
         } else if (rank == RANK_6) {
           // すぐ下に黒ポーンがいなければならない。
           Square en_passant_target = en_passant_square - 8;
           if ((basic_st_.position_[BLACK][PAWN]
-          & Util::SQUARE[en_passant_target][R0])) {
-            basic_st_.en_passant_square_ = en_passant_square;
+          & Util::SQUARE[en_passant_target])) {
+            SetEnPassantSquare(en_passant_square);
             return;
           }
         }
@@ -735,9 +819,6 @@ namespace Sayuri {
       friend struct GenBitboards;
       /** 評価関数で使うテンプレート部品。 */
       template<Side SIDE, PieceType TYPE>
-      friend struct CalPosition;
-      /** 評価関数で使うテンプレート部品。 */
-      template<Side SIDE, PieceType TYPE>
       friend struct CalMobility;
       /** 評価関数で使うテンプレート部品。 */
       template<Side SIDE, PieceType TYPE>
@@ -761,15 +842,37 @@ namespace Sayuri {
       // ======== //
       // 探索関数 //
       // ======== //
+      /** Perft用ハッシュテーブルのエントリー。 */
+      struct PerftEntry {
+        /** 局面のハッシュとdata_の排他的論理和。 */
+        std::atomic<Hash> key_;
+        /** 上位56ビットが末端ノード数、下位8ビットが深さ。 */
+        std::atomic<u64> data_;
+      };
+
+      /**
+       * Perftの本体。 (ルート以外)
+       * @param depth 残りの深さ。 (1以上)
+       * @param level 現在のレベル。
+       * @param pos_hash 現在の局面のハッシュ。
+       * @param table Perft用ハッシュテーブル。 なければnullptr。
+       * @param table_mask ハッシュテーブルのインデックスのマスク。
+       * @return 末端ノード数。
+       */
+      u64 PerftCore(int depth, u32 level, Hash pos_hash, PerftEntry* table,
+      Hash table_mask);
+
       /**
        * クイース探索。
+       * @param pos_hash 現在の局面のハッシュ。
        * @param level 現在のレベル。
        * @param alpha アルファ値。
        * @param beta ベータ値。
        * @param material 現在のマテリアル。
        * @return 評価値。
        */
-      int Quiesce(u32 level, int alpha, int beta, int material);
+      int Quiesce(Hash pos_hash, u32 level, int alpha, int beta,
+      int material);
 
       /**
        * 通常の探索。
@@ -800,6 +903,14 @@ namespace Sayuri {
        */
       void ThreadYBWC(UCIShell& shell);
 
+      /**
+       * Lazy SMP探索用スレッド。
+       * 自分だけで反復深化し、他のスレッドとは
+       * トランスポジションテーブルだけを共有する。
+       * @param moves_to_search 探索する候補手。 空なら全ての候補手を探索。
+       */
+      void ThreadLazySMP(const std::vector<Move>& moves_to_search);
+
       /**
        * 別スレッド用探索関数。
        * @param node_type ノードの種類。
@@ -821,9 +932,59 @@ namespace Sayuri {
        */
       bool JudgeToStop(Job& job);
 
+      /**
+       * 取らない手が良い手だった時に、手の並び替え用のテーブルを更新する。
+       * キラームーブ、カウンタームーブ、ヒストリー、継続ヒストリー。
+       * (注) 手を指す前の局面で呼ぶこと。
+       * @param move 良かった手。
+       * @param level 現在のレベル。
+       * @param depth 現在の深さ。
+       */
+      void UpdateOrderTables(Move move, u32 level, int depth);
+
+      /**
+       * 1つ前のレベルで指した手を得る。
+       * @param level 現在のレベル。
+       * @return 1つ前のレベルで指した手。 無ければ0。
+       */
+      Move GetLastMove(u32 level) const {
+        return level ? order_st_ptr_->current_move_stack_[level - 1] : 0;
+      }
+
+      /**
+       * スレッドの数が違えば、子エンジンとスレッドのプールを作り直す。
+       * (注) mutex_をロックしてから呼ぶこと。
+       * @param num_threads 探索用のスレッド数。
+       */
+      void PrepareThreads(int num_threads);
+
       // ======================== //
       // その他のプライベート関数 //
       // ======================== //
+      /**
+       * 手番、キャスリングの権利、アンパッサンの分のハッシュを得る。
+       * (局面のハッシュの差分更新用。)
+       * @return 手番、キャスリングの権利、アンパッサンのハッシュ。
+       */
+      Hash GetStateHash() const {
+        return shared_st_ptr_->to_move_hash_value_table_[basic_st_.to_move_]
+        ^ shared_st_ptr_->castling_hash_value_table_
+        [basic_st_.castling_rights_]
+        ^ shared_st_ptr_->en_passant_hash_value_table_
+        [basic_st_.en_passant_square_];
+      }
+
+      /**
+       * アンパッサンの位置を変え、局面のハッシュを更新する。
+       * @param en_passant_square アンパッサンの位置。
+       */
+      void SetEnPassantSquare(Square en_passant_square) {
+        basic_st_.pos_hash_ ^= shared_st_ptr_->en_passant_hash_value_table_
+        [basic_st_.en_passant_square_]
+        ^ shared_st_ptr_->en_passant_hash_value_table_[en_passant_square];
+        basic_st_.en_passant_square_ = en_passant_square;
+      }
+
       /**
        * 駒を置く。
        * @param square 駒を置きたいマス。
@@ -861,6 +1022,33 @@ namespace Sayuri {
        */
       void UnmakeMove(Move move);
 
+      /**
+       * 探索中に次の一手を指す。
+       * SAYURI_COPY_MAKEが定義されていれば、指す前の局面を
+       * 探索レベル毎のテーブルに退避する。
+       * @param move 候補手。
+       * @param level 現在のレベル。
+       */
+      void MakeMoveOnLevel(Move& move, u32 level) {
+#if defined(SAYURI_COPY_MAKE)
+        state_table_[level] = basic_st_;
+#endif
+        MakeMove(move);
+      }
+      /**
+       * MakeMoveOnLevel()で動かした手を元に戻す。
+       * SAYURI_COPY_MAKEが定義されていれば、退避した局面をコピーして戻す。
+       * @param move MakeMoveOnLevel()で使用した候補手。
+       * @param level 現在のレベル。
+       */
+      void UnmakeMoveOnLevel(Move move, u32 level) {
+#if defined(SAYURI_COPY_MAKE)
+        static_cast<BoardState&>(basic_st_) = state_table_[level];
+#else
+        UnmakeMove(move);
+#endif
+      }
+
       /**
        * Null Moveを指す。
        * 動かす前のキャスリングの権利、アンパッサンは「move」に記録される。
@@ -868,6 +1056,8 @@ namespace Sayuri {
        * @param move 候補手。
        */
       void MakeNullMove(Move& move) {
+        basic_st_.pos_hash_ ^= GetStateHash();
+
         // 手番を変える。
         basic_st_.to_move_ = Util::GetOppositeSide(basic_st_.to_move_);
 
@@ -877,6 +1067,8 @@ namespace Sayuri {
 
         // アンパッサンの位置を削除。
         basic_st_.en_passant_square_ = 0;
+
+        basic_st_.pos_hash_ ^= GetStateHash();
       }
 
       /**
@@ -884,12 +1076,42 @@ namespace Sayuri {
        * @param move MakeNullMove()で使用した候補手。
        */
       void UnmakeNullMove(Move move) {
+        basic_st_.pos_hash_ ^= GetStateHash();
+
         // 手番を変える。
         basic_st_.to_move_ = Util::GetOppositeSide(basic_st_.to_move_);
 
         // 情報を戻す。
         basic_st_.castling_rights_ = Get<CASTLING_RIGHTS>(move);
         basic_st_.en_passant_square_ = Get<EN_PASSANT_SQUARE>(move);
+
+        basic_st_.pos_hash_ ^= GetStateHash();
+      }
+
+      /**
+       * 自分のスレッドの探索したノード数に加算する。
+       * @param nodes 加算するノード数。 (負なら減算。)
+       */
+      void AddNodes(int nodes) {
+        // 書き込むのは自分だけなので、不可分な加算は要らない。
+        std::atomic<u64>& counter =
+        shared_st_ptr_->node_counter_table_[thread_id_].nodes_;
+        counter.store(counter.load(std::memory_order_relaxed) + nodes,
+        std::memory_order_relaxed);
+      }
+
+      /**
+       * 使わなかったノード数の割り当てを残りのノード数に戻す。
+       * (仕事を待つ前に呼ぶ。 他のスレッドが使えるようにする。)
+       */
+      void ReleaseNodes() {
+        u64 my_nodes = shared_st_ptr_->node_counter_table_[thread_id_]
+        .nodes_.load(std::memory_order_relaxed);
+        if (next_node_check_ > my_nodes) {
+          shared_st_ptr_->remaining_nodes_.fetch_add
+          (next_node_check_ - my_nodes, std::memory_order_relaxed);
+          next_node_check_ = my_nodes;
+        }
       }
 
       /**
@@ -909,8 +1131,41 @@ namespace Sayuri {
       // ========== //
       // 基本メンバ //
       // ========== //
+      /**
+       * 1手毎に変わる局面の構造体。
+       * Copy-Make (SAYURI_COPY_MAKE) ではこれだけを探索レベル毎に退避する。
+       */
+      struct BoardState : public Board {
+        /**
+         * 局面のハッシュ。
+         * PutPiece()とMakeMove()で差分更新する。
+         */
+        Hash pos_hash_;
+        /**
+         * ポーンの配置のハッシュ。 (ポーンのハッシュテーブル用)
+         * PutPiece()で差分更新する。
+         */
+        Hash pawn_hash_;
+        /**
+         * 駒の数のハッシュ。 (駒の数の組み合わせ毎のテーブル用)
+         * PutPiece()で差分更新する。
+         */
+        Hash material_hash_;
+        /**
+         * オープニングの配置の価値の合計。 (白から見た値、重みを掛ける前)
+         * [駒の種類]
+         * PutPiece()で差分更新し、探索開始時に計算し直す。
+         */
+        int opening_position_sum_[NUM_PIECE_TYPES];
+        /**
+         * エンディングの配置の価値の合計。 (白から見た値、重みを掛ける前)
+         * [駒の種類]
+         * PutPiece()で差分更新し、探索開始時に計算し直す。
+         */
+        int ending_position_sum_[NUM_PIECE_TYPES];
+      };
       /** 基本メンバ構造体。 (ボードのコピーを用意にするための構造体) */
-      struct BasicStruct : public Board {
+      struct BasicStruct : public BoardState {
         /** 探索中の配置のメモ。 */
         Hash position_memo_[MAX_PLYS + 1];
       } basic_st_;
@@ -920,18 +1175,29 @@ namespace Sayuri {
       // ================================================= //
       /** 共有メンバの構造体。 */
       struct SharedStruct {
-        /** ヒストリー。 [サイド][from][to]。 */
-        volatile u64 history_[NUM_SIDES][NUM_SQUARES][NUM_SQUARES];
-        /** ヒストリーの最大値。 */
-        volatile u64 history_max_;
-        /** IIDでの最善手スタック。 [探索レベル] */
-        volatile Move iid_stack_[MAX_PLYS + 1];
-        /** キラームーブスタック。[探索レベル][index * 2 プライ前] */
-        volatile Move killer_stack_[MAX_PLYS + 2 + 1][2];
         /** 現在のIterative Deepeningの深さ。 */
         volatile u32 i_depth_;
-        /** 探索したノード数。 */
-        volatile u64 searched_nodes_;
+        /**
+         * スレッド毎の探索したノード数のカウンター。
+         * 書き込むのは持ち主のスレッドだけ。
+         * 隣のカウンターと同じキャッシュラインに乗らないように詰め物をする。
+         * (C++11のnewはalignasを守らないので、詰め物で64バイトにする。)
+         */
+        struct NodeCounter {
+          /** 探索したノード数。 */
+          std::atomic<u64> nodes_;
+          /** 詰め物。 */
+          char padding_[64 - sizeof(std::atomic<u64>)];
+        };
+        /** 探索したノード数。 [スレッドの番号] */
+        NodeCounter node_counter_table_[UCI_MAX_THREADS + 1];
+        /**
+         * まだどのスレッドにも割り当てていない探索ノード数。
+         * 各スレッドは割り当てを受けた分だけノードを数える。
+         */
+        std::atomic<u64> remaining_nodes_;
+        /** 探索中のスレッドの数。 (ノード数の割り当ての計算に使う。) */
+        int num_threads_;
         /** 探索したレベル。 */
         volatile u32 searched_level_;
         /** 探索開始時間。 */
@@ -949,6 +1215,10 @@ namespace Sayuri {
         volatile bool is_time_over_;
         /** 探索ストップ条件: trueなら無限に考える。 */
         volatile bool infinite_thinking_;
+        /** trueならLazy SMP、falseならYBWCで並列探索する。 */
+        bool enable_lazy_smp_;
+        /** 評価値のハッシュテーブルのサイズ。 (スレッド毎、バイト) */
+        std::size_t eval_table_size_;
 
         /** 指し手の履歴。 */
         std::vector<Move> move_history_;
@@ -976,6 +1246,14 @@ namespace Sayuri {
         Hash castling_hash_value_table_[16];
         /** アンパッサンのハッシュ値のテーブル。 */
         Hash en_passant_hash_value_table_[NUM_SQUARES];
+        /**
+         * 駒の数のハッシュ値のテーブル。 [サイド][駒の種類][何個目か]
+         * n個の駒があれば、0からn-1番目までの値の排他的論理和になる。
+         */
+        Hash material_hash_value_table_
+        [NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
+        /** ハッシュ値のテーブルを生成した種。 */
+        Hash hash_key_seed_;
 
         // ========== //
         // キャッシュ //
@@ -1020,7 +1298,10 @@ namespace Sayuri {
          */
         void ScanMember(const SharedStruct& shared_st);
 
-        /** ハッシュ値のテーブルを初期化する。 */
+        /**
+         * ハッシュ値のテーブルを hash_key_seed_ から初期化する。
+         * 乱数は使わず、 Util::GetHashKey() で計算する。
+         */
         void InitHashValueTable();
 
         /** パラメータをキャッシュする。 */
@@ -1052,6 +1333,51 @@ namespace Sayuri {
          * @param shell 出力関数のあるUCIShell。
          */
         void ThreadPeriodicProcess(UCIShell& shell);
+
+        /**
+         * 全スレッドの探索したノード数を合計する。
+         * @return 探索したノード数。
+         */
+        u64 CountNodes() const {
+          u64 nodes = 0;
+          for (auto& counter : node_counter_table_) {
+            nodes += counter.nodes_.load(std::memory_order_relaxed);
+          }
+          return nodes;
+        }
+
+        /** 全スレッドの探索したノード数を0にする。 */
+        void ResetNodes() {
+          for (auto& counter : node_counter_table_) {
+            counter.nodes_.store(0, std::memory_order_relaxed);
+          }
+        }
+
+        /**
+         * 残りの探索ノード数から、最大でnodes個を割り当てる。
+         * @param nodes 欲しいノード数。
+         * @return 割り当てたノード数。 (残りが足りなければ残りの全部。)
+         */
+        u64 ReserveNodes(u64 nodes) {
+          u64 remaining = remaining_nodes_.load(std::memory_order_relaxed);
+          u64 reserved = 0;
+          do {
+            reserved = Util::GetMin(nodes, remaining);
+          } while (!remaining_nodes_.compare_exchange_weak(remaining,
+          remaining - reserved, std::memory_order_relaxed));
+          return reserved;
+        }
+
+        /** 探索終了後、待機中の定期処理をすぐに終了させる。 */
+        void WakeUpPeriodicProcess() {
+          std::unique_lock<std::mutex> lock(periodic_mutex_);  // ロック。
+          periodic_cond_.notify_all();
+        }
+
+        /** 定期処理の待機用ミューテックス。 */
+        std::mutex periodic_mutex_;
+        /** 定期処理の待機用コンディション。 */
+        std::condition_variable periodic_cond_;
       };
       /** 共有メンバの構造体。 */
       std::shared_ptr<SharedStruct> shared_st_ptr_;
@@ -1059,6 +1385,45 @@ namespace Sayuri {
       // ===================================================== //
       // 固有メンバ (他のエンジンとコピーも共有もしないメンバ) //
       // ===================================================== //
+      /**
+       * 手の並び替え用テーブルの構造体。
+       * スレッド(エンジン)毎に持ち、自分のスレッドだけが読み書きする。
+       */
+      struct OrderStruct {
+        /** 継続ヒストリーの上限。 (u32から溢れないように止める。) */
+        static constexpr u32 MAX_CONT_HISTORY = 0x3fffffffUL;
+
+        /** ヒストリー。 [サイド][from][to]。 */
+        u64 history_[NUM_SIDES][NUM_SQUARES][NUM_SQUARES];
+        /** ヒストリーの最大値。 */
+        u64 history_max_;
+        /** IIDでの最善手スタック。 [探索レベル] */
+        Move iid_stack_[MAX_PLYS + 1];
+        /** キラームーブスタック。[探索レベル][index * 2 プライ前] */
+        Move killer_stack_[MAX_PLYS + 2 + 1][2];
+        /**
+         * カウンタームーブ。 直前の相手の手に対してベータカットした手。
+         * [サイド][直前の手のfrom][直前の手のto]
+         */
+        Move counter_move_[NUM_SIDES][NUM_SQUARES][NUM_SQUARES];
+        /**
+         * 継続ヒストリー。 直前の相手の手との組み合わせのヒストリー。
+         * [直前の手の駒の種類][直前の手のto][駒の種類][to]
+         */
+        u32 cont_history_[NUM_PIECE_TYPES][NUM_SQUARES]
+        [NUM_PIECE_TYPES][NUM_SQUARES];
+        /**
+         * 探索中の手のスタック。 そのレベルの局面で指した手。
+         * (Null Moveは0。) [探索レベル]
+         */
+        Move current_move_stack_[MAX_PLYS + 1];
+
+        /** 全てのテーブルを0にする。 (ヒストリーの最大値は1。) */
+        void Clear();
+      };
+      /** 手の並び替え用テーブルの構造体。 */
+      std::unique_ptr<OrderStruct> order_st_ptr_;
+
       /** 今ヌルムーブのサーチ中かどうかのフラグ。 */
       bool is_null_searching_;
       /** 探索中のテーブルへのポインタ。 */
@@ -1071,12 +1436,33 @@ namespace Sayuri {
       Evaluator evaluator_;
       /** 並列探索用仕事のテーブル。 [探索レベル] */
       std::unique_ptr<Job[]> job_table_;
-      /** 並列探索用ミューテックス。 */
+      /** 並列探索用ミューテックス。 (スレッドのプールを守る。) */
       std::mutex mutex_;
-      /** 並列探索用スレッドのベクトル。 */
-      std::vector<std::thread> thread_vec_;
+      /** 並列探索用の子エンジンのベクトル。 [スレッドの番号 - 1] */
+      std::vector<std::unique_ptr<ChessEngine>> child_vec_;
+      /**
+       * 並列探索用スレッドのプール。
+       * 子エンジン毎に1つと、定期処理用に1つ。 子エンジンより先に破棄する。
+       */
+      std::unique_ptr<ThreadPool> thread_pool_ptr_;
       /** ベータカット通知。 カットされたレベルが記録される。 */
       volatile u32 notice_cut_level_;
+      /** ヘルパーに渡す分岐点の局面のテーブル。 [探索レベル] */
+      std::unique_ptr<BasicStruct[]> split_st_table_;
+#if defined(SAYURI_COPY_MAKE)
+      /** 指す前の局面を退避するテーブル。 (Copy-Make用) [探索レベル] */
+      std::unique_ptr<BoardState[]> state_table_;
+#endif
+      /**
+       * 並列探索用スレッドの番号。
+       * HelperQueueのキューと、ノード数のカウンターの番号になる。
+       */
+      int thread_id_;
+      /**
+       * 自分のスレッドが割り当てを受けたノード数の合計。
+       * 自分のノード数がここに来たら、次の割り当てを受ける。
+       */
+      u64 next_node_check_;
   };
 }  // namespace Sayuri
 
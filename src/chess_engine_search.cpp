@@ -51,11 +51,13 @@
 #include "helper_queue.h"
 #include "params.h"
 #include "cache.h"
+#include "thread_pool.h"
 
 /** Sayuri 名前空間。 */
 namespace Sayuri {
   // クイース探索。
-  int ChessEngine::Quiesce(u32 level, int alpha, int beta, int material) {
+  int ChessEngine::Quiesce(Hash pos_hash, u32 level, int alpha, int beta,
+  int material) {
     // ジョブの準備。
     Job& job = job_table_[level];
     job.Init(maker_table_[level]);
@@ -67,7 +69,7 @@ namespace Sayuri {
     if (JudgeToStop(job)) return ReturnProcess(alpha, level);
 
     // ノード数を加算。
-    ++(shared_st_ptr_->searched_nodes_);
+    AddNodes(1);
 
     // 最大探索数。
     Util::UpdateMax(shared_st_ptr_->searched_level_, level);
@@ -81,13 +83,45 @@ namespace Sayuri {
     Side side = basic_st_.to_move_;
     Side enemy_side = Util::GetOppositeSide(side);
 
+    // --- トランスポジションテーブル --- //
+    // 残り深さ0のエントリーとして読み書きする。
+    // Null Move探索中の局面は、Search()と同じく登録しないので読まない。
+    bool use_ttable = cache.enable_ttable_ && cache.enable_quiesce_ttable_
+    && !is_null_searching_;
+    Move prev_best = 0;
+    if (use_ttable) {
+      TTEntry tt_entry = table_ptr_->GetEntry(pos_hash);
+      if (tt_entry) {
+        ScoreType score_type = tt_entry.score_type();
+
+        // 前回の最善手を得る。
+        if (score_type != ScoreType::ALPHA) {
+          prev_best = tt_entry.best_move();
+        }
+
+        // 探索省略。 (Search()と同じ条件。)
+        int score = tt_entry.score();
+        if ((level >= 2) && (score < SCORE_WIN) && (score > SCORE_LOSE)) {
+          if ((score_type == ScoreType::EXACT)
+          || ((score_type == ScoreType::ALPHA) && (score <= alpha))
+          || ((score_type == ScoreType::BETA) && (score >= beta))) {
+            return ReturnProcess(score, level);
+          }
+        }
+      }
+    }
+
     // stand_pad。
-    int stand_pad = evaluator_.Evaluate(material);
+    int stand_pad = evaluator_.Evaluate(pos_hash, material);
 
     // アルファ値、ベータ値を調べる。
     if (stand_pad >= beta) {
+      if (use_ttable) {
+        table_ptr_->Add(pos_hash, 0, stand_pad, ScoreType::BETA, 0);
+      }
       return ReturnProcess(stand_pad, level);
     }
+    int original_alpha = alpha;
     Util::UpdateMax(alpha, stand_pad);
 
     // 探索できる限界を超えているか。
@@ -99,45 +133,68 @@ namespace Sayuri {
     // 候補手を作る。
     // 駒を取る手だけ。
     MoveMaker& maker = maker_table_[level];
-    if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-      maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
+    bool is_checked = IsAttacked(basic_st_.king_[side], enemy_side);
+    if (is_checked) {
+      maker.GenMoves<GenMoveType::ALL>(prev_best, 0, 0, 0, 0);
     } else {
-      maker.GenMoves<GenMoveType::CAPTURE>(0, 0, 0, 0);
+      maker.GenMoves<GenMoveType::CAPTURE>(prev_best, 0, 0, 0, 0);
     }
 
     // 探索する。
     // --- Futility Pruning --- //
     int margin = cache.futility_pruning_margin_[0];
 
+    Move best_move = 0;
+    bool is_stopped = false;
     for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
-      if (JudgeToStop(job)) break;
+      if (JudgeToStop(job)) {
+        is_stopped = true;
+        break;
+      }
+
+      // SEEで損をする駒を取る手は読まない。 (チェックされていない時だけ。)
+      // 点数はムーブメーカーがSEEでつけたものを使う。
+      if (!is_checked && (maker.GetPickedScore() < 0)) continue;
+
+      // 次のハッシュ。 (評価値のハッシュテーブルでも使う。)
+      Hash next_hash = GetNextHash(pos_hash, move);
 
       // 次の自分のマテリアル。
       int next_material = GetNextMaterial(material, move);
 
-      MakeMove(move);
-
-      // 合法手かどうか調べる。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        UnmakeMove(move);
-        continue;
-      }
+      MakeMoveOnLevel(move, level);
 
       // Futility Pruning。
       if ((-next_material + margin) <= alpha) {
-        UnmakeMove(move);
+        UnmakeMoveOnLevel(move, level);
         continue;
       }
 
       // 次の手を探索。
-      int score = -Quiesce(level + 1, -beta, -alpha, next_material);
+      int score = -Quiesce(next_hash, level + 1, -beta, -alpha,
+      next_material);
 
-      UnmakeMove(move);
+      UnmakeMoveOnLevel(move, level);
 
       // アルファ値、ベータ値を調べる。
-      Util::UpdateMax(alpha, score);
+      if (score > alpha) {
+        alpha = score;
+        best_move = move;
+        if (alpha >= beta) {
+          break;
+        }
+      }
+    }
+
+    // トランスポジションテーブルに登録。
+    // 途中で探索を中止した結果は登録しない。
+    if (use_ttable && !is_stopped) {
       if (alpha >= beta) {
-        break;
+        table_ptr_->Add(pos_hash, 0, alpha, ScoreType::BETA, best_move);
+      } else if (alpha > original_alpha) {
+        table_ptr_->Add(pos_hash, 0, alpha, ScoreType::EXACT, best_move);
+      } else {
+        table_ptr_->Add(pos_hash, 0, alpha, ScoreType::ALPHA, 0);
       }
     }
 
@@ -158,7 +215,7 @@ namespace Sayuri {
     if (JudgeToStop(job)) return ReturnProcess(alpha, level);
 
     // ノード数を加算。
-    ++(shared_st_ptr_->searched_nodes_);
+    AddNodes(1);
 
     // 最大探索数。
     Util::UpdateMax(shared_st_ptr_->searched_level_, level);
@@ -198,10 +255,10 @@ namespace Sayuri {
     // --- トランスポジションテーブル --- //
     Move prev_best = 0;
     if (cache.enable_ttable_) {
-      table_ptr_->Lock();  // ロック。
-
       // 前回の繰り返しの最善手を含めたエントリーを得る。
-      const TTEntry& tt_entry = table_ptr_->GetEntry(pos_hash);
+      // エントリーはロックせずにコピーする。
+      // 書き込み途中のエントリーはハッシュの照合で弾かれる。
+      TTEntry tt_entry = table_ptr_->GetEntry(pos_hash);
       if (tt_entry) {
         ScoreType score_type = tt_entry.score_type();
 
@@ -222,14 +279,12 @@ namespace Sayuri {
           if (tt_entry.score_type() == ScoreType::EXACT) {
             // エントリーが正確な値。
             pv_line_table_[level].score(score);
-            table_ptr_->Unlock();  // ロック解除。
             return ReturnProcess(score, level);
           } else if (tt_entry.score_type() == ScoreType::ALPHA) {
             // エントリーがアルファ値。
             if (score <= alpha) {
               // アルファ値以下が確定。
               pv_line_table_[level].score(score);
-              table_ptr_->Unlock();  // ロック解除。
               return ReturnProcess(score, level);
             }
 
@@ -239,7 +294,6 @@ namespace Sayuri {
             if (score >= beta) {
               // ベータ値以上が確定。
               pv_line_table_[level].score(score);
-              table_ptr_->Unlock();  // ロック解除。
               return ReturnProcess(score, level);
             }
 
@@ -248,7 +302,6 @@ namespace Sayuri {
           }
         }
       }
-      table_ptr_->Unlock();  // ロック解除。
     }
 
     // 深さが0ならクイース。 (無効なら評価値を返す。)
@@ -256,10 +309,12 @@ namespace Sayuri {
     if ((depth <= 0) || (level >= MAX_PLYS)) {
       if (cache.enable_quiesce_search_) {
         // クイース探索ノードに移行するため、ノード数を減らしておく。
-        --(shared_st_ptr_->searched_nodes_);
-        return ReturnProcess(Quiesce(level, alpha, beta, material), level);
+        AddNodes(-1);
+        return ReturnProcess
+        (Quiesce(pos_hash, level, alpha, beta, material), level);
       } else {
-        return ReturnProcess(evaluator_.Evaluate(material), level);
+        return ReturnProcess
+        (evaluator_.Evaluate(pos_hash, material), level);
       }
     }
 
@@ -267,7 +322,7 @@ namespace Sayuri {
     if (cache.enable_iid_ && (node_type == NodeType::PV)) {
       // 前回の繰り返しの最善手があればIIDしない。
       if (prev_best) {
-        shared_st_ptr_->iid_stack_[level] = prev_best;
+        order_st_ptr_->iid_stack_[level] = prev_best;
       } else {
         if (!is_checked
         && (depth >= cache.iid_limit_depth_)) {
@@ -275,7 +330,7 @@ namespace Sayuri {
           Search(NodeType::PV, pos_hash, cache.iid_search_depth_,
           level, alpha, beta, material);
 
-          shared_st_ptr_->iid_stack_[level] =
+          order_st_ptr_->iid_stack_[level] =
           pv_line_table_[level][0];
         }
       }
@@ -290,6 +345,7 @@ namespace Sayuri {
         Move null_move = 0;
 
         is_null_searching_ = true;
+        order_st_ptr_->current_move_stack_[level] = 0;
         MakeNullMove(null_move);
 
         // Null Move Search。
@@ -306,11 +362,12 @@ namespace Sayuri {
           if (depth <= 0) {
             if (cache.enable_quiesce_search_) {
               // クイース探索ノードに移行するため、ノード数を減らしておく。
-              --(shared_st_ptr_->searched_nodes_);
+              AddNodes(-1);
               return ReturnProcess
-              (Quiesce(level, alpha, beta, material), level);
+              (Quiesce(pos_hash, level, alpha, beta, material), level);
             } else {
-              return ReturnProcess(evaluator_.Evaluate(material), level);
+              return ReturnProcess
+              (evaluator_.Evaluate(pos_hash, material), level);
             }
           }
         }
@@ -319,9 +376,9 @@ namespace Sayuri {
 
     // 手を作る。
     maker_table_[level].GenMoves<GenMoveType::ALL>(prev_best,
-    shared_st_ptr_->iid_stack_[level],
-    shared_st_ptr_->killer_stack_[level][0],
-    shared_st_ptr_->killer_stack_[level][1]);
+    order_st_ptr_->iid_stack_[level],
+    order_st_ptr_->killer_stack_[level][0],
+    order_st_ptr_->killer_stack_[level][1], GetLastMove(level));
 
     ScoreType score_type = ScoreType::ALPHA;
 
@@ -344,20 +401,15 @@ namespace Sayuri {
           // 次のノードへの準備。
           Hash next_hash = GetNextHash(pos_hash, move);
           int next_material = GetNextMaterial(material, move);
+          order_st_ptr_->current_move_stack_[level] = move;
 
-          MakeMove(move);
-
-          // 合法手じゃなければ次の手へ。
-          if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-            UnmakeMove(move);
-            continue;
-          }
+          MakeMoveOnLevel(move, level);
 
           int score = -Search(NodeType::NON_PV, next_hash,
           prob_depth - 1, level + 1, -prob_beta, -(prob_beta - 1),
           next_material);
 
-          UnmakeMove(move);
+          UnmakeMoveOnLevel(move, level);
 
           if (JudgeToStop(job)) return ReturnProcess(alpha, level);
 
@@ -368,26 +420,9 @@ namespace Sayuri {
             pv_line_table_[level].Insert(pv_line_table_[level + 1]);
 
             // 取らない手。
+            // キラームーブ、ヒストリーなどを更新。
             if (!(move & MASK[CAPTURED_PIECE])) {
-              // 手の情報を得る。
-              Square from = Get<FROM>(move);
-              Square to = Get<TO>(move);
-
-              // キラームーブ。
-              if (cache.enable_killer_) {
-                shared_st_ptr_->killer_stack_[level][0] = move;
-                shared_st_ptr_->killer_stack_[level + 2][1] = move;
-              }
-
-              // ヒストリー。
-              if (cache.enable_history_) {
-                shared_st_ptr_->history_[side][from][to] +=
-                Util::DepthToHistory(depth);
-
-                Util::UpdateMax
-                (shared_st_ptr_->history_[side][from][to],
-                shared_st_ptr_->history_max_);
-              }
+              UpdateOrderTables(move, level, depth);
             }
 
             // トランスポジションテーブルに登録。
@@ -434,7 +469,7 @@ namespace Sayuri {
     cache.history_pruning_invalid_moves_[num_all_moves];
 
     u64 history_pruning_threshold =
-    (shared_st_ptr_->history_max_ * cache.history_pruning_threshold_) >> 8;
+    (order_st_ptr_->history_max_ * cache.history_pruning_threshold_) >> 8;
 
     // Late Move Reduction。
     int lmr_move_number = cache.lmr_invalid_moves_[num_all_moves];
@@ -444,8 +479,12 @@ namespace Sayuri {
       if (JudgeToStop(job)) break;
 
       // 別スレッドに助けを求める。(YBWC)
-      if ((job.depth_ >= cache.ybwc_limit_depth_)
+      // Lazy SMPの時は分岐点を作らない。
+      if (!(shared_st_ptr_->enable_lazy_smp_)
+      && (job.depth_ >= cache.ybwc_limit_depth_)
       && (move_number > cache.ybwc_invalid_moves_)) {
+        // ヘルパーは局面を参照できないので、先に全ての手を点数順に並べる。
+        maker_table_[level].PrepareForSharing();
         shared_st_ptr_->helper_queue_ptr_->Help(job);
       }
 
@@ -455,13 +494,8 @@ namespace Sayuri {
       // 次の自分のマテリアル。
       int next_material = GetNextMaterial(job.material_, move);
 
-      MakeMove(move);
-
-      // 合法手じゃなければ次の手へ。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        UnmakeMove(move);
-        continue;
-      }
+      order_st_ptr_->current_move_stack_[level] = move;
+      MakeMoveOnLevel(move, level);
 
       // 合法手があったのでフラグを立てる。
       job.has_legal_move_ = true;
@@ -470,7 +504,7 @@ namespace Sayuri {
 
       // -- Futility Pruning --- //
       if ((-next_material + margin) <= job.alpha_) {
-        UnmakeMove(move);
+        UnmakeMoveOnLevel(move, level);
         continue;
       }
 
@@ -489,8 +523,8 @@ namespace Sayuri {
         && (depth >= cache.lmr_limit_depth_)
         && (move_number > lmr_move_number)
         && !((move & (MASK[CAPTURED_PIECE] | MASK[PROMOTION]))
-        || EqualMove(move, shared_st_ptr_->killer_stack_[level][0])
-        || EqualMove(move, shared_st_ptr_->killer_stack_[level][1]))) {
+        || EqualMove(move, order_st_ptr_->killer_stack_[level][0])
+        || EqualMove(move, order_st_ptr_->killer_stack_[level][1]))) {
           score = -Search(NodeType::NON_PV, next_hash,
           depth - cache.lmr_search_reduction_ - 1, level + 1,
           -(temp_alpha + 1), -temp_alpha, next_material);
@@ -533,11 +567,11 @@ namespace Sayuri {
             if (!(is_checked || null_reduction)
             && (depth >= cache.history_pruning_limit_depth_)
             && (move_number > history_pruning_move_number)
-            && (shared_st_ptr_->history_[side][from][to]
+            && (order_st_ptr_->history_[side][from][to]
             < history_pruning_threshold)
             && !((move & (MASK[CAPTURED_PIECE] | MASK[PROMOTION]))
-            || EqualMove(move, shared_st_ptr_->killer_stack_[level][0])
-            || EqualMove(move, shared_st_ptr_->killer_stack_[level][1]))) {
+            || EqualMove(move, order_st_ptr_->killer_stack_[level][0])
+            || EqualMove(move, order_st_ptr_->killer_stack_[level][1]))) {
               new_depth -= cache.history_pruning_reduction_;
             }
           }
@@ -548,7 +582,7 @@ namespace Sayuri {
         }
       }
 
-      UnmakeMove(move);
+      UnmakeMoveOnLevel(move, level);
 
       // 探索終了ならループを抜ける。
       if (JudgeToStop(job)) break;
@@ -582,8 +616,10 @@ namespace Sayuri {
       job.Unlock();  // ロック解除。
     }
 
-    // スレッドを合流。
-    if (job.depth_ >= cache.ybwc_limit_depth_) {
+    // 依頼を取り下げて、スレッドを合流。
+    if (!(shared_st_ptr_->enable_lazy_smp_)
+    && (job.depth_ >= cache.ybwc_limit_depth_)) {
+      shared_st_ptr_->helper_queue_ptr_->Withdraw(job);
       job.WaitForHelpers();
     }
 
@@ -606,26 +642,10 @@ namespace Sayuri {
       Move best_move = pv_line_table_[level][0];
       pv_line_table_[level].score(job.alpha_);
 
-      // キラームーブ、ヒストリーを記録。
+      // キラームーブ、ヒストリーなどを記録。
       if (job.score_type_ != ScoreType::ALPHA) {
         if (!(best_move & (MASK[CAPTURED_PIECE] | MASK[PROMOTION]))) {
-          // キラームーブ。
-          if (cache.enable_killer_) {
-            shared_st_ptr_->killer_stack_[level][0] = best_move;
-            shared_st_ptr_->killer_stack_[level + 2][1] = best_move;
-          }
-
-          // ヒストリー。
-          if (cache.enable_history_) {
-            Square from = Get<FROM>(best_move);
-            Square to = Get<TO>(best_move);
-
-            shared_st_ptr_->history_[side][from][to] += 
-            Util::DepthToHistory(job.depth_);
-
-            Util::UpdateMax(shared_st_ptr_->history_max_,
-            shared_st_ptr_->history_[side][from][to]);
-          }
+          UpdateOrderTables(best_move, level, job.depth_);
         }
       }
 
@@ -661,53 +681,60 @@ namespace Sayuri {
     shared_st_ptr_->CacheParams();
     Cache& cache = shared_st_ptr_->cache_;
 
-    shared_st_ptr_->searched_nodes_ = 0;
+    shared_st_ptr_->ResetNodes();
+    shared_st_ptr_->remaining_nodes_.store(cache.max_nodes_,
+    std::memory_order_relaxed);
+    shared_st_ptr_->num_threads_ = child_vec_.size() + 1;
+    next_node_check_ = 0;
+    CalPositionSums();
+    evaluator_.PrepareEvalTable(shared_st_ptr_->eval_table_size_);
+    evaluator_.ResetTableStats();
     shared_st_ptr_->searched_level_ = 0;
     shared_st_ptr_->is_time_over_ = false;
-    FOR_SIDES(side) {
-      FOR_SQUARES(from) {
-        FOR_SQUARES(to) {
-          shared_st_ptr_->history_[side][from][to] = 0;
-        }
-      }
-    }
+    order_st_ptr_->Clear();
     for (u32 i = 0; i < (MAX_PLYS + 1); ++i) {
       basic_st_.position_memo_[i] = 0;
-      shared_st_ptr_->iid_stack_[i] = 0;
-      shared_st_ptr_->killer_stack_[i][0] = 0;
-      shared_st_ptr_->killer_stack_[i][1] = 0;
-      shared_st_ptr_->killer_stack_[i + 2][0] = 0;
-      shared_st_ptr_->killer_stack_[i + 2][1] = 0;
       maker_table_[i].ResetStack();
       pv_line_table_[i].ResetLine();
     }
-    shared_st_ptr_->history_max_ = 1;
     shared_st_ptr_->stop_now_ = false;
     shared_st_ptr_->i_depth_ = 1;
     is_null_searching_ = false;
 
     // PVLineに最初の候補手を入れておく。
     MoveMaker temp_maker(*this);
-    temp_maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
+    temp_maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0, 0);
     pv_line_table_[level].SetMove(temp_maker.PickMove());
 
     // スレッドの準備。
-    shared_st_ptr_->helper_queue_ptr_.reset(new HelperQueue());
-    std::vector<std::unique_ptr<ChessEngine>> child_vec(0);
-    for (unsigned int i = 0; i < thread_vec_.size(); ++i) {
-      child_vec.push_back
-      (std::unique_ptr<ChessEngine>(new ChessEngine(*this)));
-
-      ChessEngine* child_ptr = child_vec.back().get();
+    // スレッドの番号はHelperQueueのキューの番号。 0番は自分。
+    // 子エンジンとスレッドは使い回すので、局面と共有メンバだけ渡す。
+    shared_st_ptr_->helper_queue_ptr_->Reset();
+    thread_id_ = 0;
+    for (unsigned int i = 0; i < child_vec_.size(); ++i) {
+      ChessEngine* child_ptr = child_vec_[i].get();
+      child_ptr->basic_st_ = basic_st_;
       child_ptr->shared_st_ptr_ = shared_st_ptr_;
-
-      thread_vec_[i] = std::thread([child_ptr, &shell]() {
-          child_ptr->ThreadYBWC(shell);
-      });
+      child_ptr->thread_id_ = i + 1;
+      child_ptr->evaluator_.PrepareEvalTable
+      (shared_st_ptr_->eval_table_size_);
+      child_ptr->evaluator_.ResetTableStats();
+
+      if (shared_st_ptr_->enable_lazy_smp_ && (i >= 1)) {
+        // Lazy SMP。 ルートを担当する1番目以外のスレッドは
+        // 自分で反復深化する。
+        thread_pool_ptr_->Run(i, [child_ptr, &moves_to_search]() {
+            child_ptr->ThreadLazySMP(moves_to_search);
+        });
+      } else {
+        thread_pool_ptr_->Run(i, [child_ptr, &shell]() {
+            child_ptr->ThreadYBWC(shell);
+        });
+      }
     }
 
-    // 定期処理開始。
-    std::thread time_thread([this, &shell]() {
+    // 定期処理開始。 (プールの最後のスレッド)
+    thread_pool_ptr_->Run(child_vec_.size(), [this, &shell]() {
       this->shared_st_ptr_->ThreadPeriodicProcess(shell);
     });
 
@@ -733,7 +760,7 @@ namespace Sayuri {
       int depth = shared_st_ptr_->i_depth_;
 
       // ノードを加算。
-      ++(shared_st_ptr_->searched_nodes_);
+      AddNodes(1);
 
       // 探索したレベルをリセット。
       shared_st_ptr_->searched_level_ = 0;
@@ -747,7 +774,7 @@ namespace Sayuri {
         (SysClock::now() - shared_st_ptr_->start_time_);
 
         shell.PrintPVInfo(depth, 0, pv_line_table_[level].score(), time,
-        shared_st_ptr_->searched_nodes_, table_ptr_->GetUsedPermill(),
+        shared_st_ptr_->CountNodes(), table_ptr_->GetUsedPermill(),
         pv_line_table_[level]);
 
         continue;
@@ -760,7 +787,7 @@ namespace Sayuri {
         (SysClock::now() - shared_st_ptr_->start_time_);
 
         shell.PrintPVInfo(depth, 0, pv_line_table_[level].score(), time,
-        shared_st_ptr_->searched_nodes_, table_ptr_->GetUsedPermill(),
+        shared_st_ptr_->CountNodes(), table_ptr_->GetUsedPermill(),
         pv_line_table_[level]);
 
         continue;
@@ -789,9 +816,9 @@ namespace Sayuri {
       // 仕事を作る。
       int num_all_moves =
       maker_table_[level].GenMoves<GenMoveType::ALL>(prev_best,
-      shared_st_ptr_->iid_stack_[level],
-      shared_st_ptr_->killer_stack_[level][0],
-      shared_st_ptr_->killer_stack_[level][1]);
+      order_st_ptr_->iid_stack_[level],
+      order_st_ptr_->killer_stack_[level][0],
+      order_st_ptr_->killer_stack_[level][1], 0);
       job.Lock();
       job.Init(maker_table_[level]);
       job.node_type_ = NodeType::PV;
@@ -812,6 +839,9 @@ namespace Sayuri {
       job.Unlock();
 
       // ヘルプして待つ。
+      // ヘルパーは局面を参照できないので、先に全ての手を点数順に並べる。
+      maker_table_[level].PrepareForSharing();
+      ReleaseNodes();
       shared_st_ptr_->helper_queue_ptr_->HelpRoot(job);
       job.WaitForHelpers();
 
@@ -825,24 +855,7 @@ namespace Sayuri {
 
       // 最善手が取らない手の場合、ヒストリー、キラームーブをセット。
       if (!(prev_best & MASK[CAPTURED_PIECE])) {
-        // キラームーブ。
-        if (cache.enable_killer_) {
-          shared_st_ptr_->killer_stack_[level][0] = prev_best;
-          shared_st_ptr_->killer_stack_[level + 2][1] = prev_best;
-        }
-
-        // ヒストリー。
-        if (cache.enable_history_) {
-          // 手の情報を得る。
-          Square from = Get<FROM>(prev_best);
-          Square to = Get<TO>(prev_best);
-
-          shared_st_ptr_->history_[side][from][to] +=
-          Util::DepthToHistory(job.depth_);
-
-          Util::UpdateMax(shared_st_ptr_->history_[side][from][to],
-          shared_st_ptr_->history_max_);
-        }
+        UpdateOrderTables(prev_best, level, job.depth_);
       }
 
       // 最善手をトランスポジションテーブルに登録。
@@ -858,33 +871,39 @@ namespace Sayuri {
       }
     }
 
-    // スレッドをジョイン。
+    // ヘルパーを仕事のキューから開放する。
     shared_st_ptr_->helper_queue_ptr_->ReleaseHelpers();
-    for (auto& thread : thread_vec_) {
-      try {
-        thread.join();
-      } catch (std::system_error err) {
-        // 無視。
-      }
-    }
 
     // 探索終了したけど、まだ思考を止めてはいけない場合、関数を終了しない。
     while (!JudgeToStop(job)) {
       std::this_thread::sleep_for(Chrono::milliseconds(1));
     }
 
-    // 定期処理スレッドを待つ。
-    try {
-      time_thread.join();
-    } catch (std::system_error err) {
-        // 無視。
+    // 全てのスレッドが待機状態に戻るのを待つ。
+    shared_st_ptr_->WakeUpPeriodicProcess();
+    thread_pool_ptr_->WaitForAll();
+
+    // ポーンと評価値のハッシュテーブルの統計を送る。
+    // (最後の"info"が探索結果になるように、結果より先に送る。)
+    // 全てのスレッドが待機中なので、各スレッドの統計をそのまま読める。
+    u64 pawn_table_probes = evaluator_.pawn_table_probes();
+    u64 pawn_table_hits = evaluator_.pawn_table_hits();
+    u64 eval_table_probes = evaluator_.eval_table_probes();
+    u64 eval_table_hits = evaluator_.eval_table_hits();
+    for (auto& child_ptr : child_vec_) {
+      pawn_table_probes += child_ptr->evaluator_.pawn_table_probes();
+      pawn_table_hits += child_ptr->evaluator_.pawn_table_hits();
+      eval_table_probes += child_ptr->evaluator_.eval_table_probes();
+      eval_table_hits += child_ptr->evaluator_.eval_table_hits();
     }
+    shell.PrintTableInfo("pawnhash", pawn_table_probes, pawn_table_hits);
+    shell.PrintTableInfo("evalhash", eval_table_probes, eval_table_hits);
 
     // 最後に情報を送る。
     shell.PrintFinalInfo(shared_st_ptr_->i_depth_,
     Chrono::duration_cast<Chrono::milliseconds>
     (SysClock::now() - (shared_st_ptr_->start_time_)),
-    shared_st_ptr_->searched_nodes_, table_ptr_->GetUsedPermill(),
+    shared_st_ptr_->CountNodes(), table_ptr_->GetUsedPermill(),
     pv_line_table_[level].score(), pv_line_table_[level]);
 
     return pv_line_table_[level];
@@ -896,6 +915,8 @@ namespace Sayuri {
     notice_cut_level_ = MAX_PLYS + 1;
     table_ptr_ = shared_st_ptr_->table_ptr_;
     is_null_searching_ = false;
+    next_node_check_ = 0;
+    order_st_ptr_->Clear();
 
     // 仕事ループ。
     while (true) {
@@ -915,6 +936,7 @@ namespace Sayuri {
           SearchParallel(job_ptr->node_type_, *job_ptr);
         }
 
+        ReleaseNodes();
         job_ptr->ReleaseHelper(*this);
       } else {
         break;
@@ -922,6 +944,113 @@ namespace Sayuri {
     }
   }
 
+  // Lazy SMP探索用スレッド。
+  void ChessEngine::ThreadLazySMP(const std::vector<Move>& moves_to_search) {
+    constexpr int level = 0;
+
+    // 準備。
+    Job& job = job_table_[level];
+    job.Init(maker_table_[level]);
+    notice_cut_level_ = MAX_PLYS + 1;
+    table_ptr_ = shared_st_ptr_->table_ptr_;
+    is_null_searching_ = false;
+    next_node_check_ = 0;
+    order_st_ptr_->Clear();
+    Cache& cache = shared_st_ptr_->cache_;
+
+    Side side = basic_st_.to_move_;
+    Side enemy_side = Util::GetOppositeSide(side);
+    Hash pos_hash = basic_st_.position_memo_[level] = GetCurrentHash();
+    int material = GetMaterial(side);
+    bool is_checked = IsAttacked(basic_st_.king_[side], enemy_side);
+
+    // ルートの合法手を集める。
+    std::vector<Move> move_vec;
+    MoveMaker& maker = maker_table_[level];
+    maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0, 0);
+    for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
+      // 探索すべき手が指定されていれば、その手だけ。
+      if (!(moves_to_search.empty())) {
+        bool hit = false;
+        for (auto move_2 : moves_to_search) {
+          if (EqualMove(move_2, move)) {
+            hit = true;
+            break;
+          }
+        }
+        if (!hit) continue;
+      }
+
+      move_vec.push_back(move);
+    }
+    if (move_vec.empty()) return;
+
+    // 他のスレッドと違う手順で探索するため、スレッドの番号だけ手をずらす。
+    std::rotate(move_vec.begin(),
+    move_vec.begin() + (thread_id_ % move_vec.size()), move_vec.end());
+
+    // --- Iterative Deepening --- //
+    for (int i_depth = 1; i_depth <= static_cast<int>(MAX_PLYS); ++i_depth) {
+      if (JudgeToStop(job)) break;
+
+      // 深さをずらす。
+      // メインの深さより浅くは探索せず、奇数番のスレッドは1つ深く探索する。
+      Util::UpdateMax(i_depth,
+      static_cast<int>(shared_st_ptr_->i_depth_) + (thread_id_ & 1));
+      Util::UpdateMin(i_depth, static_cast<int>(MAX_PLYS));
+
+      int depth = i_depth;
+      if (is_checked && cache.enable_check_extension_) depth += 1;
+
+      // フルウィンドウのPVSearch。
+      int alpha = -MAX_VALUE;
+      int beta = MAX_VALUE;
+      unsigned int best_index = 0;
+      for (unsigned int index = 0; index < move_vec.size(); ++index) {
+        Move move = move_vec[index];
+        Hash next_hash = GetNextHash(pos_hash, move);
+        int next_material = GetNextMaterial(material, move);
+
+        order_st_ptr_->current_move_stack_[level] = move;
+        MakeMoveOnLevel(move, level);
+
+        int score = 0;
+        if (index == 0) {
+          score = -Search(NodeType::PV, next_hash, depth - 1, level + 1,
+          -beta, -alpha, next_material);
+        } else {
+          score = -Search(NodeType::NON_PV, next_hash, depth - 1, level + 1,
+          -(alpha + 1), -alpha, next_material);
+          if (score > alpha) {
+            score = -Search(NodeType::PV, next_hash, depth - 1, level + 1,
+            -beta, -alpha, next_material);
+          }
+        }
+
+        UnmakeMoveOnLevel(move, level);
+
+        if (JudgeToStop(job)) break;
+
+        if (score > alpha) {
+          alpha = score;
+          best_index = index;
+        }
+      }
+
+      if (JudgeToStop(job)) break;
+
+      // 最善手を先頭にして、次の繰り返しで最初に探索する。
+      std::rotate(move_vec.begin(), move_vec.begin() + best_index,
+      move_vec.begin() + best_index + 1);
+
+      // 最善手をトランスポジションテーブルに登録。
+      if (cache.enable_ttable_) {
+        table_ptr_->Add(pos_hash, depth, alpha, ScoreType::EXACT,
+        move_vec[0]);
+      }
+    }
+  }
+
   // 並列探索。
   void ChessEngine::SearchParallel(NodeType node_type, Job& job) {
     // キャッシュ。
@@ -929,7 +1058,6 @@ namespace Sayuri {
 
     // 仕事ループ。
     Side side = basic_st_.to_move_;
-    Side enemy_side = Util::GetOppositeSide(side);
     int move_number = 0;
     int margin = cache.futility_pruning_margin_[job.depth_];
 
@@ -938,7 +1066,7 @@ namespace Sayuri {
     cache.history_pruning_invalid_moves_[job.num_all_moves_];
 
     u64 history_pruning_threshold =
-    (shared_st_ptr_->history_max_ * cache.history_pruning_threshold_) >> 8;
+    (order_st_ptr_->history_max_ * cache.history_pruning_threshold_) >> 8;
 
     // Late Move Reduction。
     int lmr_move_number = cache.lmr_invalid_moves_[job.num_all_moves_];
@@ -953,13 +1081,8 @@ namespace Sayuri {
       // 次の局面のマテリアルを得る。
       int next_material = GetNextMaterial(job.material_, move);
 
-      MakeMove(move);
-
-      // 合法手じゃなければ次の手へ。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        UnmakeMove(move);
-        continue;
-      }
+      order_st_ptr_->current_move_stack_[job.level_] = move;
+      MakeMoveOnLevel(move, job.level_);
 
       move_number = job.Count();
 
@@ -968,7 +1091,7 @@ namespace Sayuri {
 
       // --- Futility Pruning --- //
       if ((-next_material + margin) <= job.alpha_) {
-        UnmakeMove(move);
+        UnmakeMoveOnLevel(move, job.level_);
         continue;
       }
 
@@ -987,8 +1110,8 @@ namespace Sayuri {
         && (job.depth_ >= cache.lmr_limit_depth_)
         && (move_number > lmr_move_number)
         && !((move & (MASK[CAPTURED_PIECE] | MASK[PROMOTION]))
-        || EqualMove(move, shared_st_ptr_->killer_stack_[job.level_][0])
-        || EqualMove(move, shared_st_ptr_->killer_stack_[job.level_][1]))) {
+        || EqualMove(move, order_st_ptr_->killer_stack_[job.level_][0])
+        || EqualMove(move, order_st_ptr_->killer_stack_[job.level_][1]))) {
           score = -Search(NodeType::NON_PV, next_hash,
           job.depth_ - cache.lmr_search_reduction_ - 1, job.level_ + 1,
           -(temp_alpha + 1), -temp_alpha, next_material);
@@ -1031,12 +1154,12 @@ namespace Sayuri {
             if (!(job.is_checked_ || job.null_reduction_)
             && (job.depth_ >= cache.history_pruning_limit_depth_)
             && (move_number > history_pruning_move_number)
-            && (shared_st_ptr_->history_[side][from][to]
+            && (order_st_ptr_->history_[side][from][to]
             < history_pruning_threshold)
             && !((move & (MASK[CAPTURED_PIECE] | MASK[PROMOTION]))
-            || EqualMove(move, shared_st_ptr_->killer_stack_[job.level_][0])
+            || EqualMove(move, order_st_ptr_->killer_stack_[job.level_][0])
             || EqualMove
-            (move, shared_st_ptr_->killer_stack_[job.level_][1]))) {
+            (move, order_st_ptr_->killer_stack_[job.level_][1]))) {
               new_depth -= cache.history_pruning_reduction_;
             }
           }
@@ -1047,7 +1170,7 @@ namespace Sayuri {
         }
       }
 
-      UnmakeMove(move);
+      UnmakeMoveOnLevel(move, job.level_);
 
       // 探索終了ならループを抜ける。
       if (JudgeToStop(job)) break;
@@ -1088,8 +1211,6 @@ namespace Sayuri {
     Cache& cache = shared_st_ptr_->cache_;
 
     // 仕事ループ。
-    Side side = basic_st_.to_move_;
-    Side enemy_side = Util::GetOppositeSide(side);
     int move_number = 0;
 
     // パラメータを準備。
@@ -1121,13 +1242,8 @@ namespace Sayuri {
       // 次の局面のマテリアル。
       int next_material = GetNextMaterial(job.material_, move);
 
-      MakeMove(move);
-
-      // 合法手じゃなければ次の手へ。
-      if (IsAttacked(basic_st_.king_[side], enemy_side)) {
-        UnmakeMove(move);
-        continue;
-      }
+      order_st_ptr_->current_move_stack_[job.level_] = move;
+      MakeMoveOnLevel(move, job.level_);
 
       move_number = job.Count();
 
@@ -1269,7 +1385,7 @@ namespace Sayuri {
         }
       }
 
-      UnmakeMove(move);
+      UnmakeMoveOnLevel(move, job.level_);
 
       // ストップがかかっていたらループを抜ける。
       if (JudgeToStop(job)) break;
@@ -1288,7 +1404,7 @@ namespace Sayuri {
         (SysClock::now() - shared_st_ptr_->start_time_);
 
         shell.PrintPVInfo(job.depth_, shared_st_ptr_->searched_level_, score,
-        time, shared_st_ptr_->searched_nodes_, table_ptr_->GetUsedPermill(),
+        time, shared_st_ptr_->CountNodes(), table_ptr_->GetUsedPermill(),
         *(job.pv_line_ptr_));
 
         job.alpha_ = score;
@@ -1298,15 +1414,77 @@ namespace Sayuri {
   }
 
   // SEEで候補手を評価する。
-  u32 ChessEngine::SEE(Move move) const {
-
+  int ChessEngine::SEE(Move move) const {
     Cache& cache = shared_st_ptr_->cache_;
 
     // SEEが無効かどうか。
     if (!(cache.enable_see_)) return 1;
 
-    return Get<MOVE_TYPE>(move) == EN_PASSANT ? cache.material_[PAWN]
-    : cache.material_[basic_st_.piece_board_[Get<TO>(move)]];
+    Square from = Get<FROM>(move);
+    Square to = Get<TO>(move);
+    Side side = basic_st_.side_board_[from];
+
+    // 交換で取り除いた駒を消していくブロッカー。
+    Bitboard blocker = basic_st_.blocker_;
+    auto remove_piece = [&blocker](Square square) {
+      blocker &= ~(Util::SQUARE[square]);
+    };
+
+    // toに利いている、まだ盤上にある駒を得る。
+    // (スライディングピースの後ろにいる駒は、前の駒を消すと現れる。)
+    auto get_attackers = [this, &blocker, to](Side attacker_side) {
+      const Bitboard (& position)[NUM_PIECE_TYPES] =
+      basic_st_.position_[attacker_side];
+      return ((Util::PAWN_ATTACK[Util::GetOppositeSide(attacker_side)][to]
+      & position[PAWN])
+      | (Util::KNIGHT_MOVE[to] & position[KNIGHT])
+      | (Util::GetBishopMagic(to, blocker)
+      & (position[BISHOP] | position[QUEEN]))
+      | (Util::GetRookMagic(to, blocker)
+      & (position[ROOK] | position[QUEEN]))
+      | (Util::KING_MOVE[to] & position[KING])) & blocker;
+    };
+
+    // 各交換の時点で、取った側から見た駒得。 (スワップリスト)
+    int gain[NUM_SQUARES + 1];
+    int depth = 0;
+    if (Get<MOVE_TYPE>(move) == EN_PASSANT) {
+      gain[0] = cache.material_[PAWN];
+      remove_piece(side == WHITE ? to - 8 : to + 8);
+    } else {
+      gain[0] = cache.material_[basic_st_.piece_board_[to]];
+    }
+
+    // 安い駒から順に取り返していく。
+    PieceType attacker = basic_st_.piece_board_[from];
+    while (true) {
+      ++depth;
+      gain[depth] = cache.material_[attacker] - gain[depth - 1];
+
+      remove_piece(from);
+      side = Util::GetOppositeSide(side);
+
+      // 一番安い駒で取り返す。 (キングより安い駒が無ければキング。)
+      Bitboard attackers = get_attackers(side);
+      if (!attackers) break;
+      for (attacker = PAWN; attacker < KING; ++attacker) {
+        if ((attackers & basic_st_.position_[side][attacker])) break;
+      }
+      from = Util::GetSquare(attackers & basic_st_.position_[side][attacker]);
+
+      // キングは相手の駒が利いているマスでは取れない。
+      if ((attacker == KING)
+      && get_attackers(Util::GetOppositeSide(side))) {
+        break;
+      }
+    }
+
+    // 取り返さない方が得なら、そこで交換をやめる。
+    while (--depth) {
+      gain[depth - 1] = -Util::GetMax(-gain[depth - 1], gain[depth]);
+    }
+
+    return gain[0];
   }
 
   // 探索のストップ条件を設定する。
@@ -1347,19 +1525,77 @@ namespace Sayuri {
 
     // --- 思考ストップ条件から判断 --- //
     // ストップするべきではない。
-    if ((shared_st_ptr_->i_depth_ <= 1)
-    || shared_st_ptr_->infinite_thinking_) {
-      return false;
+    if (shared_st_ptr_->infinite_thinking_) return false;
+
+    // 最大探索ノード数。
+    // 自分のノード数が割り当てに届いたら、残りのノード数から次を受ける。
+    // 割り当ては不可分なので、全スレッドの合計は最大探索ノード数を超えない。
+    // (反復深化の1回目も割り当てを受ける。 足りなくても1回目は止めない。)
+    bool is_out_of_nodes = false;
+    u64 my_nodes = shared_st_ptr_->node_counter_table_[thread_id_]
+    .nodes_.load(std::memory_order_relaxed);
+    if (my_nodes >= next_node_check_) {
+      // 割り当てが足りずに数えた分も差し引く。
+      u64 shortage = my_nodes - next_node_check_;
+      u64 chunk = shared_st_ptr_->remaining_nodes_.load
+      (std::memory_order_relaxed) / (2 * shared_st_ptr_->num_threads_);
+      Util::UpdateMax(chunk, 1ULL);
+
+      u64 reserved = shared_st_ptr_->ReserveNodes(shortage + chunk);
+      next_node_check_ += reserved;
+      is_out_of_nodes = reserved <= shortage;
     }
 
+    // 反復深化の1回目はストップするべきではない。
+    if (shared_st_ptr_->i_depth_ <= 1) return false;
+
     // ストップするべき。
     if ((shared_st_ptr_->is_time_over_)
-    || (shared_st_ptr_->searched_nodes_ >= cache.max_nodes_)
-    || (shared_st_ptr_->i_depth_ > cache.max_depth_)) {
+    || (shared_st_ptr_->i_depth_ > cache.max_depth_) || is_out_of_nodes) {
       shared_st_ptr_->stop_now_ = true;
       return true;
     }
 
     return false;
   }
+
+  // 手の並び替え用のテーブルを更新する。
+  void ChessEngine::UpdateOrderTables(Move move, u32 level, int depth) {
+    // キャッシュ。
+    Cache& cache = shared_st_ptr_->cache_;
+    OrderStruct& order_st = *order_st_ptr_;
+
+    // 手の情報を得る。
+    Side side = basic_st_.to_move_;
+    Square from = Get<FROM>(move);
+    Square to = Get<TO>(move);
+    Move last_move = GetLastMove(level);
+    Square last_from = Get<FROM>(last_move);
+    Square last_to = Get<TO>(last_move);
+
+    // キラームーブとカウンタームーブ。
+    if (cache.enable_killer_) {
+      order_st.killer_stack_[level][0] = move;
+      order_st.killer_stack_[level + 2][1] = move;
+
+      if (last_move) {
+        order_st.counter_move_[side][last_from][last_to] = move;
+      }
+    }
+
+    // ヒストリーと継続ヒストリー。
+    if (cache.enable_history_) {
+      u64 bonus = Util::DepthToHistory(depth);
+
+      order_st.history_[side][from][to] += bonus;
+      Util::UpdateMax(order_st.history_max_, order_st.history_[side][from][to]);
+
+      if (last_move) {
+        u32& cont = order_st.cont_history_[basic_st_.piece_board_[last_to]]
+        [last_to][basic_st_.piece_board_[from]][to];
+        cont = Util::GetMin(cont + bonus,
+        static_cast<u64>(OrderStruct::MAX_CONT_HISTORY));
+      }
+    }
+  }
 }  // namespace Sayuri
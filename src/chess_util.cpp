@@ -33,7 +33,6 @@
 #include <string>
 #include <sstream>
 #include <vector>
-#include <random>
 #include <climits>
 #include <set>
 #include <map>
@@ -46,25 +45,12 @@ namespace Sayuri {
   // ========== //
   // static定数 //
   // ========== //
-  constexpr Square Util::ROT45[NUM_SQUARES];
-  constexpr Square Util::ROT90[NUM_SQUARES];
-  constexpr Square Util::ROT135[NUM_SQUARES];
-  constexpr Square Util::R_ROT45[NUM_SQUARES];
-  constexpr Square Util::R_ROT90[NUM_SQUARES];
-  constexpr Square Util::R_ROT135[NUM_SQUARES];
   constexpr Square Util::FLIP[NUM_SQUARES];
   constexpr Square Util::EN_PASSANT_TRANS_TABLE[NUM_SQUARES];
-  constexpr Bitboard Util::SQUARE0[NUM_SQUARES];
-  constexpr Bitboard Util::SQUARE[NUM_SQUARES][NUM_ROTS];
+  constexpr Bitboard Util::SQUARE[NUM_SQUARES];
   constexpr Bitboard Util::FYLE[NUM_FYLES];
   constexpr Bitboard Util::RANK[NUM_RANKS];
   constexpr Bitboard Util::SQCOLOR[NUM_SIDES];
-  constexpr int Util::MAGIC_SHIFT_V[NUM_SQUARES];
-  constexpr int Util::MAGIC_SHIFT_D[NUM_SQUARES];
-  constexpr int Util::MAGIC_SHIFT[NUM_SQUARES][NUM_ROTS];
-  constexpr Bitboard Util::MAGIC_MASK_V[NUM_SQUARES];
-  constexpr Bitboard Util::MAGIC_MASK_D[NUM_SQUARES];
-  constexpr Bitboard Util::MAGIC_MASK[NUM_SQUARES][NUM_ROTS];
   constexpr Bitboard Util::PAWN_MOVE[NUM_SIDES][NUM_SQUARES];
   constexpr Bitboard Util::PAWN_2STEP_MOVE[NUM_SIDES][NUM_SQUARES];
   constexpr Bitboard Util::PAWN_ATTACK[NUM_SIDES][NUM_SQUARES];
@@ -73,14 +59,84 @@ namespace Sayuri {
   constexpr Bitboard Util::ROOK_MOVE[NUM_SQUARES];
   constexpr Bitboard Util::QUEEN_MOVE[NUM_SQUARES];
   constexpr Bitboard Util::KING_MOVE[NUM_SQUARES];
+  constexpr std::size_t Util::BISHOP_ATTACK_TABLE_SIZE;
+  constexpr std::size_t Util::ROOK_ATTACK_TABLE_SIZE;
+
+  // ========== //
+  // static変数 //
+  // ========== //
+  Util::MagicEntry Util::bishop_magic_[NUM_SQUARES];
+  Util::MagicEntry Util::rook_magic_[NUM_SQUARES];
+  Bitboard Util::bishop_attack_table_[BISHOP_ATTACK_TABLE_SIZE];
+  Bitboard Util::rook_attack_table_[ROOK_ATTACK_TABLE_SIZE];
 
   // ================== //
   // Utilクラスの初期化 //
   // ================== //
   // static変数の初期化。
   void Util::InitUtil() {
-    // ランダム関連を初期化する。
-    InitRandom();
+    // マジックビットボードを作る。
+    static Bitboard (* const BISHOP_SHIFT_FUNCS[4])(Bitboard) {
+      GetRightUpBitboard, GetRightDownBitboard,
+      GetLeftUpBitboard, GetLeftDownBitboard
+    };
+    static Bitboard (* const ROOK_SHIFT_FUNCS[4])(Bitboard) {
+      GetRightBitboard, GetLeftBitboard, GetUpBitboard, GetDownBitboard
+    };
+    InitMagic(bishop_magic_, bishop_attack_table_, MetaUtil::BISHOP_MAGIC,
+    BISHOP_SHIFT_FUNCS);
+    InitMagic(rook_magic_, rook_attack_table_, MetaUtil::ROOK_MAGIC,
+    ROOK_SHIFT_FUNCS);
+  }
+
+  // ==================== //
+  // マジックビットボード //
+  // ==================== //
+  // マジックのデータと利き筋のテーブルを作る。
+  void Util::InitMagic(MagicEntry (& magic_array)[NUM_SQUARES],
+  Bitboard* attack_table, const Bitboard (& magic_numbers)[NUM_SQUARES],
+  Bitboard (* const (& shift_funcs)[4])(Bitboard)) {
+    Bitboard* attack_ptr = attack_table;
+    FOR_SQUARES(square) {
+      MagicEntry& entry = magic_array[square];
+
+      // 盤の端のブロッカーは利き筋に関係しない。
+      // (基点と同じランク、ファイルの端は除かない。)
+      Bitboard edge =
+      ((RANK[RANK_1] | RANK[RANK_8]) & ~RANK[SquareToRank(square)])
+      | ((FYLE[FYLE_A] | FYLE[FYLE_H]) & ~FYLE[SquareToFyle(square)]);
+      entry.mask_ = GenSlidingAttack(square, 0, shift_funcs) & ~edge;
+      entry.magic_ = magic_numbers[square];
+      entry.shift_ = 64 - CountBits(entry.mask_);
+      entry.attack_ptr_ = attack_ptr;
+
+      // マスクの部分集合を全て列挙して、利き筋を書き込む。 (Carry-Rippler)
+      // (マジックナンバーはこの書き込みで衝突しないように、
+      // Tools/CodeGenerator/gen_chess_util_extra_h.pyで探したもの。)
+      int num_patterns = 0;
+      Bitboard blocker = 0;
+      do {
+        attack_ptr[GetMagicIndex(entry, blocker)] =
+        GenSlidingAttack(square, blocker, shift_funcs);
+        ++num_patterns;
+        blocker = (blocker - entry.mask_) & entry.mask_;
+      } while (blocker);
+
+      attack_ptr += num_patterns;
+    }
+  }
+
+  // 1マスずつ辿って利き筋を作る。
+  Bitboard Util::GenSlidingAttack(Square square, Bitboard blocker,
+  Bitboard (* const (& shift_funcs)[4])(Bitboard)) {
+    Bitboard attack = 0;
+    for (auto shift_func : shift_funcs) {
+      for (Bitboard bb = shift_func(SQUARE[square]); bb; bb = shift_func(bb)) {
+        attack |= bb;
+        if (bb & blocker) break;
+      }
+    }
+    return attack;
   }
 
   // ================ //
@@ -128,15 +184,6 @@ namespace Sayuri {
   (const std::basic_string<wchar_t>& str,
   const std::set<wchar_t>& delim, const std::set<wchar_t>& delim_and_word);
 
-  // --- ランダム関連 --- //
-  std::mt19937 Util::engine_;
-  std::uniform_int_distribution<Hash> Util::dist_;
-  void Util::InitRandom() {
-    // メルセンヌツイスターの準備。
-    engine_ = std::mt19937(SysClock::to_time_t(SysClock::now()));
-    dist_ = std::uniform_int_distribution<Hash>(0, ULLONG_MAX);
-  }
-
   // FEN/EPDをパース。
   std::map<std::string, std::string>
   Util::ParseFEN(const std::string& str) {
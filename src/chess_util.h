@@ -33,13 +33,16 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <random>
 #include <set>
 #include <map>
 
 #include "common.h"
 #include "chess_util_extra.h"
 
+#if defined(SAYURI_USE_PEXT)
+#include <immintrin.h>
+#endif
+
 /** Sayuri 名前空間。 */
 namespace Sayuri {
   /** Util用メタ関数名前空間。 */
@@ -347,90 +350,6 @@ namespace Sayuri {
       // ============ //
       // 座標変換配列 //
       // ============ //
-      // --- 変換 --- //
-      /** 0度から45度に変換。 [マス] */
-      static constexpr Square ROT45[NUM_SQUARES] {
-        E4, F3, H2, C2, G1, D1, B1, A1,
-        E5, F4, G3, A3, D2, H1, E1, C1,
-        D6, F5, G4, H3, B3, E2, A2, F1,
-        B7, E6, G5, H4, A4, C3, F2, B2,
-        G7, C7, F6, H5, A5, B4, D3, G2,
-        C8, H7, D7, G6, A6, B5, C4, E3,
-        F8, D8, A8, E7, H6, B6, C5, D4,
-        H8, G8, E8, B8, F7, A7, C6, D5
-      };
-      /** 0度から90度に変換。 [マス] */
-      static constexpr Square ROT90[NUM_SQUARES] {
-        H1, H2, H3, H4, H5, H6, H7, H8,
-        G1, G2, G3, G4, G5, G6, G7, G8,
-        F1, F2, F3, F4, F5, F6, F7, F8,
-        E1, E2, E3, E4, E5, E6, E7, E8,
-        D1, D2, D3, D4, D5, D6, D7, D8,
-        C1, C2, C3, C4, C5, C6, C7, C8,
-        B1, B2, B3, B4, B5, B6, B7, B8,
-        A1, A2, A3, A4, A5, A6, A7, A8
-      };
-      /** 0度から135度に変換。 [マス] */
-      static constexpr Square ROT135[NUM_SQUARES] {
-        A1, C1, F1, B2, G2, E3, D4, D5,
-        B1, E1, A2, F2, D3, C4, C5, C6,
-        D1, H1, E2, C3, B4, B5, B6, A7,
-        G1, D2, B3, A4, A5, A6, H6, F7,
-        C2, A3, H3, H4, H5, G6, E7, B8,
-        H2, G3, G4, G5, F6, D7, A8, E8,
-        F3, F4, F5, E6, C7, H7, D8, G8,
-        E4, E5, D6, B7, G7, C8, F8, H8
-      };
-
-      // --- 逆変換 --- //
-      /** 45度から0度に逆変換。 [45度座標のマス] */
-      static constexpr Square R_ROT45[NUM_SQUARES] {
-        H1,
-        G1, H2,
-        F1, G2, H3,
-        E1, F2, G3, H4,
-        D1, E2, F3, G4, H5,
-        C1, D2, E3, F4, G5, H6,
-        B1, C2, D3, E4, F5, G6, H7,
-        A1, B2, C3, D4, E5, F6, G7, H8,
-        A2, B3, C4, D5, E6, F7, G8,
-        A3, B4, C5, D6, E7, F8,
-        A4, B5, C6, D7, E8,
-        A5, B6, C7, D8,
-        A6, B7, C8,
-        A7, B8,
-        A8
-      };
-      /** 90度から0度に逆変換。 [90度座標のマス] */
-      static constexpr Square R_ROT90[NUM_SQUARES] {
-        A8, A7, A6, A5, A4, A3, A2, A1,
-        B8, B7, B6, B5, B4, B3, B2, B1,
-        C8, C7, C6, C5, C4, C3, C2, C1,
-        D8, D7, D6, D5, D4, D3, D2, D1,
-        E8, E7, E6, E5, E4, E3, E2, E1,
-        F8, F7, F6, F5, F4, F3, F2, F1,
-        G8, G7, G6, G5, G4, G3, G2, G1,
-        H8, H7, H6, H5, H4, H3, H2, H1
-      };
-      /** 135度から0度に逆変換。 [135度座標のマス] */
-      static constexpr Square R_ROT135[NUM_SQUARES] {
-        A1,
-        A2, B1,
-        A3, B2, C1,
-        A4, B3, C2, D1,
-        A5, B4, C3, D2, E1,
-        A6, B5, C4, D3, E2, F1,
-        A7, B6, C5, D4, E3, F2, G1,
-        A8, B7, C6, D5, E4, F3, G2, H1,
-        B8, C7, D6, E5, F4, G3, H2,
-        C8, D7, E6, F5, G4, H3,
-        D8, E7, F6, G5, H4,
-        E8, F7, G6, H5,
-        F8, G7, H6,
-        G8, H7,
-        H8
-      };
-
       /** ボードを鏡対象に上下反転。 [マス] */
       static constexpr Square FLIP[NUM_SQUARES] {
         A8, B8, C8, D8, E8, F8, G8, H8,
@@ -460,8 +379,8 @@ namespace Sayuri {
       // ================== //
       // ビットボードの配列 //
       // ================== //
-      /** 0度のマスのビットボード。 [マス] */
-      static constexpr Bitboard SQUARE0[NUM_SQUARES] {
+      /** マスのビットボード。 [マス] */
+      static constexpr Bitboard SQUARE[NUM_SQUARES] {
         MetaUtil::SQUARE_BB(A1), MetaUtil::SQUARE_BB(B1),
         MetaUtil::SQUARE_BB(C1), MetaUtil::SQUARE_BB(D1),
         MetaUtil::SQUARE_BB(E1), MetaUtil::SQUARE_BB(F1),
@@ -503,272 +422,6 @@ namespace Sayuri {
         MetaUtil::SQUARE_BB(G8), MetaUtil::SQUARE_BB(H8)
       };
 
-      static constexpr Bitboard SQUARE[NUM_SQUARES][NUM_ROTS] {
-        {
-          SQUARE0[A1], SQUARE0[ROT45[A1]],
-          SQUARE0[ROT90[A1]], SQUARE0[ROT135[A1]]
-        },
-        {
-          SQUARE0[B1], SQUARE0[ROT45[B1]],
-          SQUARE0[ROT90[B1]], SQUARE0[ROT135[B1]]
-        },
-        {
-          SQUARE0[C1], SQUARE0[ROT45[C1]],
-          SQUARE0[ROT90[C1]], SQUARE0[ROT135[C1]]
-        },
-        {
-          SQUARE0[D1], SQUARE0[ROT45[D1]],
-          SQUARE0[ROT90[D1]], SQUARE0[ROT135[D1]]
-        },
-        {
-          SQUARE0[E1], SQUARE0[ROT45[E1]],
-          SQUARE0[ROT90[E1]], SQUARE0[ROT135[E1]]
-        },
-        {
-          SQUARE0[F1], SQUARE0[ROT45[F1]],
-          SQUARE0[ROT90[F1]], SQUARE0[ROT135[F1]]
-        },
-        {
-          SQUARE0[G1], SQUARE0[ROT45[G1]],
-          SQUARE0[ROT90[G1]], SQUARE0[ROT135[G1]]
-        },
-        {
-          SQUARE0[H1], SQUARE0[ROT45[H1]],
-          SQUARE0[ROT90[H1]], SQUARE0[ROT135[H1]]
-        },
-
-        {
-          SQUARE0[A2], SQUARE0[ROT45[A2]],
-          SQUARE0[ROT90[A2]], SQUARE0[ROT135[A2]]
-        },
-        {
-          SQUARE0[B2], SQUARE0[ROT45[B2]],
-          SQUARE0[ROT90[B2]], SQUARE0[ROT135[B2]]
-        },
-        {
-          SQUARE0[C2], SQUARE0[ROT45[C2]],
-          SQUARE0[ROT90[C2]], SQUARE0[ROT135[C2]]
-        },
-        {
-          SQUARE0[D2], SQUARE0[ROT45[D2]],
-          SQUARE0[ROT90[D2]], SQUARE0[ROT135[D2]]
-        },
-        {
-          SQUARE0[E2], SQUARE0[ROT45[E2]],
-          SQUARE0[ROT90[E2]], SQUARE0[ROT135[E2]]
-        },
-        {
-          SQUARE0[F2], SQUARE0[ROT45[F2]],
-          SQUARE0[ROT90[F2]], SQUARE0[ROT135[F2]]
-        },
-        {
-          SQUARE0[G2], SQUARE0[ROT45[G2]],
-          SQUARE0[ROT90[G2]], SQUARE0[ROT135[G2]]
-        },
-        {
-          SQUARE0[H2], SQUARE0[ROT45[H2]],
-          SQUARE0[ROT90[H2]], SQUARE0[ROT135[H2]]
-        },
-
-        {
-          SQUARE0[A3], SQUARE0[ROT45[A3]],
-          SQUARE0[ROT90[A3]], SQUARE0[ROT135[A3]]
-        },
-        {
-          SQUARE0[B3], SQUARE0[ROT45[B3]],
-          SQUARE0[ROT90[B3]], SQUARE0[ROT135[B3]]
-        },
-        {
-          SQUARE0[C3], SQUARE0[ROT45[C3]],
-          SQUARE0[ROT90[C3]], SQUARE0[ROT135[C3]]
-        },
-        {
-          SQUARE0[D3], SQUARE0[ROT45[D3]],
-          SQUARE0[ROT90[D3]], SQUARE0[ROT135[D3]]
-        },
-        {
-          SQUARE0[E3], SQUARE0[ROT45[E3]],
-          SQUARE0[ROT90[E3]], SQUARE0[ROT135[E3]]
-        },
-        {
-          SQUARE0[F3], SQUARE0[ROT45[F3]],
-          SQUARE0[ROT90[F3]], SQUARE0[ROT135[F3]]
-        },
-        {
-          SQUARE0[G3], SQUARE0[ROT45[G3]],
-          SQUARE0[ROT90[G3]], SQUARE0[ROT135[G3]]
-        },
-        {
-          SQUARE0[H3], SQUARE0[ROT45[H3]],
-          SQUARE0[ROT90[H3]], SQUARE0[ROT135[H3]]
-        },
-
-        {
-          SQUARE0[A4], SQUARE0[ROT45[A4]],
-          SQUARE0[ROT90[A4]], SQUARE0[ROT135[A4]]
-        },
-        {
-          SQUARE0[B4], SQUARE0[ROT45[B4]],
-          SQUARE0[ROT90[B4]], SQUARE0[ROT135[B4]]
-        },
-        {
-          SQUARE0[C4], SQUARE0[ROT45[C4]],
-          SQUARE0[ROT90[C4]], SQUARE0[ROT135[C4]]
-        },
-        {
-          SQUARE0[D4], SQUARE0[ROT45[D4]],
-          SQUARE0[ROT90[D4]], SQUARE0[ROT135[D4]]
-        },
-        {
-          SQUARE0[E4], SQUARE0[ROT45[E4]],
-          SQUARE0[ROT90[E4]], SQUARE0[ROT135[E4]]
-        },
-        {
-          SQUARE0[F4], SQUARE0[ROT45[F4]],
-          SQUARE0[ROT90[F4]], SQUARE0[ROT135[F4]]
-        },
-        {
-          SQUARE0[G4], SQUARE0[ROT45[G4]],
-          SQUARE0[ROT90[G4]], SQUARE0[ROT135[G4]]
-        },
-        {
-          SQUARE0[H4], SQUARE0[ROT45[H4]],
-          SQUARE0[ROT90[H4]], SQUARE0[ROT135[H4]]
-        },
-
-        {
-          SQUARE0[A5], SQUARE0[ROT45[A5]],
-          SQUARE0[ROT90[A5]], SQUARE0[ROT135[A5]]
-        },
-        {
-          SQUARE0[B5], SQUARE0[ROT45[B5]],
-          SQUARE0[ROT90[B5]], SQUARE0[ROT135[B5]]
-        },
-        {
-          SQUARE0[C5], SQUARE0[ROT45[C5]],
-          SQUARE0[ROT90[C5]], SQUARE0[ROT135[C5]]
-        },
-        {
-          SQUARE0[D5], SQUARE0[ROT45[D5]],
-          SQUARE0[ROT90[D5]], SQUARE0[ROT135[D5]]
-        },
-        {
-          SQUARE0[E5], SQUARE0[ROT45[E5]],
-          SQUARE0[ROT90[E5]], SQUARE0[ROT135[E5]]
-        },
-        {
-          SQUARE0[F5], SQUARE0[ROT45[F5]],
-          SQUARE0[ROT90[F5]], SQUARE0[ROT135[F5]]
-        },
-        {
-          SQUARE0[G5], SQUARE0[ROT45[G5]],
-          SQUARE0[ROT90[G5]], SQUARE0[ROT135[G5]]
-        },
-        {
-          SQUARE0[H5], SQUARE0[ROT45[H5]],
-          SQUARE0[ROT90[H5]], SQUARE0[ROT135[H5]]
-        },
-
-        {
-          SQUARE0[A6], SQUARE0[ROT45[A6]],
-          SQUARE0[ROT90[A6]], SQUARE0[ROT135[A6]]
-        },
-        {
-          SQUARE0[B6], SQUARE0[ROT45[B6]],
-          SQUARE0[ROT90[B6]], SQUARE0[ROT135[B6]]
-        },
-        {
-          SQUARE0[C6], SQUARE0[ROT45[C6]],
-          SQUARE0[ROT90[C6]], SQUARE0[ROT135[C6]]
-        },
-        {
-          SQUARE0[D6], SQUARE0[ROT45[D6]],
-          SQUARE0[ROT90[D6]], SQUARE0[ROT135[D6]]
-        },
-        {
-          SQUARE0[E6], SQUARE0[ROT45[E6]],
-          SQUARE0[ROT90[E6]], SQUARE0[ROT135[E6]]
-        },
-        {
-          SQUARE0[F6], SQUARE0[ROT45[F6]],
-          SQUARE0[ROT90[F6]], SQUARE0[ROT135[F6]]
-        },
-        {
-          SQUARE0[G6], SQUARE0[ROT45[G6]],
-          SQUARE0[ROT90[G6]], SQUARE0[ROT135[G6]]
-        },
-        {
-          SQUARE0[H6], SQUARE0[ROT45[H6]],
-          SQUARE0[ROT90[H6]], SQUARE0[ROT135[H6]]
-        },
-
-        {
-          SQUARE0[A7], SQUARE0[ROT45[A7]],
-          SQUARE0[ROT90[A7]], SQUARE0[ROT135[A7]]
-        },
-        {
-          SQUARE0[B7], SQUARE0[ROT45[B7]],
-          SQUARE0[ROT90[B7]], SQUARE0[ROT135[B7]]
-        },
-        {
-          SQUARE0[C7], SQUARE0[ROT45[C7]],
-          SQUARE0[ROT90[C7]], SQUARE0[ROT135[C7]]
-        },
-        {
-          SQUARE0[D7], SQUARE0[ROT45[D7]],
-          SQUARE0[ROT90[D7]], SQUARE0[ROT135[D7]]
-        },
-        {
-          SQUARE0[E7], SQUARE0[ROT45[E7]],
-          SQUARE0[ROT90[E7]], SQUARE0[ROT135[E7]]
-        },
-        {
-          SQUARE0[F7], SQUARE0[ROT45[F7]],
-          SQUARE0[ROT90[F7]], SQUARE0[ROT135[F7]]
-        },
-        {
-          SQUARE0[G7], SQUARE0[ROT45[G7]],
-          SQUARE0[ROT90[G7]], SQUARE0[ROT135[G7]]
-        },
-        {
-          SQUARE0[H7], SQUARE0[ROT45[H7]],
-          SQUARE0[ROT90[H7]], SQUARE0[ROT135[H7]]
-        },
-
-        {
-          SQUARE0[A8], SQUARE0[ROT45[A8]],
-          SQUARE0[ROT90[A8]], SQUARE0[ROT135[A8]]
-        },
-        {
-          SQUARE0[B8], SQUARE0[ROT45[B8]],
-          SQUARE0[ROT90[B8]], SQUARE0[ROT135[B8]]
-        },
-        {
-          SQUARE0[C8], SQUARE0[ROT45[C8]],
-          SQUARE0[ROT90[C8]], SQUARE0[ROT135[C8]]
-        },
-        {
-          SQUARE0[D8], SQUARE0[ROT45[D8]],
-          SQUARE0[ROT90[D8]], SQUARE0[ROT135[D8]]
-        },
-        {
-          SQUARE0[E8], SQUARE0[ROT45[E8]],
-          SQUARE0[ROT90[E8]], SQUARE0[ROT135[E8]]
-        },
-        {
-          SQUARE0[F8], SQUARE0[ROT45[F8]],
-          SQUARE0[ROT90[F8]], SQUARE0[ROT135[F8]]
-        },
-        {
-          SQUARE0[G8], SQUARE0[ROT45[G8]],
-          SQUARE0[ROT90[G8]], SQUARE0[ROT135[G8]]
-        },
-        {
-          SQUARE0[H8], SQUARE0[ROT45[H8]],
-          SQUARE0[ROT90[H8]], SQUARE0[ROT135[H8]]
-        }
-      };
-
       /** ファイルのビットボード。 [ファイル] */
       static constexpr Bitboard FYLE[NUM_FYLES] {
         MetaUtil::FYLE_BB(FYLE_A), MetaUtil::FYLE_BB(FYLE_B),
@@ -1475,600 +1128,6 @@ namespace Sayuri {
         MetaUtil::INIT_KING_MOVE(G8), MetaUtil::INIT_KING_MOVE(H8)
       };
 
-      // ======== //
-      // マジック //
-      // ======== //
-      /** マジックのシフトの数。0度と90度用。 [マス] */
-      static constexpr int MAGIC_SHIFT_V[NUM_SQUARES] {
-        0, 0, 0, 0, 0, 0, 0, 0,
-        8, 8, 8, 8, 8, 8, 8, 8,
-        16, 16, 16, 16, 16, 16, 16, 16,
-        24, 24, 24, 24, 24, 24, 24, 24,
-        32, 32, 32, 32, 32, 32, 32, 32,
-        40, 40, 40, 40, 40, 40, 40, 40,
-        48, 48, 48, 48, 48, 48, 48, 48,
-        56, 56, 56, 56, 56, 56, 56, 56
-      };
-      /** マジックのシフトの数。45度と135度用。 [マス] */
-      static constexpr int MAGIC_SHIFT_D[NUM_SQUARES] {
-        0,
-        1, 1,
-        3, 3, 3,
-        6, 6, 6, 6,
-        10, 10, 10, 10, 10,
-        15, 15, 15, 15, 15, 15,
-        21, 21, 21, 21, 21, 21, 21,
-        28, 28, 28, 28, 28, 28, 28, 28,
-        36, 36, 36, 36, 36, 36, 36,
-        43, 43, 43, 43, 43, 43,
-        49, 49, 49, 49, 49,
-        54, 54, 54, 54,
-        58, 58, 58,
-        61, 61,
-        63
-      };
-      /** マジックのシフトの数。 [マス][角度] */
-      static constexpr int MAGIC_SHIFT[NUM_SQUARES][NUM_ROTS] {
-        {
-          MAGIC_SHIFT_V[A1], MAGIC_SHIFT_D[ROT45[A1]],
-          MAGIC_SHIFT_V[ROT90[A1]], MAGIC_SHIFT_D[ROT135[A1]]
-        },
-        {
-          MAGIC_SHIFT_V[B1], MAGIC_SHIFT_D[ROT45[B1]],
-          MAGIC_SHIFT_V[ROT90[B1]], MAGIC_SHIFT_D[ROT135[B1]]
-        },
-        {
-          MAGIC_SHIFT_V[C1], MAGIC_SHIFT_D[ROT45[C1]],
-          MAGIC_SHIFT_V[ROT90[C1]], MAGIC_SHIFT_D[ROT135[C1]]
-        },
-        {
-          MAGIC_SHIFT_V[D1], MAGIC_SHIFT_D[ROT45[D1]],
-          MAGIC_SHIFT_V[ROT90[D1]], MAGIC_SHIFT_D[ROT135[D1]]
-        },
-        {
-          MAGIC_SHIFT_V[E1], MAGIC_SHIFT_D[ROT45[E1]],
-          MAGIC_SHIFT_V[ROT90[E1]], MAGIC_SHIFT_D[ROT135[E1]]
-        },
-        {
-          MAGIC_SHIFT_V[F1], MAGIC_SHIFT_D[ROT45[F1]],
-          MAGIC_SHIFT_V[ROT90[F1]], MAGIC_SHIFT_D[ROT135[F1]]
-        },
-        {
-          MAGIC_SHIFT_V[G1], MAGIC_SHIFT_D[ROT45[G1]],
-          MAGIC_SHIFT_V[ROT90[G1]], MAGIC_SHIFT_D[ROT135[G1]]
-        },
-        {
-          MAGIC_SHIFT_V[H1], MAGIC_SHIFT_D[ROT45[H1]],
-          MAGIC_SHIFT_V[ROT90[H1]], MAGIC_SHIFT_D[ROT135[H1]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A2], MAGIC_SHIFT_D[ROT45[A2]],
-          MAGIC_SHIFT_V[ROT90[A2]], MAGIC_SHIFT_D[ROT135[A2]]
-        },
-        {
-          MAGIC_SHIFT_V[B2], MAGIC_SHIFT_D[ROT45[B2]],
-          MAGIC_SHIFT_V[ROT90[B2]], MAGIC_SHIFT_D[ROT135[B2]]
-        },
-        {
-          MAGIC_SHIFT_V[C2], MAGIC_SHIFT_D[ROT45[C2]],
-          MAGIC_SHIFT_V[ROT90[C2]], MAGIC_SHIFT_D[ROT135[C2]]
-        },
-        {
-          MAGIC_SHIFT_V[D2], MAGIC_SHIFT_D[ROT45[D2]],
-          MAGIC_SHIFT_V[ROT90[D2]], MAGIC_SHIFT_D[ROT135[D2]]
-        },
-        {
-          MAGIC_SHIFT_V[E2], MAGIC_SHIFT_D[ROT45[E2]],
-          MAGIC_SHIFT_V[ROT90[E2]], MAGIC_SHIFT_D[ROT135[E2]]
-        },
-        {
-          MAGIC_SHIFT_V[F2], MAGIC_SHIFT_D[ROT45[F2]],
-          MAGIC_SHIFT_V[ROT90[F2]], MAGIC_SHIFT_D[ROT135[F2]]
-        },
-        {
-          MAGIC_SHIFT_V[G2], MAGIC_SHIFT_D[ROT45[G2]],
-          MAGIC_SHIFT_V[ROT90[G2]], MAGIC_SHIFT_D[ROT135[G2]]
-        },
-        {
-          MAGIC_SHIFT_V[H2], MAGIC_SHIFT_D[ROT45[H2]],
-          MAGIC_SHIFT_V[ROT90[H2]], MAGIC_SHIFT_D[ROT135[H2]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A3], MAGIC_SHIFT_D[ROT45[A3]],
-          MAGIC_SHIFT_V[ROT90[A3]], MAGIC_SHIFT_D[ROT135[A3]]
-        },
-        {
-          MAGIC_SHIFT_V[B3], MAGIC_SHIFT_D[ROT45[B3]],
-          MAGIC_SHIFT_V[ROT90[B3]], MAGIC_SHIFT_D[ROT135[B3]]
-        },
-        {
-          MAGIC_SHIFT_V[C3], MAGIC_SHIFT_D[ROT45[C3]],
-          MAGIC_SHIFT_V[ROT90[C3]], MAGIC_SHIFT_D[ROT135[C3]]
-        },
-        {
-          MAGIC_SHIFT_V[D3], MAGIC_SHIFT_D[ROT45[D3]],
-          MAGIC_SHIFT_V[ROT90[D3]], MAGIC_SHIFT_D[ROT135[D3]]
-        },
-        {
-          MAGIC_SHIFT_V[E3], MAGIC_SHIFT_D[ROT45[E3]],
-          MAGIC_SHIFT_V[ROT90[E3]], MAGIC_SHIFT_D[ROT135[E3]]
-        },
-        {
-          MAGIC_SHIFT_V[F3], MAGIC_SHIFT_D[ROT45[F3]],
-          MAGIC_SHIFT_V[ROT90[F3]], MAGIC_SHIFT_D[ROT135[F3]]
-        },
-        {
-          MAGIC_SHIFT_V[G3], MAGIC_SHIFT_D[ROT45[G3]],
-          MAGIC_SHIFT_V[ROT90[G3]], MAGIC_SHIFT_D[ROT135[G3]]
-        },
-        {
-          MAGIC_SHIFT_V[H3], MAGIC_SHIFT_D[ROT45[H3]],
-          MAGIC_SHIFT_V[ROT90[H3]], MAGIC_SHIFT_D[ROT135[H3]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A4], MAGIC_SHIFT_D[ROT45[A4]],
-          MAGIC_SHIFT_V[ROT90[A4]], MAGIC_SHIFT_D[ROT135[A4]]
-        },
-        {
-          MAGIC_SHIFT_V[B4], MAGIC_SHIFT_D[ROT45[B4]],
-          MAGIC_SHIFT_V[ROT90[B4]], MAGIC_SHIFT_D[ROT135[B4]]
-        },
-        {
-          MAGIC_SHIFT_V[C4], MAGIC_SHIFT_D[ROT45[C4]],
-          MAGIC_SHIFT_V[ROT90[C4]], MAGIC_SHIFT_D[ROT135[C4]]
-        },
-        {
-          MAGIC_SHIFT_V[D4], MAGIC_SHIFT_D[ROT45[D4]],
-          MAGIC_SHIFT_V[ROT90[D4]], MAGIC_SHIFT_D[ROT135[D4]]
-        },
-        {
-          MAGIC_SHIFT_V[E4], MAGIC_SHIFT_D[ROT45[E4]],
-          MAGIC_SHIFT_V[ROT90[E4]], MAGIC_SHIFT_D[ROT135[E4]]
-        },
-        {
-          MAGIC_SHIFT_V[F4], MAGIC_SHIFT_D[ROT45[F4]],
-          MAGIC_SHIFT_V[ROT90[F4]], MAGIC_SHIFT_D[ROT135[F4]]
-        },
-        {
-          MAGIC_SHIFT_V[G4], MAGIC_SHIFT_D[ROT45[G4]],
-          MAGIC_SHIFT_V[ROT90[G4]], MAGIC_SHIFT_D[ROT135[G4]]
-        },
-        {
-          MAGIC_SHIFT_V[H4], MAGIC_SHIFT_D[ROT45[H4]],
-          MAGIC_SHIFT_V[ROT90[H4]], MAGIC_SHIFT_D[ROT135[H4]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A5], MAGIC_SHIFT_D[ROT45[A5]],
-          MAGIC_SHIFT_V[ROT90[A5]], MAGIC_SHIFT_D[ROT135[A5]]
-        },
-        {
-          MAGIC_SHIFT_V[B5], MAGIC_SHIFT_D[ROT45[B5]],
-          MAGIC_SHIFT_V[ROT90[B5]], MAGIC_SHIFT_D[ROT135[B5]]
-        },
-        {
-          MAGIC_SHIFT_V[C5], MAGIC_SHIFT_D[ROT45[C5]],
-          MAGIC_SHIFT_V[ROT90[C5]], MAGIC_SHIFT_D[ROT135[C5]]
-        },
-        {
-          MAGIC_SHIFT_V[D5], MAGIC_SHIFT_D[ROT45[D5]],
-          MAGIC_SHIFT_V[ROT90[D5]], MAGIC_SHIFT_D[ROT135[D5]]
-        },
-        {
-          MAGIC_SHIFT_V[E5], MAGIC_SHIFT_D[ROT45[E5]],
-          MAGIC_SHIFT_V[ROT90[E5]], MAGIC_SHIFT_D[ROT135[E5]]
-        },
-        {
-          MAGIC_SHIFT_V[F5], MAGIC_SHIFT_D[ROT45[F5]],
-          MAGIC_SHIFT_V[ROT90[F5]], MAGIC_SHIFT_D[ROT135[F5]]
-        },
-        {
-          MAGIC_SHIFT_V[G5], MAGIC_SHIFT_D[ROT45[G5]],
-          MAGIC_SHIFT_V[ROT90[G5]], MAGIC_SHIFT_D[ROT135[G5]]
-        },
-        {
-          MAGIC_SHIFT_V[H5], MAGIC_SHIFT_D[ROT45[H5]],
-          MAGIC_SHIFT_V[ROT90[H5]], MAGIC_SHIFT_D[ROT135[H5]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A6], MAGIC_SHIFT_D[ROT45[A6]],
-          MAGIC_SHIFT_V[ROT90[A6]], MAGIC_SHIFT_D[ROT135[A6]]
-        },
-        {
-          MAGIC_SHIFT_V[B6], MAGIC_SHIFT_D[ROT45[B6]],
-          MAGIC_SHIFT_V[ROT90[B6]], MAGIC_SHIFT_D[ROT135[B6]]
-        },
-        {
-          MAGIC_SHIFT_V[C6], MAGIC_SHIFT_D[ROT45[C6]],
-          MAGIC_SHIFT_V[ROT90[C6]], MAGIC_SHIFT_D[ROT135[C6]]
-        },
-        {
-          MAGIC_SHIFT_V[D6], MAGIC_SHIFT_D[ROT45[D6]],
-          MAGIC_SHIFT_V[ROT90[D6]], MAGIC_SHIFT_D[ROT135[D6]]
-        },
-        {
-          MAGIC_SHIFT_V[E6], MAGIC_SHIFT_D[ROT45[E6]],
-          MAGIC_SHIFT_V[ROT90[E6]], MAGIC_SHIFT_D[ROT135[E6]]
-        },
-        {
-          MAGIC_SHIFT_V[F6], MAGIC_SHIFT_D[ROT45[F6]],
-          MAGIC_SHIFT_V[ROT90[F6]], MAGIC_SHIFT_D[ROT135[F6]]
-        },
-        {
-          MAGIC_SHIFT_V[G6], MAGIC_SHIFT_D[ROT45[G6]],
-          MAGIC_SHIFT_V[ROT90[G6]], MAGIC_SHIFT_D[ROT135[G6]]
-        },
-        {
-          MAGIC_SHIFT_V[H6], MAGIC_SHIFT_D[ROT45[H6]],
-          MAGIC_SHIFT_V[ROT90[H6]], MAGIC_SHIFT_D[ROT135[H6]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A7], MAGIC_SHIFT_D[ROT45[A7]],
-          MAGIC_SHIFT_V[ROT90[A7]], MAGIC_SHIFT_D[ROT135[A7]]
-        },
-        {
-          MAGIC_SHIFT_V[B7], MAGIC_SHIFT_D[ROT45[B7]],
-          MAGIC_SHIFT_V[ROT90[B7]], MAGIC_SHIFT_D[ROT135[B7]]
-        },
-        {
-          MAGIC_SHIFT_V[C7], MAGIC_SHIFT_D[ROT45[C7]],
-          MAGIC_SHIFT_V[ROT90[C7]], MAGIC_SHIFT_D[ROT135[C7]]
-        },
-        {
-          MAGIC_SHIFT_V[D7], MAGIC_SHIFT_D[ROT45[D7]],
-          MAGIC_SHIFT_V[ROT90[D7]], MAGIC_SHIFT_D[ROT135[D7]]
-        },
-        {
-          MAGIC_SHIFT_V[E7], MAGIC_SHIFT_D[ROT45[E7]],
-          MAGIC_SHIFT_V[ROT90[E7]], MAGIC_SHIFT_D[ROT135[E7]]
-        },
-        {
-          MAGIC_SHIFT_V[F7], MAGIC_SHIFT_D[ROT45[F7]],
-          MAGIC_SHIFT_V[ROT90[F7]], MAGIC_SHIFT_D[ROT135[F7]]
-        },
-        {
-          MAGIC_SHIFT_V[G7], MAGIC_SHIFT_D[ROT45[G7]],
-          MAGIC_SHIFT_V[ROT90[G7]], MAGIC_SHIFT_D[ROT135[G7]]
-        },
-        {
-          MAGIC_SHIFT_V[H7], MAGIC_SHIFT_D[ROT45[H7]],
-          MAGIC_SHIFT_V[ROT90[H7]], MAGIC_SHIFT_D[ROT135[H7]]
-        },
-
-        {
-          MAGIC_SHIFT_V[A8], MAGIC_SHIFT_D[ROT45[A8]],
-          MAGIC_SHIFT_V[ROT90[A8]], MAGIC_SHIFT_D[ROT135[A8]]
-        },
-        {
-          MAGIC_SHIFT_V[B8], MAGIC_SHIFT_D[ROT45[B8]],
-          MAGIC_SHIFT_V[ROT90[B8]], MAGIC_SHIFT_D[ROT135[B8]]
-        },
-        {
-          MAGIC_SHIFT_V[C8], MAGIC_SHIFT_D[ROT45[C8]],
-          MAGIC_SHIFT_V[ROT90[C8]], MAGIC_SHIFT_D[ROT135[C8]]
-        },
-        {
-          MAGIC_SHIFT_V[D8], MAGIC_SHIFT_D[ROT45[D8]],
-          MAGIC_SHIFT_V[ROT90[D8]], MAGIC_SHIFT_D[ROT135[D8]]
-        },
-        {
-          MAGIC_SHIFT_V[E8], MAGIC_SHIFT_D[ROT45[E8]],
-          MAGIC_SHIFT_V[ROT90[E8]], MAGIC_SHIFT_D[ROT135[E8]]
-        },
-        {
-          MAGIC_SHIFT_V[F8], MAGIC_SHIFT_D[ROT45[F8]],
-          MAGIC_SHIFT_V[ROT90[F8]], MAGIC_SHIFT_D[ROT135[F8]]
-        },
-        {
-          MAGIC_SHIFT_V[G8], MAGIC_SHIFT_D[ROT45[G8]],
-          MAGIC_SHIFT_V[ROT90[G8]], MAGIC_SHIFT_D[ROT135[G8]]
-        },
-        {
-          MAGIC_SHIFT_V[H8], MAGIC_SHIFT_D[ROT45[H8]],
-          MAGIC_SHIFT_V[ROT90[H8]], MAGIC_SHIFT_D[ROT135[H8]]
-        }
-      };
-      /** マジックのマスク。0度と90度用。 [マス] */
-      static constexpr Bitboard MAGIC_MASK_V[NUM_SQUARES] {
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL
-      };
-      /** マジックのマスク。45度と135度用。 [マス] */
-      static constexpr Bitboard MAGIC_MASK_D[NUM_SQUARES] {
-        0x1ULL,
-        0x3ULL, 0x3ULL,
-        0x7ULL, 0x7ULL, 0x7ULL,
-        0xfULL, 0xfULL, 0xfULL, 0xfULL,
-        0x1fULL, 0x1fULL, 0x1fULL, 0x1fULL, 0x1fULL,
-        0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL,
-        0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL,
-        0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL, 0xffULL,
-        0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL, 0x7fULL,
-        0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL, 0x3fULL,
-        0x1fULL, 0x1fULL, 0x1fULL, 0x1fULL, 0x1fULL,
-        0xfULL, 0xfULL, 0xfULL, 0xfULL,
-        0x7ULL, 0x7ULL, 0x7ULL,
-        0x3ULL, 0x3ULL,
-        0x1ULL
-      };
-      /** マジックのマスク。 [マス][角度] */
-      static constexpr Bitboard MAGIC_MASK[NUM_SQUARES][NUM_ROTS] {
-        {
-          MAGIC_MASK_V[A1], MAGIC_MASK_D[ROT45[A1]],
-          MAGIC_MASK_V[ROT90[A1]], MAGIC_MASK_D[ROT135[A1]]
-        },
-        {
-          MAGIC_MASK_V[B1], MAGIC_MASK_D[ROT45[B1]],
-          MAGIC_MASK_V[ROT90[B1]], MAGIC_MASK_D[ROT135[B1]]
-        },
-        {
-          MAGIC_MASK_V[C1], MAGIC_MASK_D[ROT45[C1]],
-          MAGIC_MASK_V[ROT90[C1]], MAGIC_MASK_D[ROT135[C1]]
-        },
-        {
-          MAGIC_MASK_V[D1], MAGIC_MASK_D[ROT45[D1]],
-          MAGIC_MASK_V[ROT90[D1]], MAGIC_MASK_D[ROT135[D1]]
-        },
-        {
-          MAGIC_MASK_V[E1], MAGIC_MASK_D[ROT45[E1]],
-          MAGIC_MASK_V[ROT90[E1]], MAGIC_MASK_D[ROT135[E1]]
-        },
-        {
-          MAGIC_MASK_V[F1], MAGIC_MASK_D[ROT45[F1]],
-          MAGIC_MASK_V[ROT90[F1]], MAGIC_MASK_D[ROT135[F1]]
-        },
-        {
-          MAGIC_MASK_V[G1], MAGIC_MASK_D[ROT45[G1]],
-          MAGIC_MASK_V[ROT90[G1]], MAGIC_MASK_D[ROT135[G1]]
-        },
-        {
-          MAGIC_MASK_V[H1], MAGIC_MASK_D[ROT45[H1]],
-          MAGIC_MASK_V[ROT90[H1]], MAGIC_MASK_D[ROT135[H1]]
-        },
-
-        {
-          MAGIC_MASK_V[A2], MAGIC_MASK_D[ROT45[A2]],
-          MAGIC_MASK_V[ROT90[A2]], MAGIC_MASK_D[ROT135[A2]]
-        },
-        {
-          MAGIC_MASK_V[B2], MAGIC_MASK_D[ROT45[B2]],
-          MAGIC_MASK_V[ROT90[B2]], MAGIC_MASK_D[ROT135[B2]]
-        },
-        {
-          MAGIC_MASK_V[C2], MAGIC_MASK_D[ROT45[C2]],
-          MAGIC_MASK_V[ROT90[C2]], MAGIC_MASK_D[ROT135[C2]]
-        },
-        {
-          MAGIC_MASK_V[D2], MAGIC_MASK_D[ROT45[D2]],
-          MAGIC_MASK_V[ROT90[D2]], MAGIC_MASK_D[ROT135[D2]]
-        },
-        {
-          MAGIC_MASK_V[E2], MAGIC_MASK_D[ROT45[E2]],
-          MAGIC_MASK_V[ROT90[E2]], MAGIC_MASK_D[ROT135[E2]]
-        },
-        {
-          MAGIC_MASK_V[F2], MAGIC_MASK_D[ROT45[F2]],
-          MAGIC_MASK_V[ROT90[F2]], MAGIC_MASK_D[ROT135[F2]]
-        },
-        {
-          MAGIC_MASK_V[G2], MAGIC_MASK_D[ROT45[G2]],
-          MAGIC_MASK_V[ROT90[G2]], MAGIC_MASK_D[ROT135[G2]]
-        },
-        {
-          MAGIC_MASK_V[H2], MAGIC_MASK_D[ROT45[H2]],
-          MAGIC_MASK_V[ROT90[H2]], MAGIC_MASK_D[ROT135[H2]]
-        },
-
-        {
-          MAGIC_MASK_V[A3], MAGIC_MASK_D[ROT45[A3]],
-          MAGIC_MASK_V[ROT90[A3]], MAGIC_MASK_D[ROT135[A3]]
-        },
-        {
-          MAGIC_MASK_V[B3], MAGIC_MASK_D[ROT45[B3]],
-          MAGIC_MASK_V[ROT90[B3]], MAGIC_MASK_D[ROT135[B3]]
-        },
-        {
-          MAGIC_MASK_V[C3], MAGIC_MASK_D[ROT45[C3]],
-          MAGIC_MASK_V[ROT90[C3]], MAGIC_MASK_D[ROT135[C3]]
-        },
-        {
-          MAGIC_MASK_V[D3], MAGIC_MASK_D[ROT45[D3]],
-          MAGIC_MASK_V[ROT90[D3]], MAGIC_MASK_D[ROT135[D3]]
-        },
-        {
-          MAGIC_MASK_V[E3], MAGIC_MASK_D[ROT45[E3]],
-          MAGIC_MASK_V[ROT90[E3]], MAGIC_MASK_D[ROT135[E3]]
-        },
-        {
-          MAGIC_MASK_V[F3], MAGIC_MASK_D[ROT45[F3]],
-          MAGIC_MASK_V[ROT90[F3]], MAGIC_MASK_D[ROT135[F3]]
-        },
-        {
-          MAGIC_MASK_V[G3], MAGIC_MASK_D[ROT45[G3]],
-          MAGIC_MASK_V[ROT90[G3]], MAGIC_MASK_D[ROT135[G3]]
-        },
-        {
-          MAGIC_MASK_V[H3], MAGIC_MASK_D[ROT45[H3]],
-          MAGIC_MASK_V[ROT90[H3]], MAGIC_MASK_D[ROT135[H3]]
-        },
-
-        {
-          MAGIC_MASK_V[A4], MAGIC_MASK_D[ROT45[A4]],
-          MAGIC_MASK_V[ROT90[A4]], MAGIC_MASK_D[ROT135[A4]]
-        },
-        {
-          MAGIC_MASK_V[B4], MAGIC_MASK_D[ROT45[B4]],
-          MAGIC_MASK_V[ROT90[B4]], MAGIC_MASK_D[ROT135[B4]]
-        },
-        {
-          MAGIC_MASK_V[C4], MAGIC_MASK_D[ROT45[C4]],
-          MAGIC_MASK_V[ROT90[C4]], MAGIC_MASK_D[ROT135[C4]]
-        },
-        {
-          MAGIC_MASK_V[D4], MAGIC_MASK_D[ROT45[D4]],
-          MAGIC_MASK_V[ROT90[D4]], MAGIC_MASK_D[ROT135[D4]]
-        },
-        {
-          MAGIC_MASK_V[E4], MAGIC_MASK_D[ROT45[E4]],
-          MAGIC_MASK_V[ROT90[E4]], MAGIC_MASK_D[ROT135[E4]]
-        },
-        {
-          MAGIC_MASK_V[F4], MAGIC_MASK_D[ROT45[F4]],
-          MAGIC_MASK_V[ROT90[F4]], MAGIC_MASK_D[ROT135[F4]]
-        },
-        {
-          MAGIC_MASK_V[G4], MAGIC_MASK_D[ROT45[G4]],
-          MAGIC_MASK_V[ROT90[G4]], MAGIC_MASK_D[ROT135[G4]]
-        },
-        {
-          MAGIC_MASK_V[H4], MAGIC_MASK_D[ROT45[H4]],
-          MAGIC_MASK_V[ROT90[H4]], MAGIC_MASK_D[ROT135[H4]]
-        },
-
-        {
-          MAGIC_MASK_V[A5], MAGIC_MASK_D[ROT45[A5]],
-          MAGIC_MASK_V[ROT90[A5]], MAGIC_MASK_D[ROT135[A5]]
-        },
-        {
-          MAGIC_MASK_V[B5], MAGIC_MASK_D[ROT45[B5]],
-          MAGIC_MASK_V[ROT90[B5]], MAGIC_MASK_D[ROT135[B5]]
-        },
-        {
-          MAGIC_MASK_V[C5], MAGIC_MASK_D[ROT45[C5]],
-          MAGIC_MASK_V[ROT90[C5]], MAGIC_MASK_D[ROT135[C5]]
-        },
-        {
-          MAGIC_MASK_V[D5], MAGIC_MASK_D[ROT45[D5]],
-          MAGIC_MASK_V[ROT90[D5]], MAGIC_MASK_D[ROT135[D5]]
-        },
-        {
-          MAGIC_MASK_V[E5], MAGIC_MASK_D[ROT45[E5]],
-          MAGIC_MASK_V[ROT90[E5]], MAGIC_MASK_D[ROT135[E5]]
-        },
-        {
-          MAGIC_MASK_V[F5], MAGIC_MASK_D[ROT45[F5]],
-          MAGIC_MASK_V[ROT90[F5]], MAGIC_MASK_D[ROT135[F5]]
-        },
-        {
-          MAGIC_MASK_V[G5], MAGIC_MASK_D[ROT45[G5]],
-          MAGIC_MASK_V[ROT90[G5]], MAGIC_MASK_D[ROT135[G5]]
-        },
-        {
-          MAGIC_MASK_V[H5], MAGIC_MASK_D[ROT45[H5]],
-          MAGIC_MASK_V[ROT90[H5]], MAGIC_MASK_D[ROT135[H5]]
-        },
-
-        {
-          MAGIC_MASK_V[A6], MAGIC_MASK_D[ROT45[A6]],
-          MAGIC_MASK_V[ROT90[A6]], MAGIC_MASK_D[ROT135[A6]]
-        },
-        {
-          MAGIC_MASK_V[B6], MAGIC_MASK_D[ROT45[B6]],
-          MAGIC_MASK_V[ROT90[B6]], MAGIC_MASK_D[ROT135[B6]]
-        },
-        {
-          MAGIC_MASK_V[C6], MAGIC_MASK_D[ROT45[C6]],
-          MAGIC_MASK_V[ROT90[C6]], MAGIC_MASK_D[ROT135[C6]]
-        },
-        {
-          MAGIC_MASK_V[D6], MAGIC_MASK_D[ROT45[D6]],
-          MAGIC_MASK_V[ROT90[D6]], MAGIC_MASK_D[ROT135[D6]]
-        },
-        {
-          MAGIC_MASK_V[E6], MAGIC_MASK_D[ROT45[E6]],
-          MAGIC_MASK_V[ROT90[E6]], MAGIC_MASK_D[ROT135[E6]]
-        },
-        {
-          MAGIC_MASK_V[F6], MAGIC_MASK_D[ROT45[F6]],
-          MAGIC_MASK_V[ROT90[F6]], MAGIC_MASK_D[ROT135[F6]]
-        },
-        {
-          MAGIC_MASK_V[G6], MAGIC_MASK_D[ROT45[G6]],
-          MAGIC_MASK_V[ROT90[G6]], MAGIC_MASK_D[ROT135[G6]]
-        },
-        {
-          MAGIC_MASK_V[H6], MAGIC_MASK_D[ROT45[H6]],
-          MAGIC_MASK_V[ROT90[H6]], MAGIC_MASK_D[ROT135[H6]]
-        },
-
-        {
-          MAGIC_MASK_V[A7], MAGIC_MASK_D[ROT45[A7]],
-          MAGIC_MASK_V[ROT90[A7]], MAGIC_MASK_D[ROT135[A7]]
-        },
-        {
-          MAGIC_MASK_V[B7], MAGIC_MASK_D[ROT45[B7]],
-          MAGIC_MASK_V[ROT90[B7]], MAGIC_MASK_D[ROT135[B7]]
-        },
-        {
-          MAGIC_MASK_V[C7], MAGIC_MASK_D[ROT45[C7]],
-          MAGIC_MASK_V[ROT90[C7]], MAGIC_MASK_D[ROT135[C7]]
-        },
-        {
-          MAGIC_MASK_V[D7], MAGIC_MASK_D[ROT45[D7]],
-          MAGIC_MASK_V[ROT90[D7]], MAGIC_MASK_D[ROT135[D7]]
-        },
-        {
-          MAGIC_MASK_V[E7], MAGIC_MASK_D[ROT45[E7]],
-          MAGIC_MASK_V[ROT90[E7]], MAGIC_MASK_D[ROT135[E7]]
-        },
-        {
-          MAGIC_MASK_V[F7], MAGIC_MASK_D[ROT45[F7]],
-          MAGIC_MASK_V[ROT90[F7]], MAGIC_MASK_D[ROT135[F7]]
-        },
-        {
-          MAGIC_MASK_V[G7], MAGIC_MASK_D[ROT45[G7]],
-          MAGIC_MASK_V[ROT90[G7]], MAGIC_MASK_D[ROT135[G7]]
-        },
-        {
-          MAGIC_MASK_V[H7], MAGIC_MASK_D[ROT45[H7]],
-          MAGIC_MASK_V[ROT90[H7]], MAGIC_MASK_D[ROT135[H7]]
-        },
-
-        {
-          MAGIC_MASK_V[A8], MAGIC_MASK_D[ROT45[A8]],
-          MAGIC_MASK_V[ROT90[A8]], MAGIC_MASK_D[ROT135[A8]]
-        },
-        {
-          MAGIC_MASK_V[B8], MAGIC_MASK_D[ROT45[B8]],
-          MAGIC_MASK_V[ROT90[B8]], MAGIC_MASK_D[ROT135[B8]]
-        },
-        {
-          MAGIC_MASK_V[C8], MAGIC_MASK_D[ROT45[C8]],
-          MAGIC_MASK_V[ROT90[C8]], MAGIC_MASK_D[ROT135[C8]]
-        },
-        {
-          MAGIC_MASK_V[D8], MAGIC_MASK_D[ROT45[D8]],
-          MAGIC_MASK_V[ROT90[D8]], MAGIC_MASK_D[ROT135[D8]]
-        },
-        {
-          MAGIC_MASK_V[E8], MAGIC_MASK_D[ROT45[E8]],
-          MAGIC_MASK_V[ROT90[E8]], MAGIC_MASK_D[ROT135[E8]]
-        },
-        {
-          MAGIC_MASK_V[F8], MAGIC_MASK_D[ROT45[F8]],
-          MAGIC_MASK_V[ROT90[F8]], MAGIC_MASK_D[ROT135[F8]]
-        },
-        {
-          MAGIC_MASK_V[G8], MAGIC_MASK_D[ROT45[G8]],
-          MAGIC_MASK_V[ROT90[G8]], MAGIC_MASK_D[ROT135[G8]]
-        },
-        {
-          MAGIC_MASK_V[H8], MAGIC_MASK_D[ROT45[H8]],
-          MAGIC_MASK_V[ROT90[H8]], MAGIC_MASK_D[ROT135[H8]]
-        }
-      };
-
       // ================================ //
       // 各種方向のビットボードを得る関数 //
       // ================================ //
@@ -2207,72 +1266,46 @@ namespace Sayuri {
       /**
        * ビショップ用マジックビットボードを得る。
        * @param square ビショップの位置。
-       * @param blocker_45 45度のブロッカー。
-       * @param blocker_135 135度のブロッカー。
+       * @param blocker 全駒の配置のビットボード。
        * @return ビットボード。
        */
-      static constexpr Bitboard GetBishopMagic(Square square,
-      Bitboard blocker_45, Bitboard blocker_135) {
-        return MetaUtil::ATTACK_TABLE[square]
-        [(blocker_45 >> MAGIC_SHIFT[square][R45])
-        & MAGIC_MASK[square][R45]][R45]
-        | MetaUtil::ATTACK_TABLE[square]
-        [(blocker_135 >> MAGIC_SHIFT[square][R135])
-        & MAGIC_MASK[square][R135]][R135];
+      static Bitboard GetBishopMagic(Square square, Bitboard blocker) {
+        const MagicEntry& entry = bishop_magic_[square];
+        return entry.attack_ptr_[GetMagicIndex(entry, blocker)];
       }
       /**
        * ルーク用マジックビットボードを得る。
        * @param square ルークの位置。
-       * @param blocker_0 0度のブロッカー。
-       * @param blocker_90 90度のブロッカー。
+       * @param blocker 全駒の配置のビットボード。
        * @return ビットボード。
        */
-      static constexpr Bitboard GetRookMagic(Square square,
-      Bitboard blocker_0, Bitboard blocker_90) {
-        return MetaUtil::ATTACK_TABLE[square]
-        [(blocker_0 >> MAGIC_SHIFT[square][R0])
-        & MAGIC_MASK[square][R0]][R0]
-        | MetaUtil::ATTACK_TABLE[square]
-        [(blocker_90 >> MAGIC_SHIFT[square][R90])
-        & MAGIC_MASK[square][R90]][R90];
+      static Bitboard GetRookMagic(Square square, Bitboard blocker) {
+        const MagicEntry& entry = rook_magic_[square];
+        return entry.attack_ptr_[GetMagicIndex(entry, blocker)];
       }
       /**
        * クイーン用マジックビットボードを得る。
        * @param square クイーンの位置。
-       * @param blocker_0 0度のブロッカー。
-       * @param blocker_45 45度のブロッカー。
-       * @param blocker_90 90度のブロッカー。
-       * @param blocker_135 135度のブロッカー。
+       * @param blocker 全駒の配置のビットボード。
        * @return ビットボード。
        */
-      static constexpr Bitboard GetQueenMagic(Square square,
-      Bitboard blocker_0, Bitboard blocker_45,
-      Bitboard blocker_90, Bitboard blocker_135) {
-        return MetaUtil::ATTACK_TABLE[square]
-        [(blocker_0 >> MAGIC_SHIFT[square][R0])
-        & MAGIC_MASK[square][R0]][R0]
-        | MetaUtil::ATTACK_TABLE[square]
-        [(blocker_45 >> MAGIC_SHIFT[square][R45])
-        & MAGIC_MASK[square][R45]][R45]
-        | MetaUtil::ATTACK_TABLE[square]
-        [(blocker_90 >> MAGIC_SHIFT[square][R90])
-        & MAGIC_MASK[square][R90]][R90]
-        | MetaUtil::ATTACK_TABLE[square]
-        [(blocker_135 >> MAGIC_SHIFT[square][R135])
-        & MAGIC_MASK[square][R135]][R135];
+      static Bitboard GetQueenMagic(Square square, Bitboard blocker) {
+        return GetBishopMagic(square, blocker)
+        | GetRookMagic(square, blocker);
       }
       /**
        * ポーンの動ける位置を得る。
        * @param side ポーンのサイド。
        * @param square 基点。
-       * @param blocker_90 全駒の配置のビットボード。 角度90度。
+       * @param blocker 全駒の配置のビットボード。
        * @return ポーン動ける位置。
        */
       static constexpr Bitboard GetPawnMovable(Side side, Square square,
-      Bitboard blocker_90) {
-        return MetaUtil::PAWN_MOVABLE_TABLE[side][square]
-        [(blocker_90 >> MAGIC_SHIFT[square][R90])
-        & MAGIC_MASK[square][R90]];
+      Bitboard blocker) {
+        // 1歩目が塞がれていれば、2歩目も動けない。
+        return (PAWN_MOVE[side][square] & ~blocker)
+        ? ((PAWN_MOVE[side][square] | PAWN_2STEP_MOVE[side][square])
+        & ~blocker) : 0;
       }
 
       // ==================== //
@@ -2375,23 +1408,30 @@ namespace Sayuri {
 
       /**
        * 立っているビットの数を数える。
+       * (SAYURI_BUILTIN_POPCOUNTが定義されていればPOPCNT命令を使う。)
        * @param bitboard 対象のビットボード。
        * @return 立っているビットボードの数。
        */
       static constexpr int CountBits(Bitboard bitboard) {
-        return MetaUtil::NUM_BIT16_TABLE[bitboard & 0xffff]
-        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 16) & 0xffff]
-        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 32) & 0xffff]
-        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 48) & 0xffff];
+#if defined(SAYURI_BUILTIN_POPCOUNT)
+        return __builtin_popcountll(bitboard);
+#else
+        return CountBitsByTable(bitboard);
+#endif
       }
 
       /**
        * 最下位で連続しているゼロビットの数を数える。
+       * (SAYURI_BUILTIN_CTZが定義されていればBSF/TZCNT命令を使う。)
        * @param bitboard 対象のビットボード。
-       * @最下位で連続しているゼロビットの数。
+       * @return 最下位で連続しているゼロビットの数。 (0なら64。)
        */
       static constexpr int CountZero(Bitboard bitboard) {
-        return CountBits((bitboard & (-bitboard)) - 1);
+#if defined(SAYURI_BUILTIN_CTZ)
+        return bitboard ? __builtin_ctzll(bitboard) : 64;
+#else
+        return CountZeroByTable(bitboard);
+#endif
       }
 
       /**
@@ -2403,6 +1443,29 @@ namespace Sayuri {
         return CountZero(bitboard);
       }
 
+      /**
+       * 立っているビットの数をテーブルで数える。
+       * (組み込み関数が使えない環境用と、コンパイル時の計算用。)
+       * @param bitboard 対象のビットボード。
+       * @return 立っているビットボードの数。
+       */
+      static constexpr int CountBitsByTable(Bitboard bitboard) {
+        return MetaUtil::NUM_BIT16_TABLE[bitboard & 0xffff]
+        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 16) & 0xffff]
+        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 32) & 0xffff]
+        + MetaUtil::NUM_BIT16_TABLE[(bitboard >> 48) & 0xffff];
+      }
+
+      /**
+       * 最下位で連続しているゼロビットの数をテーブルで数える。
+       * (組み込み関数が使えない環境用と、コンパイル時の計算用。)
+       * @param bitboard 対象のビットボード。
+       * @return 最下位で連続しているゼロビットの数。 (0なら64。)
+       */
+      static constexpr int CountZeroByTable(Bitboard bitboard) {
+        return CountBitsByTable((bitboard & (-bitboard)) - 1);
+      }
+
       /**
        * マス間の距離を得る。 (キングの歩数)
        * @param square_1 マス1。
@@ -2581,8 +1644,18 @@ namespace Sayuri {
        */
       static std::string ParseAlgebraicNotation(const std::string& note);
 
-      // ランダムな数値を得る。
-      static Hash GetRandomHash() {return dist_(engine_);}
+      /**
+       * 局面のハッシュ値の要素を生成する。 (SplitMix64)
+       * 同じ種と番号からは必ず同じ値になり、コンパイル時にも計算できる。
+       * SplitMix64は全単射なので、番号が違えば値も必ず違う。
+       * @param seed 種。
+       * @param index 番号。
+       * @return ハッシュ値の要素。
+       */
+      static constexpr Hash GetHashKey(Hash seed, int index) {
+        return SplitMix64Mix3(SplitMix64Mix2(SplitMix64Mix1(seed
+        + ((static_cast<Hash>(index) + 1) * 0x9e3779b97f4a7c15ULL))));
+      }
 
       // ==================== //
       // コンストラクタと代入 //
@@ -2601,16 +1674,99 @@ namespace Sayuri {
       virtual ~Util();
 
     private:
-      // ================== //
-      // その他のstatic変数 //
-      // ================== //
-      // --- ランダム用オブジェクト --- //
-      /** メルセンヌツイスターエンジン。 */
-      static std::mt19937 engine_;
-      /** 線形分布。 */
-      static std::uniform_int_distribution<Hash> dist_;
-      /** ランダム用オブジェクトを初期化する。 */
-      static void InitRandom();
+      // ========== //
+      // マジック用 //
+      // ========== //
+      /** 1マス分のマジックのデータ。 */
+      struct MagicEntry {
+        /** 利き筋に関係するブロッカーのマスク。 (盤の端を除く。) */
+        Bitboard mask_;
+        /** マジックナンバー。 */
+        Bitboard magic_;
+        /** インデックスを得るためのシフトの数。 */
+        int shift_;
+        /** 利き筋のテーブルのこのマスの先頭。 */
+        const Bitboard* attack_ptr_;
+      };
+
+      /** ビショップの利き筋のテーブルの大きさ。 */
+      static constexpr std::size_t BISHOP_ATTACK_TABLE_SIZE = 0x1480;
+      /** ルークの利き筋のテーブルの大きさ。 */
+      static constexpr std::size_t ROOK_ATTACK_TABLE_SIZE = 0x19000;
+
+      /** ビショップのマジック。 [マス] */
+      static MagicEntry bishop_magic_[NUM_SQUARES];
+      /** ルークのマジック。 [マス] */
+      static MagicEntry rook_magic_[NUM_SQUARES];
+      /** ビショップの利き筋のテーブル。 [インデックス] */
+      static Bitboard bishop_attack_table_[BISHOP_ATTACK_TABLE_SIZE];
+      /** ルークの利き筋のテーブル。 [インデックス] */
+      static Bitboard rook_attack_table_[ROOK_ATTACK_TABLE_SIZE];
+
+      /**
+       * ブロッカーから利き筋のテーブルのインデックスを得る。
+       * (SAYURI_USE_PEXTが定義されていればPEXT命令を使う。)
+       * @param entry マスのマジックのデータ。
+       * @param blocker 全駒の配置のビットボード。
+       * @return インデックス。
+       */
+      static std::size_t GetMagicIndex(const MagicEntry& entry,
+      Bitboard blocker) {
+#if defined(SAYURI_USE_PEXT)
+        return _pext_u64(blocker, entry.mask_);
+#else
+        return ((blocker & entry.mask_) * entry.magic_) >> entry.shift_;
+#endif
+      }
+
+      /**
+       * マジックのデータと利き筋のテーブルを作る。
+       * @param magic_array 作るマジックのデータ。 [マス]
+       * @param attack_table 作る利き筋のテーブル。
+       * @param magic_numbers マジックナンバー。 [マス]
+       * @param shift_funcs 利き筋の方向に1マス動かす関数。 [方向]
+       */
+      static void InitMagic(MagicEntry (& magic_array)[NUM_SQUARES],
+      Bitboard* attack_table, const Bitboard (& magic_numbers)[NUM_SQUARES],
+      Bitboard (* const (& shift_funcs)[4])(Bitboard));
+
+      /**
+       * 1マスずつ辿って利き筋を作る。
+       * @param square 基点。
+       * @param blocker 全駒の配置のビットボード。
+       * @param shift_funcs 利き筋の方向に1マス動かす関数。 [方向]
+       * @return 利き筋。
+       */
+      static Bitboard GenSlidingAttack(Square square, Bitboard blocker,
+      Bitboard (* const (& shift_funcs)[4])(Bitboard));
+
+      // ================ //
+      // プライベート関数 //
+      // ================ //
+      /**
+       * SplitMix64の1段目。
+       * @param z 入力。
+       * @return 出力。
+       */
+      static constexpr Hash SplitMix64Mix1(Hash z) {
+        return (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      }
+      /**
+       * SplitMix64の2段目。
+       * @param z 入力。
+       * @return 出力。
+       */
+      static constexpr Hash SplitMix64Mix2(Hash z) {
+        return (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      }
+      /**
+       * SplitMix64の3段目。
+       * @param z 入力。
+       * @return 出力。
+       */
+      static constexpr Hash SplitMix64Mix3(Hash z) {
+        return z ^ (z >> 31);
+      }
   };
 }  // namespace Sayuri
 
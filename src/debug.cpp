@@ -429,6 +429,49 @@ namespace Sayuri {
     std::cout << "Current Hash: " << record.pos_hash() << std::endl;
   }
 
+  // ビット演算のマイクロベンチマーク。
+  void BenchmarkBitOperations(u64 num_loops) {
+    // 入力のビットボード。 (乱数で作っておく。)
+    constexpr std::size_t NUM_SAMPLES = 1024;
+    Bitboard samples[NUM_SAMPLES];
+    std::mt19937_64 engine(0x5a7e1ed5ca1ab1e5ULL);
+    for (auto& bb : samples) {
+      // ビットの数がまばらになるように、乱数をANDする。
+      bb = engine() & engine() & engine();
+    }
+
+    StopWatch watch;
+    // 1回あたりのナノ秒を出力する。
+    auto print = [&watch, num_loops](const std::string& name, u64 sum) {
+      double nanos = static_cast<double>(watch.GetTime()) * 1000000.0
+      / static_cast<double>(num_loops);
+      std::cout << name << ": " << nanos << " ns/call (sum " << sum << ")"
+      << std::endl;
+    };
+
+    // 計測する。
+    auto measure = [&samples, &watch, &print, num_loops]
+    (const std::string& name, int (* func)(Bitboard)) {
+      volatile u64 sum = 0;
+      u64 temp = 0;
+      watch.Start();
+      for (u64 i = 0; i < num_loops; ++i) {
+        temp += func(samples[i & (NUM_SAMPLES - 1)] ^ temp);
+      }
+      watch.Stop();
+      sum = temp;
+      print(name, sum);
+    };
+
+    measure("CountBits", [](Bitboard bb) {return Util::CountBits(bb);});
+    measure("CountBitsByTable",
+    [](Bitboard bb) {return Util::CountBitsByTable(bb);});
+    measure("GetSquare",
+    [](Bitboard bb) {return static_cast<int>(Util::GetSquare(bb));});
+    measure("CountZeroByTable",
+    [](Bitboard bb) {return Util::CountZeroByTable(bb);});
+  }
+
   // ================ //
   // ストップウォッチ //
   // ================ //
@@ -102,6 +102,14 @@ namespace Sayuri {
    */
   // void PrintValueTable(const Evaluator& evaluator);
 
+  /**
+   * ビット演算のマイクロベンチマーク。
+   * Util::CountBits()とUtil::GetSquare()の1回あたりの時間を、
+   * テーブル版と比較して出力する。
+   * @param num_loops 各関数を呼ぶ回数。
+   */
+  void BenchmarkBitOperations(u64 num_loops);
+
   // ================ //
   // ストップウォッチ //
   // ================ //
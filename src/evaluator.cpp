@@ -71,7 +71,7 @@ namespace Sayuri {
       if (engine.basic_st_.en_passant_square_
       && (SIDE == engine.basic_st_.to_move_)) {
         en_passant =
-        Util::SQUARE[engine.basic_st_.en_passant_square_][R0] & attacks;
+        Util::SQUARE[engine.basic_st_.en_passant_square_] & attacks;
       }
     }
   };
@@ -116,28 +116,6 @@ namespace Sayuri {
     }
   };
 
-  // 駒の配置価値を計算するテンプレート部品。
-  template<Side SIDE, PieceType TYPE>
-  struct CalPosition {
-    static void F(Evaluator& evaluator, Square square) {}
-  };
-  template<PieceType TYPE>
-  struct CalPosition<WHITE, TYPE> {
-    static void F(Evaluator& evaluator, Square square) {
-      evaluator.score_ +=
-      evaluator.cache_ptr_->opening_position_cache_[TYPE][square]
-      + evaluator.cache_ptr_->ending_position_cache_[TYPE][square];
-    }
-  };
-  template<PieceType TYPE>
-  struct CalPosition<BLACK, TYPE> {
-    static void F(Evaluator& evaluator, Square square) {
-      evaluator.score_ -=
-      evaluator.cache_ptr_->opening_position_cache_[TYPE][Util::FLIP[square]]
-      + evaluator.cache_ptr_->ending_position_cache_[TYPE][Util::FLIP[square]];
-    }
-  };
-
   // 駒の機動力を計算するテンプレート部品。
   template<Side SIDE, PieceType TYPE>
   struct CalMobility {
@@ -176,36 +154,13 @@ namespace Sayuri {
     static void F(Evaluator& evaluator,
     const ChessEngine::BasicStruct& basic_st,
     Square square, Bitboard attacks) {
-      constexpr Side ENEMY_SIDE = Util::GetOppositeSide(SIDE);
       constexpr int SIGN = SIDE == WHITE ? 1 : -1;
 
-      // パスポーンを計算。
-      if (!(basic_st.position_[ENEMY_SIDE][PAWN]
-      & Evaluator::PASS_PAWN_MASK[SIDE][square])) {
-        evaluator.score_ += SIGN * evaluator.cache_ptr_->pass_pawn_cache_;
+      // パスポーン、ダブルポーン、孤立ポーンは
+      // ポーンのハッシュテーブルを使ってEvaluate()で計算する。
 
-        // 守られたパスポーン。
-        if (basic_st.position_[SIDE][PAWN]
-        & Util::PAWN_ATTACK[ENEMY_SIDE][square]) {
-          evaluator.score_ +=
-          SIGN * evaluator.cache_ptr_->protected_pass_pawn_cache_;
-        }
-      }
-
-      // ダブルポーンを計算。
-      if ((basic_st.position_[SIDE][PAWN]
-      & Util::FYLE[Util::SquareToFyle(square)] & ~Util::SQUARE[square][R0])) {
-        evaluator.score_ += SIGN * evaluator.cache_ptr_->double_pawn_cache_;
-      }
-
-      // 孤立ポーンを計算。
-      if (!(basic_st.position_[SIDE][PAWN]
-      & Evaluator::ISO_PAWN_MASK[square])) {
-        evaluator.score_ += SIGN * evaluator.cache_ptr_->iso_pawn_cache_;
-      }
-
-      // ポーンの盾を計算。
-      if ((Util::SQUARE[square][R0]
+      // ポーンの盾を計算。 (キングの位置で変わる。)
+      if ((Util::SQUARE[square]
       & Evaluator::PAWN_SHIELD_MASK[SIDE][basic_st.king_[SIDE]])) {
         if (SIDE == WHITE) {
           evaluator.score_ +=
@@ -225,7 +180,7 @@ namespace Sayuri {
       constexpr int SIGN = SIDE == WHITE ? 1 : -1;
 
       // バッドビショップを計算。
-      if ((Util::SQUARE[square][R0] & Util::SQCOLOR[WHITE])) {
+      if ((Util::SQUARE[square] & Util::SQCOLOR[WHITE])) {
         evaluator.score_ += SIGN * evaluator.cache_ptr_->bad_bishop_cache_
         [Util::CountBits
         (basic_st.position_[SIDE][PAWN] & Util::SQCOLOR[WHITE])];
@@ -266,7 +221,7 @@ namespace Sayuri {
       constexpr int SIGN = SIDE == WHITE ? 1 : -1;
 
       // クイーンの早過ぎる始動を計算。
-      if (!(Util::SQUARE[square][R0]
+      if (!(Util::SQUARE[square]
       & Evaluator::START_POSITION[SIDE][QUEEN])) {
         evaluator.score_ +=
         SIGN * evaluator.cache_ptr_->early_queen_starting_cache_
@@ -305,17 +260,36 @@ namespace Sayuri {
   // ==================== //
   // コンストラクタ。
   Evaluator::Evaluator(const ChessEngine& engine)
-  : engine_ptr_(&engine), score_(0), cache_ptr_(nullptr) {}
+  : engine_ptr_(&engine), score_(0), cache_ptr_(nullptr),
+  pawn_table_(new PawnTableEntry[PAWN_TABLE_SIZE]()),
+  pawn_table_probes_(0), pawn_table_hits_(0),
+  eval_table_(nullptr), eval_table_num_entries_(0),
+  eval_table_probes_(0), eval_table_hits_(0) {}
 
   // コピーコンストラクタ。
+  // ポーンのハッシュテーブルはコピーせず、新しく作る。
+  // 評価値のハッシュテーブルはPrepareEvalTable()で作る。
   Evaluator::Evaluator(const Evaluator& eval)
   : engine_ptr_(eval.engine_ptr_), score_(0),
-  cache_ptr_(nullptr) {}
+  cache_ptr_(nullptr),
+  pawn_table_(new PawnTableEntry[PAWN_TABLE_SIZE]()),
+  pawn_table_probes_(0), pawn_table_hits_(0),
+  eval_table_(nullptr), eval_table_num_entries_(0),
+  eval_table_probes_(0), eval_table_hits_(0) {}
 
   // ムーブコンストラクタ。
   Evaluator::Evaluator(Evaluator&& eval)
   : engine_ptr_(eval.engine_ptr_), score_(0),
-  cache_ptr_(nullptr) {}
+  cache_ptr_(nullptr),
+  pawn_table_(std::move(eval.pawn_table_)),
+  pawn_table_probes_(eval.pawn_table_probes_),
+  pawn_table_hits_(eval.pawn_table_hits_),
+  eval_table_(std::move(eval.eval_table_)),
+  eval_table_num_entries_(eval.eval_table_num_entries_),
+  eval_table_probes_(eval.eval_table_probes_),
+  eval_table_hits_(eval.eval_table_hits_) {
+    eval.eval_table_num_entries_ = 0;
+  }
 
   // コピー代入演算子。
   Evaluator& Evaluator::operator=(const Evaluator& eval) {
@@ -341,17 +315,169 @@ namespace Sayuri {
   // ============== //
   // 現在の局面の評価値を計算する。
   int Evaluator::Evaluate(int material) {
+    int score = CalPositionalScore();
+
+    // 手番に合わせて符号を変えて返す。
+    return engine_ptr_->basic_st_.to_move_ == WHITE ? (material + score)
+    : (material - score);
+  }
+
+  // 評価値のハッシュテーブルを使って、現在の局面の評価値を計算する。
+  int Evaluator::Evaluate(Hash pos_hash, int material) {
+    if (!eval_table_num_entries_) return Evaluate(material);
+
+    const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
+
+    // ポジショナル評価値は局面だけで決まるので、
+    // 同じ局面ならテーブルの値をそのまま使う。
+    // キャスリングしたかどうかはハッシュ値に含まれないので、別に確かめる。
+    u32 has_castled = (basic_st.has_castled_[WHITE] ? 1 : 0)
+    | (basic_st.has_castled_[BLACK] ? 2 : 0);
+    EvalTableEntry& entry =
+    eval_table_[pos_hash & (eval_table_num_entries_ - 1)];
+    ++eval_table_probes_;
+    int score = 0;
+    if ((entry.pos_hash_ == pos_hash) && (entry.has_castled_ == has_castled)) {
+      ++eval_table_hits_;
+      score = entry.score_;
+    } else {
+      score = CalPositionalScore();
+      entry.pos_hash_ = pos_hash;
+      entry.score_ = score;
+      entry.has_castled_ = has_castled;
+    }
+
+    // 手番に合わせて符号を変えて返す。
+    return basic_st.to_move_ == WHITE ? (material + score)
+    : (material - score);
+  }
+
+  // 評価値のハッシュテーブルを準備する。
+  void Evaluator::PrepareEvalTable(std::size_t table_size) {
+    // エントリーの数は2の累乗に切り下げる。
+    std::size_t num_entries = table_size / sizeof(EvalTableEntry);
+    if (num_entries) {
+      std::size_t temp = 1;
+      while ((temp << 1) <= num_entries) temp <<= 1;
+      num_entries = temp;
+    }
+
+    if (num_entries != eval_table_num_entries_) {
+      eval_table_.reset
+      (num_entries ? new EvalTableEntry[num_entries]() : nullptr);
+      eval_table_num_entries_ = num_entries;
+    } else {
+      for (std::size_t i = 0; i < eval_table_num_entries_; ++i) {
+        eval_table_[i] = EvalTableEntry();
+      }
+    }
+  }
+
+  // ======================== //
+  // ポーンのハッシュテーブル //
+  // ======================== //
+  // ポーンの配置だけで決まる要素を数えて、エントリーに書き込む。
+  template<Side SIDE>
+  void Evaluator::CountPawnStructure(PawnTableEntry& entry) const {
+    constexpr Side ENEMY_SIDE = Util::GetOppositeSide(SIDE);
+
+    const Bitboard (& position)[NUM_SIDES][NUM_PIECE_TYPES] =
+    engine_ptr_->basic_st_.position_;
+
+    entry.pawns_[SIDE] = position[SIDE][PAWN];
+    entry.num_pass_pawns_[SIDE] = 0;
+    entry.num_protected_pass_pawns_[SIDE] = 0;
+    entry.num_double_pawns_[SIDE] = 0;
+    entry.num_iso_pawns_[SIDE] = 0;
+
+    for (Bitboard pieces = position[SIDE][PAWN]; pieces;
+    NEXT_BITBOARD(pieces)) {
+      Square square = Util::GetSquare(pieces);
+
+      // パスポーン。
+      if (!(position[ENEMY_SIDE][PAWN] & PASS_PAWN_MASK[SIDE][square])) {
+        ++entry.num_pass_pawns_[SIDE];
+
+        // 守られたパスポーン。
+        if ((position[SIDE][PAWN] & Util::PAWN_ATTACK[ENEMY_SIDE][square])) {
+          ++entry.num_protected_pass_pawns_[SIDE];
+        }
+      }
+
+      // ダブルポーン。
+      if ((position[SIDE][PAWN] & Util::FYLE[Util::SquareToFyle(square)]
+      & ~Util::SQUARE[square])) {
+        ++entry.num_double_pawns_[SIDE];
+      }
+
+      // 孤立ポーン。
+      if (!(position[SIDE][PAWN] & ISO_PAWN_MASK[square])) {
+        ++entry.num_iso_pawns_[SIDE];
+      }
+    }
+  }
+
+  // ポーンのハッシュテーブルからエントリーを得る。
+  const Evaluator::PawnTableEntry& Evaluator::GetPawnTableEntry() {
+    const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
+
+    // インデックスはポーンの配置のハッシュ。
+    // ハッシュが古くても間違えないよう、ポーンの配置そのもので確かめる。
+    PawnTableEntry& entry =
+    pawn_table_[basic_st.pawn_hash_ & (PAWN_TABLE_SIZE - 1)];
+    ++pawn_table_probes_;
+    if ((entry.pawns_[WHITE] == basic_st.position_[WHITE][PAWN])
+    && (entry.pawns_[BLACK] == basic_st.position_[BLACK][PAWN])) {
+      ++pawn_table_hits_;
+      return entry;
+    }
+
+    CountPawnStructure<WHITE>(entry);
+    CountPawnStructure<BLACK>(entry);
+    return entry;
+  }
+
+  // ================== //
+  // 価値を計算する関数 //
+  // ================== //
+  // 現在の局面のポジショナル評価値を計算する。
+  int Evaluator::CalPositionalScore() {
     // 準備。
     const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
     // 初期化。
     cache_ptr_ = &(engine_ptr_->shared_st_ptr_->cache_.eval_cache_
-    [Util::CountBits(basic_st.blocker_[R0])]);
+    [Util::CountBits(basic_st.blocker_)]);
     score_ = 0;
 
     const Bitboard (& position)[NUM_SIDES][NUM_PIECE_TYPES] =
     basic_st.position_;
 
+    // --- ポーンの構造 --- //
+    {
+      const PawnTableEntry& entry = GetPawnTableEntry();
+      score_ += cache_ptr_->pass_pawn_cache_
+      * (entry.num_pass_pawns_[WHITE] - entry.num_pass_pawns_[BLACK]);
+      score_ += cache_ptr_->protected_pass_pawn_cache_
+      * (entry.num_protected_pass_pawns_[WHITE]
+      - entry.num_protected_pass_pawns_[BLACK]);
+      score_ += cache_ptr_->double_pawn_cache_
+      * (entry.num_double_pawns_[WHITE] - entry.num_double_pawns_[BLACK]);
+      score_ += cache_ptr_->iso_pawn_cache_
+      * (entry.num_iso_pawns_[WHITE] - entry.num_iso_pawns_[BLACK]);
+    }
+
     // --- 全体計算 --- //
+    // オープニング、エンディング時の駒の配置。
+    // 配置の価値の合計はPutPiece()で差分更新されているので、重みを掛けるだけ。
+    for (PieceType piece_type = PAWN; piece_type <= KING; ++piece_type) {
+      score_ += static_cast<int>
+      (cache_ptr_->opening_position_weight_cache_[piece_type]
+      * basic_st.opening_position_sum_[piece_type]);
+      score_ += static_cast<int>
+      (cache_ptr_->ending_position_weight_cache_[piece_type]
+      * basic_st.ending_position_sum_[piece_type]);
+    }
+
     // 駒の展開。
     for (PieceType piece_type = PAWN; piece_type <= KING; ++piece_type) {
       score_ += cache_ptr_->development_cache_[piece_type]
@@ -479,14 +605,9 @@ namespace Sayuri {
     // 256で割る。
     score_ >>= 8;
 
-    // 手番に合わせて符号を変えて返す。
-    return basic_st.to_move_ == WHITE ? (material + score_)
-    : (material - score_);
+    return score_;
   }
 
-  // ================== //
-  // 価値を計算する関数 //
-  // ================== //
   // 各駒の価値を計算する。
   template<Side SIDE, PieceType TYPE>
   void Evaluator::CalValue(Square piece_square) {
@@ -504,9 +625,6 @@ namespace Sayuri {
     pawn_moves, en_passant);
 
     // --- 全駒共通 --- //
-    // オープニング、エンディング時の駒の配置を計算。
-    CalPosition<SIDE, TYPE>::F(*this, piece_square);
-
     // 機動力を計算。
     CalMobility<SIDE, TYPE>::F
     (*this, basic_st, attacks, pawn_moves, en_passant);
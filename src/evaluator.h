@@ -32,6 +32,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <memory>
 #include "common.h"
 
 /** Sayuri 名前空間。 */
@@ -137,6 +138,52 @@ namespace Sayuri {
        */
       int Evaluate(int material);
 
+      /**
+       * 評価値のハッシュテーブルを使って、現在の局面の評価値を計算する。
+       * @param pos_hash 現在の局面のハッシュ値。
+       * @param material 現在のマテリアル。
+       * @return 評価値。
+       */
+      int Evaluate(Hash pos_hash, int material);
+
+      /**
+       * 評価値のハッシュテーブルを準備する。
+       * サイズが変われば作り直し、変わらなければクリアする。
+       * (評価関数のパラメータは探索毎に変わりうるので、探索の開始時に呼ぶ。)
+       * @param table_size テーブルのサイズ。 (バイト) 0なら使わない。
+       */
+      void PrepareEvalTable(std::size_t table_size);
+
+      /** ポーンと評価値のハッシュテーブルの統計を0にする。 */
+      void ResetTableStats() {
+        pawn_table_probes_ = pawn_table_hits_ = 0;
+        eval_table_probes_ = eval_table_hits_ = 0;
+      }
+
+      // ======== //
+      // アクセサ //
+      // ======== //
+      /**
+       * アクセサ - ポーンのハッシュテーブルを調べた回数。
+       * @return ポーンのハッシュテーブルを調べた回数。
+       */
+      u64 pawn_table_probes() const {return pawn_table_probes_;}
+      /**
+       * アクセサ - ポーンのハッシュテーブルにヒットした回数。
+       * @return ポーンのハッシュテーブルにヒットした回数。
+       */
+      u64 pawn_table_hits() const {return pawn_table_hits_;}
+      /**
+       * アクセサ - 評価値のハッシュテーブルを調べた回数。
+       * @return 評価値のハッシュテーブルを調べた回数。
+       */
+      u64 eval_table_probes() const {return eval_table_probes_;}
+      /**
+       * アクセサ - 評価値のハッシュテーブルにヒットした回数。
+       * @return 評価値のハッシュテーブルにヒットした回数。
+       */
+      u64 eval_table_hits() const {return eval_table_hits_;}
+
     private:
       /** フレンドのデバッグ用関数。 */
       friend int DebugMain(int argc, char* argv[]);
@@ -157,15 +204,68 @@ namespace Sayuri {
       template<Side SIDE, PieceType TYPE>
       void CalValue(Square piece_square);
 
+      /**
+       * 現在の局面のポジショナル評価値を計算する。
+       * @return 白から見たポジショナル評価値。 (マテリアルを含まない)
+       */
+      int CalPositionalScore();
+
+      // ======================== //
+      // ポーンのハッシュテーブル //
+      // ======================== //
+      /** ポーンのハッシュテーブルのエントリー。 */
+      struct PawnTableEntry {
+        /** ポーンの配置。 [サイド] */
+        Bitboard pawns_[NUM_SIDES];
+        /** パスポーンの数。 [サイド] */
+        u8 num_pass_pawns_[NUM_SIDES];
+        /** 守られたパスポーンの数。 [サイド] */
+        u8 num_protected_pass_pawns_[NUM_SIDES];
+        /** ダブルポーンの数。 [サイド] */
+        u8 num_double_pawns_[NUM_SIDES];
+        /** 孤立ポーンの数。 [サイド] */
+        u8 num_iso_pawns_[NUM_SIDES];
+      };
+      /** ポーンのハッシュテーブルのエントリーの数。 (2の累乗) */
+      static constexpr u32 PAWN_TABLE_SIZE = 1U << 13;
+
+      /**
+       * ポーンの配置だけで決まる要素を数えて、エントリーに書き込む。
+       * @param <SIDE> 数えるサイド。
+       * @param entry 書き込むエントリー。
+       */
+      template<Side SIDE>
+      void CountPawnStructure(PawnTableEntry& entry) const;
+
+      /**
+       * ポーンのハッシュテーブルからエントリーを得る。
+       * 無ければ計算して登録する。
+       * @return 現在のポーンの配置のエントリー。
+       */
+      const PawnTableEntry& GetPawnTableEntry();
+
+      // ======================== //
+      // 評価値のハッシュテーブル //
+      // ======================== //
+      /** 評価値のハッシュテーブルのエントリー。 */
+      struct EvalTableEntry {
+        /** 局面のハッシュ値。 */
+        Hash pos_hash_;
+        /** 白から見たポジショナル評価値。 */
+        int score_;
+        /**
+         * キャスリングしたかどうか。 (白なら1ビット目、黒なら2ビット目)
+         * 局面のハッシュ値に含まれないので、別に確かめる。
+         */
+        u32 has_castled_;
+      };
+
       // --- テンプレート部品 --- //
       /** 評価関数で使うテンプレート部品。 */
       template<Side SIDE, PieceType TYPE>
       friend struct GenBitboards;
       /** 評価関数で使うテンプレート部品。 */
       template<Side SIDE, PieceType TYPE>
-      friend struct CalPosition;
-      /** 評価関数で使うテンプレート部品。 */
-      template<Side SIDE, PieceType TYPE>
       friend struct CalMobility;
       /** 評価関数で使うテンプレート部品。 */
       template<Side SIDE, PieceType TYPE>
@@ -179,17 +279,17 @@ namespace Sayuri {
         {0, 0, 0, 0, 0, 0, 0},
         {
           0, Util::RANK[RANK_2],
-          Util::SQUARE[B1][R0] | Util::SQUARE[G1][R0],
-          Util::SQUARE[C1][R0] | Util::SQUARE[F1][R0],
-          Util::SQUARE[A1][R0] | Util::SQUARE[H1][R0],
-          Util::SQUARE[D1][R0], Util::SQUARE[E1][R0]
+          Util::SQUARE[B1] | Util::SQUARE[G1],
+          Util::SQUARE[C1] | Util::SQUARE[F1],
+          Util::SQUARE[A1] | Util::SQUARE[H1],
+          Util::SQUARE[D1], Util::SQUARE[E1]
         },
         {
           0, Util::RANK[RANK_7],
-          Util::SQUARE[B8][R0] | Util::SQUARE[G8][R0],
-          Util::SQUARE[C8][R0] | Util::SQUARE[F8][R0],
-          Util::SQUARE[A8][R0] | Util::SQUARE[H8][R0],
-          Util::SQUARE[D8][R0], Util::SQUARE[E8][R0]
+          Util::SQUARE[B8] | Util::SQUARE[G8],
+          Util::SQUARE[C8] | Util::SQUARE[F8],
+          Util::SQUARE[A8] | Util::SQUARE[H8],
+          Util::SQUARE[D8], Util::SQUARE[E8]
         }
       };
       static constexpr Bitboard NOT_START_POSITION
@@ -215,18 +315,18 @@ namespace Sayuri {
 
       /** センターのマスク。 */
       static constexpr Bitboard CENTER_MASK = 
-      Util::SQUARE[C3][R0] | Util::SQUARE[C4][R0]
-      | Util::SQUARE[C5][R0] | Util::SQUARE[C6][R0]
-      | Util::SQUARE[D3][R0] | Util::SQUARE[D4][R0]
-      | Util::SQUARE[D5][R0] | Util::SQUARE[D6][R0]
-      | Util::SQUARE[E3][R0] | Util::SQUARE[E4][R0]
-      | Util::SQUARE[E5][R0] | Util::SQUARE[E6][R0]
-      | Util::SQUARE[F3][R0] | Util::SQUARE[F4][R0]
-      | Util::SQUARE[F5][R0] | Util::SQUARE[F6][R0];
+      Util::SQUARE[C3] | Util::SQUARE[C4]
+      | Util::SQUARE[C5] | Util::SQUARE[C6]
+      | Util::SQUARE[D3] | Util::SQUARE[D4]
+      | Util::SQUARE[D5] | Util::SQUARE[D6]
+      | Util::SQUARE[E3] | Util::SQUARE[E4]
+      | Util::SQUARE[E5] | Util::SQUARE[E6]
+      | Util::SQUARE[F3] | Util::SQUARE[F4]
+      | Util::SQUARE[F5] | Util::SQUARE[F6];
       /** スウィートセンターのマスク。 */
       static constexpr Bitboard SWEET_CENTER_MASK =
-      Util::SQUARE[D4][R0] | Util::SQUARE[D5][R0]
-      | Util::SQUARE[E4][R0] | Util::SQUARE[E5][R0];
+      Util::SQUARE[D4] | Util::SQUARE[D5]
+      | Util::SQUARE[E4] | Util::SQUARE[E5];
 
       /** パスポーンの前方3列のマスク。 [サイド][マス] */
       static constexpr Bitboard PASS_PAWN_MASK [NUM_SIDES][NUM_SQUARES] {
@@ -524,6 +624,22 @@ namespace Sayuri {
 
       /** 現在のキャッシュポインタ。 */
       EvalCache* cache_ptr_;
+
+      /** ポーンのハッシュテーブル。 (スレッド毎) */
+      std::unique_ptr<PawnTableEntry[]> pawn_table_;
+      /** ポーンのハッシュテーブルを調べた回数。 */
+      u64 pawn_table_probes_;
+      /** ポーンのハッシュテーブルにヒットした回数。 */
+      u64 pawn_table_hits_;
+
+      /** 評価値のハッシュテーブル。 (スレッド毎) */
+      std::unique_ptr<EvalTableEntry[]> eval_table_;
+      /** 評価値のハッシュテーブルのエントリーの数。 (2の累乗か0) */
+      std::size_t eval_table_num_entries_;
+      /** 評価値のハッシュテーブルを調べた回数。 */
+      u64 eval_table_probes_;
+      /** 評価値のハッシュテーブルにヒットした回数。 */
+      u64 eval_table_hits_;
   };
 }  // namespace Sayuri
 
@@ -32,6 +32,7 @@
 #include <iostream>
 #include <mutex>
 #include <memory>
+#include <atomic>
 #include <condition_variable>
 #include "common.h"
 #include "chess_engine.h"
@@ -43,130 +44,197 @@ namespace Sayuri {
   // コンストラクタと代入 //
   // ==================== //
   // コンストラクタ。
-  HelperQueue::HelperQueue() : job_ptr_(nullptr), no_more_help_(false),
-  num_helpers_(0), is_root_client_waiting_(false) {}
+  HelperQueue::HelperQueue() {
+    InitMember(false);
+  }
 
   // コピーコンストラクタ。
-  HelperQueue::HelperQueue(const HelperQueue& queue) :
-  job_ptr_(queue.job_ptr_), no_more_help_(queue.no_more_help_),
-  num_helpers_(queue.num_helpers_), is_root_client_waiting_(false) {}
+  // キューに積まれた仕事は探索中のスレッドのものなので、コピーしない。
+  HelperQueue::HelperQueue(const HelperQueue& queue) {
+    InitMember(queue.no_more_help_);
+  }
 
   // ムーブコンストラクタ。
-  HelperQueue::HelperQueue(HelperQueue&& queue) :
-  job_ptr_(queue.job_ptr_), no_more_help_(queue.no_more_help_),
-  num_helpers_(queue.num_helpers_), is_root_client_waiting_(false) {}
+  HelperQueue::HelperQueue(HelperQueue&& queue) {
+    InitMember(queue.no_more_help_);
+  }
 
   // コピー代入演算子。
   HelperQueue& HelperQueue::operator=(const HelperQueue& queue) {
-    job_ptr_ = queue.job_ptr_;
-    no_more_help_ = queue.no_more_help_;
-    num_helpers_ = queue.num_helpers_;
-    is_root_client_waiting_ = queue.is_root_client_waiting_;
+    InitMember(queue.no_more_help_);
     return *this;
   }
 
   // ムーブ代入演算子。
   HelperQueue& HelperQueue::operator=(HelperQueue&& queue) {
-    job_ptr_ = queue.job_ptr_;
-    no_more_help_ = queue.no_more_help_;
-    num_helpers_ = queue.num_helpers_;
-    is_root_client_waiting_ = queue.is_root_client_waiting_;
+    InitMember(queue.no_more_help_);
     return *this;
   }
+
   // ============== //
   // パブリック関数 //
   // ============== //
   // スレッドが仕事を得る。
   Job* HelperQueue::GetJob(ChessEngine* helper_ptr) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-
-    // ヘルパーが必要なければnullptrを返す。
-    if (no_more_help_) {
-      client_cond_.notify_all();
-      return nullptr;
-    }
-
-    // 待つ。
-    // ルートノードのクライアントが待っていれば待たない。
-    if (!is_root_client_waiting_) {
-      while (!job_ptr_) {
-        ++num_helpers_;
+    while (true) {
+      // ヘルパーが必要なければnullptrを返す。
+      if (no_more_help_) return nullptr;
+
+      // 仕事を探す前の番号。
+      u64 epoch = epoch_;
+
+      // ルートノードの仕事を優先。
+      Job* job_ptr = TakeRootJob(helper_ptr);
+      if (job_ptr) return job_ptr;
+
+      // 他のスレッドから盗む。
+      job_ptr = StealJob(helper_ptr);
+      if (job_ptr) return job_ptr;
+
+      // 見つからなかったので待つ。
+      std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+      ++num_helpers_;
+      // 数えてから番号を再確認する。
+      // 探している間に積まれた仕事があれば待たずに探し直す。
+      if (!no_more_help_ && (epoch == epoch_)) {
         helper_cond_.wait(lock);
-        --num_helpers_;
-        // 待っている間にno_more_help_が立っているかもしれないので、
-        // もう一度確認。
-        // ヘルパーが必要なければnullptrを返す。
-        if (no_more_help_) {
-          client_cond_.notify_all();
-          return nullptr;
-        }
       }
+      --num_helpers_;
     }
-    is_root_client_waiting_ = false;
-
-
-    // --- 仕事の準備 --- //
-    // ヘルパー登録。
-    job_ptr_->RegisterHelper(*helper_ptr);
-
-    job_ptr_->Lock();  // ロック。
-
-    // 局面のコピー。
-    helper_ptr->basic_st_ = job_ptr_->client_ptr_->basic_st_;
+  }
 
-    // 探索状態のコピー。
-    helper_ptr->is_null_searching_ = job_ptr_->is_null_searching_;
+  // スレッドに仕事を依頼する。
+  void HelperQueue::Help(Job& job) {
+    // 既に依頼済み。
+    if (job.is_published_) return;
+    job.is_published_ = true;
 
-    job_ptr_->Unlock();  // ロック解除。
+    ChessEngine* client_ptr = job.client_ptr_;
 
-    // job_ptr_を削除。
-    Job* temp = job_ptr_;
-    job_ptr_ = nullptr;
+    // ヘルパー用に局面を保存してから受付開始。
+    // 保存した局面はWithdraw()の後、ヘルパーが全員抜けるまで変わらない。
+    client_ptr->split_st_table_[job.level_] = client_ptr->basic_st_;
+    job.Open();
 
-    // 準備完了を通知。
-    client_cond_.notify_all();
-
-    return temp;
-  }
+    // 自分のキューの底に積む。
+    SplitPointDeque& deque = deque_table_[client_ptr->thread_id_];
+    int bottom = deque.bottom_.load(std::memory_order_relaxed);
+    deque.job_table_[bottom].store(&job, std::memory_order_relaxed);
+    deque.bottom_.store(bottom + 1);
+    ++epoch_;
 
-  // スレッドに仕事を依頼する。
-  void HelperQueue::Help(Job& job) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-    
-    // ヘルパーがいれば仕事を依頼。
+    // 待機中のヘルパーがいれば起こす。
     if (num_helpers_ > 0) {
-      job_ptr_ = &job;
+      std::unique_lock<std::mutex> lock(mutex_);  // ロック。
       helper_cond_.notify_one();
-
-      // ヘルパーの準備が完了するまで待つ。
-      client_cond_.wait(lock);
     }
   }
 
   // スレッドに仕事を依頼する。 (ルートノード用)
   void HelperQueue::HelpRoot(Job& job) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    job.Open();
+    root_job_ptr_ = &job;
+    ++epoch_;
 
-    job_ptr_ = &job;
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
     helper_cond_.notify_one();
 
     // ヘルパーがやってきて、準備が完了するまで待つ。
-    is_root_client_waiting_ = true;
-    client_cond_.wait(lock);
-    is_root_client_waiting_ = false;
+    while (root_job_ptr_ && !no_more_help_) {
+      client_cond_.wait(lock);
+    }
+  }
+
+  // 依頼した仕事を取り下げる。
+  void HelperQueue::Withdraw(Job& job) {
+    job.Close();
+
+    if (!(job.is_published_)) return;
+    job.is_published_ = false;
+
+    // 分岐点は入れ子なので、取り下げる仕事は必ず底にある。
+    SplitPointDeque& deque = deque_table_[job.client_ptr_->thread_id_];
+    int bottom = deque.bottom_.load(std::memory_order_relaxed) - 1;
+    deque.bottom_.store(bottom);
+    deque.job_table_[bottom].store(nullptr, std::memory_order_relaxed);
   }
 
   // 待機中のスレッドをキューから開放する。
   void HelperQueue::ReleaseHelpers() {
     std::unique_lock<std::mutex> lock(mutex_);  // ロック。
 
-    job_ptr_ = nullptr;
+    root_job_ptr_ = nullptr;
     no_more_help_ = true;
     helper_cond_.notify_all();
+    client_cond_.notify_all();
+  }
 
-    // 無事、ヘルパーが抜けるまで待つ。
-    while (num_helpers_ > 0) {
-      client_cond_.wait(lock);
+  // ================ //
+  // プライベート関数 //
+  // ================ //
+  // 他のスレッドのキューから仕事を盗む。
+  Job* HelperQueue::StealJob(ChessEngine* helper_ptr) {
+    // 自分の次のスレッドから順番に探す。
+    int my_id = helper_ptr->thread_id_;
+    for (int i = 1; i <= UCI_MAX_THREADS; ++i) {
+      SplitPointDeque& deque =
+      deque_table_[(my_id + i) % (UCI_MAX_THREADS + 1)];
+
+      // 浅い分岐点ほど仕事が大きいので、上から探す。
+      int bottom = deque.bottom_;
+      for (int j = 0; j < bottom; ++j) {
+        Job* job_ptr = deque.job_table_[j];
+
+        // 取り下げられた仕事や、新しい仕事に置き換わった仕事も
+        // ポインタ自体は有効なので、RegisterHelper()で受付中か確認する。
+        if (job_ptr && job_ptr->RegisterHelper(*helper_ptr)) {
+          // 局面のコピー。
+          helper_ptr->basic_st_ =
+          job_ptr->client_ptr_->split_st_table_[job_ptr->level_];
+
+          // 探索状態のコピー。
+          helper_ptr->is_null_searching_ = job_ptr->is_null_searching_;
+
+          return job_ptr;
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+  // ルートノードの仕事を受け取る。
+  Job* HelperQueue::TakeRootJob(ChessEngine* helper_ptr) {
+    if (!root_job_ptr_) return nullptr;
+
+    // クライアントが準備完了前に起きないよう、ロックしてから受け取る。
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    Job* job_ptr = root_job_ptr_;
+    if (!job_ptr) return nullptr;
+    root_job_ptr_ = nullptr;
+
+    // ヘルパー登録。
+    job_ptr->RegisterHelper(*helper_ptr);
+
+    // クライアントは待っているので局面を直接コピーできる。
+    helper_ptr->basic_st_ = job_ptr->client_ptr_->basic_st_;
+    helper_ptr->is_null_searching_ = job_ptr->is_null_searching_;
+
+    // 準備完了を通知。
+    client_cond_.notify_all();
+
+    return job_ptr;
+  }
+
+  // メンバを初期化する。
+  void HelperQueue::InitMember(bool no_more_help) {
+    for (auto& deque : deque_table_) {
+      for (auto& job_ptr : deque.job_table_) job_ptr = nullptr;
+      deque.bottom_ = 0;
     }
+    root_job_ptr_ = nullptr;
+    epoch_ = 0;
+    no_more_help_ = no_more_help;
+    num_helpers_ = 0;
   }
 }  // namespace Sayuri
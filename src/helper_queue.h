@@ -32,6 +32,7 @@
 
 #include <iostream>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 #include "common.h"
 
@@ -40,7 +41,11 @@ namespace Sayuri {
   class ChessEngine;
   class Job;
 
-  /** 並列探索のスレッドのキューのクラス。 */
+  /**
+   * 並列探索のスレッドのキューのクラス。
+   * 各スレッドは自分専用の両端キューに分岐点(Job)を積み、
+   * 暇なスレッドは他のスレッドのキューから仕事を盗む。 (Work Stealing)
+   */
   class HelperQueue {
     public:
       // ==================== //
@@ -89,36 +94,93 @@ namespace Sayuri {
 
       /**
        * スレッドに仕事を依頼する。
+       * クライアントのキューに仕事を積むだけで、クライアントは待たない。
+       * 既に積んである仕事なら何もしない。
        * @param job 依頼する仕事。
        */
       void Help(Job& job);
       /**
        * スレッドに仕事を依頼する。 (ルートノード用)
+       * ヘルパーが1つ仕事を受け取るまで待つ。
        * @param job 依頼する仕事。
        */
       void HelpRoot(Job& job);
+      /**
+       * 依頼した仕事を取り下げる。
+       * 以後、新しいヘルパーはその仕事に参加できない。
+       * @param job 取り下げる仕事。
+       */
+      void Withdraw(Job& job);
 
       /** 待機中のスレッドをキューから開放する。 */
       void ReleaseHelpers();
 
+      /** 次の探索のために、空の状態に戻す。 */
+      void Reset() {InitMember(false);}
+
     private:
+      // ========== //
+      // 内部クラス //
+      // ========== //
+      /**
+       * スレッド毎の分岐点の両端キュー。
+       * 持ち主は底に積んで底から取り出し、
+       * 他のスレッドは上(浅い分岐点)から順に仕事を探す。
+       * 隣のキューと同じキャッシュラインに乗らないように詰め物をする。
+       * (C++11のnewはalignasを守らないので、詰め物で64バイトの倍数にする。)
+       */
+      struct SplitPointDeque {
+        /** 分岐点のテーブル。 [持ち主の積んだ順番] */
+        std::atomic<Job*> job_table_[MAX_PLYS + 1];
+        /** 底の位置。 */
+        std::atomic<int> bottom_;
+        /** 詰め物。 */
+        char padding_[64 - (((sizeof(std::atomic<Job*>) * (MAX_PLYS + 1))
+        + sizeof(std::atomic<int>)) % 64)];
+      };
+
+      // ================ //
+      // プライベート関数 //
+      // ================ //
+      /**
+       * 他のスレッドのキューから仕事を盗む。
+       * @param helper_ptr 盗もうとしているヘルパーのポインタ。
+       * @return 参加した仕事へのポインタ。 なければnullptr。
+       */
+      Job* StealJob(ChessEngine* helper_ptr);
+
+      /**
+       * ルートノードの仕事を受け取る。
+       * @param helper_ptr 受け取ろうとしているヘルパーのポインタ。
+       * @return 受け取った仕事へのポインタ。 なければnullptr。
+       */
+      Job* TakeRootJob(ChessEngine* helper_ptr);
+
+      /**
+       * メンバを初期化する。
+       * @param no_more_help no_more_help_の初期値。
+       */
+      void InitMember(bool no_more_help);
+
       // ========== //
       // メンバ変数 //
       // ========== //
-      /** 仕事の一時保管場所。 */
-      Job* job_ptr_;
-      /** ミューテックス。 */
+      /** スレッド毎の分岐点のキュー。 [スレッドの番号] */
+      SplitPointDeque deque_table_[UCI_MAX_THREADS + 1];
+      /** ルートノードの仕事の一時保管場所。 */
+      std::atomic<Job*> root_job_ptr_;
+      /** 仕事が積まれるたびに増える番号。 待機前の再確認に使う。 */
+      std::atomic<u64> epoch_;
+      /** 待機用ミューテックス。 */
       std::mutex mutex_;
       /** ヘルパー用コンディション。 */
       std::condition_variable helper_cond_;
       /** クライアント用コンディション。 */
       std::condition_variable client_cond_;
       /** もうヘルパーは必要ない。 */
-      volatile bool no_more_help_;
+      std::atomic<bool> no_more_help_;
       /** 待っているヘルパーの数。 */
-      volatile int num_helpers_;
-      /** ルートノードのクライアントが待っているかどうかのフラグ。 */
-      volatile bool is_root_client_waiting_;
+      std::atomic<int> num_helpers_;
   };
 }  // namespace Sayuri
 
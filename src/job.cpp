@@ -45,7 +45,8 @@ namespace Sayuri {
   // コンストラクタと代入 //
   // ==================== //
   // コンストラクタ。
-  Job::Job() : num_helpers_(0), maker_ptr_(nullptr), counter_(0) {}
+  Job::Job() : is_published_(false), num_helpers_(0), maker_ptr_(nullptr),
+  counter_(0), is_open_(false) {}
 
   // コピーコンストラクタ。
   Job::Job(const Job& job) {
@@ -76,13 +77,24 @@ namespace Sayuri {
   // ============== //
   // 候補手を得る。
   Move Job::PickMove() {
-    std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
-    return maker_ptr_->PickMove();
+    // 共有中のMoveMakerはアトミックに取り出すので、ロックしない。
+    Move move = maker_ptr_->PickMove();
+
+    // 候補手が尽きたら、新しいヘルパーは受け付けない。
+    if (!move) {
+      std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
+      is_open_ = false;
+    }
+
+    return move;
   }
 
   // ベータカットを通知する。
   void Job::NotifyBetaCut(ChessEngine& notifier) {
     std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
+    // カットされたので、新しいヘルパーは受け付けない。
+    is_open_ = false;
+
     // クライアントに通知。
     if ((client_ptr_ != &notifier)
     && (client_ptr_->notice_cut_level_ > level_)) {
@@ -122,11 +134,13 @@ namespace Sayuri {
     num_all_moves_ = job.num_all_moves_;
     has_legal_move_ = job.has_legal_move_;
     moves_to_search_ptr_ = job.moves_to_search_ptr_;
+    is_published_ = job.is_published_;
 
     COPY_ARRAY(helpers_table_, job.helpers_table_);
     end_ = (job.end_ - job.helpers_table_) + helpers_table_;
     num_helpers_ = job.num_helpers_;
     maker_ptr_ = job.maker_ptr_;
     counter_ = job.counter_;
+    is_open_ = job.is_open_;
   }
 }  // namespace Sayuri
@@ -88,6 +88,20 @@ namespace Sayuri {
         num_helpers_ = 0;
         maker_ptr_ = &maker;
         counter_ = 0;
+        is_open_ = false;
+        is_published_ = false;
+      }
+
+      /** ヘルパーの受付を開始する。 */
+      void Open() {
+        std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
+        is_open_ = true;
+      }
+
+      /** ヘルパーの受付を終了する。 */
+      void Close() {
+        std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
+        is_open_ = false;
       }
 
       /**
@@ -108,12 +122,25 @@ namespace Sayuri {
       /**
        * ヘルパー登録する。
        * @param helper 登録するヘルパー。
+       * @return 受付中で登録できたらtrue。
        */
-      void RegisterHelper(ChessEngine& helper) {
+      bool RegisterHelper(ChessEngine& helper) {
         std::unique_lock<std::mutex> lock(my_mutex_);  // ロック。
-        *end_ = &helper;
-        ++end_;
+        if (!is_open_) return false;
+
+        // 空いている場所を探す。 なければ終端に追加。
+        ChessEngine** ptrptr = helpers_table_;
+        for (; ptrptr < end_; ++ptrptr) {
+          if (!(*ptrptr)) break;
+        }
+        if (ptrptr == end_) {
+          if (end_ >= (helpers_table_ + UCI_MAX_THREADS + 1)) return false;
+          ++end_;
+        }
+
+        *ptrptr = &helper;
         ++num_helpers_;
+        return true;
       }
 
       /**
@@ -190,6 +217,8 @@ namespace Sayuri {
       volatile bool has_legal_move_;
       /** 探索する候補手のベクトルのポインタ。 */
       const std::vector<Move>* moves_to_search_ptr_;
+      /** HelperQueueのキューに積まれているかどうかのフラグ。 */
+      bool is_published_;
 
     private:
       // ================ //
@@ -221,6 +250,8 @@ namespace Sayuri {
       std::mutex my_mutex_;
       /** 候補手を数えるためのカウンター。 */
       volatile int counter_;
+      /** ヘルパーを受付中かどうかのフラグ。 */
+      bool is_open_;
   };
 }  // namespace Sayuri
 
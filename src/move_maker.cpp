@@ -30,7 +30,7 @@
 #include "move_maker.h"
 
 #include <iostream>
-#include <mutex>
+#include <atomic>
 #include <cstddef>
 #include <utility>
 #include <cstring>
@@ -47,16 +47,43 @@ namespace Sayuri {
   engine_ptr_(&engine),
   last_(0),
   max_(0),
-  history_max_(1) {}
+  history_max_(1),
+  counter_move_(0),
+  cont_history_ptr_(nullptr),
+  cont_history_max_(1),
+  killer_1_(0),
+  killer_2_(0),
+  has_unscored_captures_(false),
+  has_unscored_non_captures_(false),
+  pinned_(0),
+  checkers_(0),
+  evasion_mask_(0),
+  is_shared_(false),
+  shared_last_(0) {
+    INIT_ARRAY(pin_line_);
+  }
 
   // コピーコンストラクタ。
   MoveMaker::MoveMaker(const MoveMaker& maker) :
   engine_ptr_(maker.engine_ptr_),
   last_(maker.last_),
   max_(maker.max_),
-  history_max_(maker.history_max_) {
+  history_max_(maker.history_max_),
+  counter_move_(maker.counter_move_),
+  cont_history_ptr_(maker.cont_history_ptr_),
+  cont_history_max_(maker.cont_history_max_),
+  killer_1_(maker.killer_1_),
+  killer_2_(maker.killer_2_),
+  has_unscored_captures_(maker.has_unscored_captures_),
+  has_unscored_non_captures_(maker.has_unscored_non_captures_),
+  pinned_(maker.pinned_),
+  checkers_(maker.checkers_),
+  evasion_mask_(maker.evasion_mask_),
+  is_shared_(maker.is_shared_),
+  shared_last_(maker.shared_last_.load()) {
     COPY_ARRAY(move_stack_, maker.move_stack_);
     COPY_ARRAY(score_stack_, maker.score_stack_);
+    COPY_ARRAY(pin_line_, maker.pin_line_);
   }
 
   // ムーブコンストラクタ。
@@ -64,9 +91,22 @@ namespace Sayuri {
   engine_ptr_(maker.engine_ptr_),
   last_(maker.last_),
   max_(maker.max_),
-  history_max_(maker.history_max_) {
+  history_max_(maker.history_max_),
+  counter_move_(maker.counter_move_),
+  cont_history_ptr_(maker.cont_history_ptr_),
+  cont_history_max_(maker.cont_history_max_),
+  killer_1_(maker.killer_1_),
+  killer_2_(maker.killer_2_),
+  has_unscored_captures_(maker.has_unscored_captures_),
+  has_unscored_non_captures_(maker.has_unscored_non_captures_),
+  pinned_(maker.pinned_),
+  checkers_(maker.checkers_),
+  evasion_mask_(maker.evasion_mask_),
+  is_shared_(maker.is_shared_),
+  shared_last_(maker.shared_last_.load()) {
     COPY_ARRAY(move_stack_, maker.move_stack_);
     COPY_ARRAY(score_stack_, maker.score_stack_);
+    COPY_ARRAY(pin_line_, maker.pin_line_);
   }
 
   // コピー代入演算子。
@@ -74,10 +114,23 @@ namespace Sayuri {
   (const MoveMaker& maker) {
     engine_ptr_ = maker.engine_ptr_;
     history_max_ = maker.history_max_;
+    counter_move_ = maker.counter_move_;
+    cont_history_ptr_ = maker.cont_history_ptr_;
+    cont_history_max_ = maker.cont_history_max_;
+    killer_1_ = maker.killer_1_;
+    killer_2_ = maker.killer_2_;
+    has_unscored_captures_ = maker.has_unscored_captures_;
+    has_unscored_non_captures_ = maker.has_unscored_non_captures_;
+    pinned_ = maker.pinned_;
+    checkers_ = maker.checkers_;
+    evasion_mask_ = maker.evasion_mask_;
+    is_shared_ = maker.is_shared_;
+    shared_last_ = maker.shared_last_.load();
     last_ = maker.last_;
     max_ = maker.max_;
     COPY_ARRAY(move_stack_, maker.move_stack_);
     COPY_ARRAY(score_stack_, maker.score_stack_);
+    COPY_ARRAY(pin_line_, maker.pin_line_);
     return *this;
   }
 
@@ -86,45 +139,178 @@ namespace Sayuri {
   (MoveMaker&& maker) {
     engine_ptr_ = maker.engine_ptr_;
     history_max_ = maker.history_max_;
+    counter_move_ = maker.counter_move_;
+    cont_history_ptr_ = maker.cont_history_ptr_;
+    cont_history_max_ = maker.cont_history_max_;
+    killer_1_ = maker.killer_1_;
+    killer_2_ = maker.killer_2_;
+    has_unscored_captures_ = maker.has_unscored_captures_;
+    has_unscored_non_captures_ = maker.has_unscored_non_captures_;
+    pinned_ = maker.pinned_;
+    checkers_ = maker.checkers_;
+    evasion_mask_ = maker.evasion_mask_;
+    is_shared_ = maker.is_shared_;
+    shared_last_ = maker.shared_last_.load();
     last_ = maker.last_;
     max_ = maker.max_;
     COPY_ARRAY(move_stack_, maker.move_stack_);
     COPY_ARRAY(score_stack_, maker.score_stack_);
+    COPY_ARRAY(pin_line_, maker.pin_line_);
     return *this;
   }
 
   // ============== //
   // パブリック関数 //
   // ============== //
+  // 直前の相手の手から、カウンタームーブと継続ヒストリーを準備する。
+  inline void MoveMaker::SetLastMove(Move last_move) {
+    cont_history_max_ = 1;
+    if (!last_move) {
+      counter_move_ = 0;
+      cont_history_ptr_ = nullptr;
+      return;
+    }
+
+    const ChessEngine::OrderStruct& order_st = *(engine_ptr_->order_st_ptr_);
+    Side side = engine_ptr_->basic_st_.to_move_;
+    Square last_from = Get<FROM>(last_move);
+    Square last_to = Get<TO>(last_move);
+
+    counter_move_ = order_st.counter_move_[side][last_from][last_to];
+    cont_history_ptr_ = order_st.cont_history_
+    [engine_ptr_->basic_st_.piece_board_[last_to]][last_to];
+  }
+
+  // ピンとチェックを調べる。
+  inline void MoveMaker::SetPinsAndChecks() {
+    const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
+    Side side = basic_st.to_move_;
+    Side enemy_side = Util::GetOppositeSide(side);
+    Square king = basic_st.king_[side];
+
+    // ポーンとナイトのチェック。
+    checkers_ =
+    (Util::PAWN_ATTACK[side][king] & basic_st.position_[enemy_side][PAWN])
+    | (Util::KNIGHT_MOVE[king] & basic_st.position_[enemy_side][KNIGHT]);
+
+    // キングと同じ直線上の飛び駒。
+    // 間に駒がなければチェック。 自分の駒が1つだけならピン。
+    pinned_ = 0;
+    Bitboard queens = basic_st.position_[enemy_side][QUEEN];
+    Bitboard snipers = (Util::BISHOP_MOVE[king]
+    & (basic_st.position_[enemy_side][BISHOP] | queens))
+    | (Util::ROOK_MOVE[king]
+    & (basic_st.position_[enemy_side][ROOK] | queens));
+    for (; snipers; NEXT_BITBOARD(snipers)) {
+      Square sniper = Util::GetSquare(snipers);
+      Bitboard between = Util::GetBetween(king, sniper) & basic_st.blocker_;
+
+      if (!between) {
+        checkers_ |= Util::SQUARE[sniper];
+      } else if (!(between & (between - 1))
+      && (between & basic_st.side_pieces_[side])) {
+        pinned_ |= between;
+        pin_line_[Util::GetSquare(between)] = Util::GetLine(king, sniper);
+      }
+    }
+
+    // チェックされていれば、チェックしている駒を取るか、間に入る手だけ。
+    if (!checkers_) {
+      evasion_mask_ = ~0ULL;
+    } else if (!(checkers_ & (checkers_ - 1))) {
+      evasion_mask_ =
+      checkers_ | Util::GetBetween(king, Util::GetSquare(checkers_));
+    } else {
+      // 両王手はキングが逃げるしかない。
+      evasion_mask_ = 0;
+    }
+  }
+
+  // アンパッサンが合法手かどうか判定する。
+  inline bool MoveMaker::IsLegalEnPassant(Side side, Square from,
+  Square to) const {
+    const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
+    Side enemy_side = Util::GetOppositeSide(side);
+    Square king = basic_st.king_[side];
+    Square target = Util::EN_PASSANT_TRANS_TABLE[to];
+
+    // 取られるポーン以外のポーンやナイトにチェックされていれば回避できない。
+    if (checkers_ & ~(Util::SQUARE[target])
+    & (basic_st.position_[enemy_side][PAWN]
+    | basic_st.position_[enemy_side][KNIGHT])) {
+      return false;
+    }
+
+    // 2つのポーンが動いた後の局面で、飛び駒に攻撃されないか調べる。
+    Bitboard blocker = (basic_st.blocker_
+    ^ Util::SQUARE[from] ^ Util::SQUARE[target]) | Util::SQUARE[to];
+    Bitboard queens = basic_st.position_[enemy_side][QUEEN];
+    return !((Util::GetBishopMagic(king, blocker)
+    & (basic_st.position_[enemy_side][BISHOP] | queens))
+    || (Util::GetRookMagic(king, blocker)
+    & (basic_st.position_[enemy_side][ROOK] | queens)));
+  }
+
+  // キングの移動先が攻撃されていないかどうか判定する。
+  inline bool MoveMaker::IsSafeForKing(Side side, Square to) const {
+    const ChessEngine::BasicStruct& basic_st = engine_ptr_->basic_st_;
+    Side enemy_side = Util::GetOppositeSide(side);
+
+    if ((Util::PAWN_ATTACK[side][to] & basic_st.position_[enemy_side][PAWN])
+    || (Util::KNIGHT_MOVE[to] & basic_st.position_[enemy_side][KNIGHT])
+    || (Util::KING_MOVE[to] & basic_st.position_[enemy_side][KING])) {
+      return false;
+    }
+
+    // 飛び駒の利きはキングを取り除いてから調べる。
+    Bitboard blocker =
+    basic_st.blocker_ ^ Util::SQUARE[basic_st.king_[side]];
+    Bitboard queens = basic_st.position_[enemy_side][QUEEN];
+    return !((Util::GetBishopMagic(to, blocker)
+    & (basic_st.position_[enemy_side][BISHOP] | queens))
+    || (Util::GetRookMagic(to, blocker)
+    & (basic_st.position_[enemy_side][ROOK] | queens)));
+  }
+
   // スタックに候補手を生成する。
   template<GenMoveType TYPE> int MoveMaker::GenMoves(Move prev_best,
-  Move iid_move, Move killer_1, Move killer_2) {
+  Move iid_move, Move killer_1, Move killer_2, Move last_move) {
     // 初期化。
     last_ = max_ = 0;
     history_max_ = 1;
-
-    GenMovesCore<TYPE>(prev_best, iid_move, killer_1, killer_2);
+    killer_1_ = killer_1;
+    killer_2_ = killer_2;
+    has_unscored_captures_ = has_unscored_non_captures_ = false;
+    is_shared_ = false;
+    SetLastMove(last_move);
+    SetPinsAndChecks();
+
+    GenMovesCore<TYPE>(prev_best, iid_move);
     
     max_ = last_;
     return last_;
   }
   // インスタンス化。
-  template
-  int MoveMaker::GenMoves<GenMoveType::NON_CAPTURE>(Move, Move, Move, Move);
-  template
-  int MoveMaker::GenMoves<GenMoveType::CAPTURE>(Move, Move, Move, Move);
+  template int MoveMaker::GenMoves<GenMoveType::NON_CAPTURE>
+  (Move, Move, Move, Move, Move);
+  template int MoveMaker::GenMoves<GenMoveType::CAPTURE>
+  (Move, Move, Move, Move, Move);
   template<>
   int MoveMaker::GenMoves<GenMoveType::ALL>(Move prev_best,
-  Move iid_move, Move killer_1, Move killer_2) {
+  Move iid_move, Move killer_1, Move killer_2, Move last_move) {
     // 初期化。
     last_ = max_ = 0;
     history_max_ = 1;
+    killer_1_ = killer_1;
+    killer_2_ = killer_2;
+    has_unscored_captures_ = has_unscored_non_captures_ = false;
+    is_shared_ = false;
+    SetLastMove(last_move);
+    SetPinsAndChecks();
 
-    GenMovesCore<GenMoveType::NON_CAPTURE>(prev_best, iid_move, killer_1,
-    killer_2);
+    GenMovesCore<GenMoveType::NON_CAPTURE>(prev_best, iid_move);
 
-    GenMovesCore<GenMoveType::CAPTURE>(prev_best, iid_move, killer_1,
-    killer_2);
+    GenMovesCore<GenMoveType::CAPTURE>(prev_best, iid_move);
 
     max_ = last_;
     return last_;
@@ -132,26 +318,73 @@ namespace Sayuri {
 
   // 次の候補手を取り出す。
   Move MoveMaker::PickMove() {
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    // 手がなければ何もしない。
-    if (!last_) {
-      return 0;
+    // 共有している時は、並べ替え済みのスタックの上から取り出す。
+    if (is_shared_) {
+      u32 index = shared_last_.load(std::memory_order_relaxed);
+      while (index && !(shared_last_.compare_exchange_weak(index, index - 1,
+      std::memory_order_relaxed))) {
+        continue;
+      }
+      return index ? move_stack_[index - 1] : 0;
     }
 
-    // とりあえず最後の手をポップ。
-    Move move = move_stack_[--last_];
-    i32 score = score_stack_[last_];
+    while (true) {
+      // 手がなければ何もしない。
+      if (!last_) {
+        return 0;
+      }
+
+      // 一番高い手を探す。
+      u32 best_index = last_ - 1;
+      i32 best_score = score_stack_[best_index];
+      for (int i = last_ - 2; i >= 0; --i) {
+        if (score_stack_[i] > best_score) {
+          best_index = i;
+          best_score = score_stack_[i];
+        }
+      }
+
+      // 一番高い手がまだ点数のない手なら、
+      // その種類の手にまとめて点数をつけてから探し直す。
+      if (best_score == UNSCORED_CAPTURE_SCORE) {
+        ScoreMoves<GenMoveType::CAPTURE>();
+        continue;
+      }
+      if (best_score == UNSCORED_NON_CAPTURE_SCORE) {
+        ScoreMoves<GenMoveType::NON_CAPTURE>();
+        continue;
+      }
+
+      // 最後の手とスワップしてポップ。
+      --last_;
+      std::swap(move_stack_[best_index], move_stack_[last_]);
+      std::swap(score_stack_[best_index], score_stack_[last_]);
+      return move_stack_[last_];
+    }
+  }
 
-    // 一番高い手を探し、スワップ。
-    for (int i = last_ - 1; i >= 0; --i) {
-      if (score_stack_[i] > score) {
-        std::swap(move, move_stack_[i]);
-        std::swap(score, score_stack_[i]);
+  // 他のスレッドと候補手を共有する準備をする。
+  void MoveMaker::PrepareForSharing() {
+    if (is_shared_) return;
+
+    if (has_unscored_captures_) ScoreMoves<GenMoveType::CAPTURE>();
+    if (has_unscored_non_captures_) ScoreMoves<GenMoveType::NON_CAPTURE>();
+
+    // 残っている手を点数の低い順に並べる。 (挿入ソート)
+    for (u32 i = 1; i < last_; ++i) {
+      Move move = move_stack_[i];
+      i32 score = score_stack_[i];
+      u32 j = i;
+      for (; (j > 0) && (score_stack_[j - 1] > score); --j) {
+        move_stack_[j] = move_stack_[j - 1];
+        score_stack_[j] = score_stack_[j - 1];
       }
+      move_stack_[j] = move;
+      score_stack_[j] = score;
     }
 
-    return move;
+    shared_last_ = last_;
+    is_shared_ = true;
   }
 
   // ヒストリーの最大値を更新する。
@@ -162,7 +395,12 @@ namespace Sayuri {
   inline void MoveMaker::UpdateMaxHistory<GenMoveType::NON_CAPTURE>
   (Side side, Square from, Square to) {
       Util::UpdateMax(history_max_,
-      engine_ptr_->shared_st_ptr_->history_[side][from][to]);
+      engine_ptr_->order_st_ptr_->history_[side][from][to]);
+
+      if (cont_history_ptr_) {
+        Util::UpdateMax(cont_history_max_, cont_history_ptr_
+        [engine_ptr_->basic_st_.piece_board_[from]][to]);
+      }
   }
 
   // 指し手のマスクを作成する。
@@ -171,7 +409,7 @@ namespace Sayuri {
   template<>
   inline Bitboard MoveMaker::GenBitboardMask<GenMoveType::NON_CAPTURE>
   (Side side) const {
-    return ~(engine_ptr_->basic_st_.blocker_[R0]);
+    return ~(engine_ptr_->basic_st_.blocker_);
   }
   template<>
   inline Bitboard MoveMaker::GenBitboardMask<GenMoveType::CAPTURE>
@@ -195,14 +433,13 @@ namespace Sayuri {
     Bitboard bb = Util::PAWN_ATTACK[side][from];
     return (bb & engine_ptr_->side_pieces()[Util::GetOppositeSide(side)])
       | (engine_ptr_->basic_st_.en_passant_square_
-      ? (Util::SQUARE[engine_ptr_->basic_st_.en_passant_square_][R0] & bb)
+      ? (Util::SQUARE[engine_ptr_->basic_st_.en_passant_square_] & bb)
       : 0);
   }
 
   // スタックに候補手を生成する。 (内部用)
   template<GenMoveType TYPE>
-  void MoveMaker::GenMovesCore(Move prev_best, Move iid_move,
-  Move killer_1, Move killer_2) {
+  void MoveMaker::GenMovesCore(Move prev_best, Move iid_move) {
     // 準備。
     const ChessEngine::BasicStruct& basic_st =  engine_ptr_->basic_st_;
     // サイド。
@@ -211,35 +448,73 @@ namespace Sayuri {
     // 生成開始時のポインタ。
     u32 start = last_;
 
-    // ナイト、ビショップ、ルーク、クイーンの候補手を作る。
-    for (PieceType piece_type = KNIGHT; piece_type <= QUEEN; ++piece_type) {
-      Bitboard pieces = basic_st.position_[side][piece_type];
+    // 両王手ならキングの手だけ。
+    if (evasion_mask_) {
+      // ナイト、ビショップ、ルーク、クイーンの候補手を作る。
+      for (PieceType piece_type = KNIGHT; piece_type <= QUEEN; ++piece_type) {
+        Bitboard pieces = basic_st.position_[side][piece_type];
+
+        for (; pieces; NEXT_BITBOARD(pieces)) {
+          Square from = Util::GetSquare(pieces);
+
+          // 各ピースの動き。
+          Bitboard move_bitboard;
+          switch (piece_type) {
+            case KNIGHT:
+              move_bitboard =
+              Util::KNIGHT_MOVE[from] & GenBitboardMask<TYPE>(side);
+              break;
+            case BISHOP:
+              move_bitboard =
+              engine_ptr_->GetBishopAttack(from) & GenBitboardMask<TYPE>(side);
+              break;
+            case ROOK:
+              move_bitboard =
+              engine_ptr_->GetRookAttack(from) & GenBitboardMask<TYPE>(side);
+              break;
+            case QUEEN:
+              move_bitboard =
+              engine_ptr_->GetQueenAttack(from) & GenBitboardMask<TYPE>(side);
+              break;
+            default:
+              throw SayuriError("MoveMaker::GenMoveCore()_1");
+              break;
+          }
+
+          // チェックを回避するマスだけ。 ピンされていればピンの直線上だけ。
+          move_bitboard &= evasion_mask_;
+          if (pinned_ & Util::SQUARE[from]) move_bitboard &= pin_line_[from];
+
+          for (; move_bitboard; NEXT_BITBOARD(move_bitboard)) {
+            // 手を作る。
+            Move move = 0;
+            Set<FROM>(move, from);
+            Square to = Util::GetSquare(move_bitboard);
+            Set<TO>(move, to);
+            Set<MOVE_TYPE>(move, NORMAL);
 
+            // スタックに登録。
+            move_stack_[last_++] = move;
+          }
+        }
+      }
+
+      // ポーンの動きを作る。
+      Bitboard en_passant_bb = basic_st.en_passant_square_
+      ? Util::SQUARE[basic_st.en_passant_square_] : 0;
+      Bitboard pieces = basic_st.position_[side][PAWN];
       for (; pieces; NEXT_BITBOARD(pieces)) {
         Square from = Util::GetSquare(pieces);
 
-        // 各ピースの動き。
-        Bitboard move_bitboard;
-        switch (piece_type) {
-          case KNIGHT:
-            move_bitboard =
-            Util::KNIGHT_MOVE[from] & GenBitboardMask<TYPE>(side);
-            break;
-          case BISHOP:
-            move_bitboard =
-            engine_ptr_->GetBishopAttack(from) & GenBitboardMask<TYPE>(side);
-            break;
-          case ROOK:
-            move_bitboard =
-            engine_ptr_->GetRookAttack(from) & GenBitboardMask<TYPE>(side);
-            break;
-          case QUEEN:
-            move_bitboard =
-            engine_ptr_->GetQueenAttack(from) & GenBitboardMask<TYPE>(side);
-            break;
-          default:
-            throw SayuriError("MoveMaker::GenMoveCore()_1");
-            break;
+        Bitboard move_bitboard = GenPawnBitboard<TYPE>(side, from);
+
+        // アンパッサンは別に調べる。
+        Bitboard en_passant_move = move_bitboard & en_passant_bb;
+        move_bitboard &= evasion_mask_ & ~en_passant_bb;
+        if (pinned_ & Util::SQUARE[from]) move_bitboard &= pin_line_[from];
+        if (en_passant_move
+        && IsLegalEnPassant(side, from, basic_st.en_passant_square_)) {
+          move_bitboard |= en_passant_move;
         }
 
         for (; move_bitboard; NEXT_BITBOARD(move_bitboard)) {
@@ -248,51 +523,25 @@ namespace Sayuri {
           Set<FROM>(move, from);
           Square to = Util::GetSquare(move_bitboard);
           Set<TO>(move, to);
-          Set<MOVE_TYPE>(move, NORMAL);
-
-          // ヒストリーの最大値を更新。 (テンプレート部品)
-          UpdateMaxHistory<TYPE>(side, from, to);
-
-          // スタックに登録。
-          move_stack_[last_++] = move;
-        }
-      }
-    }
-
-    // ポーンの動きを作る。
-    Bitboard pieces = basic_st.position_[side][PAWN];
-    for (; pieces; NEXT_BITBOARD(pieces)) {
-      Square from = Util::GetSquare(pieces);
-
-      Bitboard move_bitboard = GenPawnBitboard<TYPE>(side, from);
 
-      for (; move_bitboard; NEXT_BITBOARD(move_bitboard)) {
-        // 手を作る。
-        Move move = 0;
-        Set<FROM>(move, from);
-        Square to = Util::GetSquare(move_bitboard);
-        Set<TO>(move, to);
-
-        // ヒストリーの最大値を更新。 (テンプレート部品)
-        UpdateMaxHistory<TYPE>(side, from, to);
-
-        if (Util::IsEnPassant(basic_st.en_passant_square_, to)) {
-          Set<MOVE_TYPE>(move, EN_PASSANT);
-        } else {
-          Set<MOVE_TYPE>(move, NORMAL);
-        }
+          if (Util::IsEnPassant(basic_st.en_passant_square_, to)) {
+            Set<MOVE_TYPE>(move, EN_PASSANT);
+          } else {
+            Set<MOVE_TYPE>(move, NORMAL);
+          }
 
-        if (((side == WHITE) && (Util::SquareToRank(to) == RANK_8))
-        || ((side == BLACK) && (Util::SquareToRank(to) == RANK_1))) {
-          // 昇格を設定。
-          for (PieceType piece_type = KNIGHT;
-          piece_type <= QUEEN; ++piece_type) {
-            Set<PROMOTION>(move, piece_type);
+          if (((side == WHITE) && (Util::SquareToRank(to) == RANK_8))
+          || ((side == BLACK) && (Util::SquareToRank(to) == RANK_1))) {
+            // 昇格を設定。
+            for (PieceType piece_type = KNIGHT;
+            piece_type <= QUEEN; ++piece_type) {
+              Set<PROMOTION>(move, piece_type);
+              move_stack_[last_++] = move;
+            }
+          } else {
+            // 昇格しない場合。
             move_stack_[last_++] = move;
           }
-        } else {
-          // 昇格しない場合。
-          move_stack_[last_++] = move;
         }
       }
     }
@@ -311,43 +560,67 @@ namespace Sayuri {
     | (CASTLE_BS << SHIFT[MOVE_TYPE]);
     constexpr Move BL_CASTLING_MOVE = E8 | (C8 << SHIFT[TO])
     | (CASTLE_BL << SHIFT[MOVE_TYPE]);
-    if (side == WHITE) {
-      if (engine_ptr_->CanWhiteShortCastling()) {
-        move_stack_[last_++] = WS_CASTLING_MOVE;
-      }
-      if (engine_ptr_->CanWhiteLongCastling()) {
-        move_stack_[last_++] = WL_CASTLING_MOVE;
-      }
-    } else {
-      if (engine_ptr_->CanBlackShortCastling()) {
-        move_stack_[last_++] = BS_CASTLING_MOVE;
-      }
-      if (engine_ptr_->CanBlackLongCastling()) {
-        move_stack_[last_++] = BL_CASTLING_MOVE;
+    // キャスリングは駒を取らない手なので、駒を取る手の時は作らない。
+    // (GenMoves<ALL>()で2重に作らないように。)
+    // チェックされている時もできない。
+    if ((TYPE != GenMoveType::CAPTURE) && !checkers_) {
+      if (side == WHITE) {
+        if (engine_ptr_->CanWhiteShortCastling()) {
+          move_stack_[last_++] = WS_CASTLING_MOVE;
+        }
+        if (engine_ptr_->CanWhiteLongCastling()) {
+          move_stack_[last_++] = WL_CASTLING_MOVE;
+        }
+      } else {
+        if (engine_ptr_->CanBlackShortCastling()) {
+          move_stack_[last_++] = BS_CASTLING_MOVE;
+        }
+        if (engine_ptr_->CanBlackLongCastling()) {
+          move_stack_[last_++] = BL_CASTLING_MOVE;
+        }
       }
     }
 
     for (; move_bitboard; NEXT_BITBOARD(move_bitboard)) {
+      Square to = Util::GetSquare(move_bitboard);
+      // 攻撃されているマスには動けない。
+      if (!IsSafeForKing(side, to)) continue;
+
       Move move = 0;
       Set<FROM>(move, from);
-      Square to = Util::GetSquare(move_bitboard);
       Set<TO>(move, to);
       Set<MOVE_TYPE>(move, NORMAL);
 
-      // ヒストリーの最大値を更新。 (テンプレート部品)
-      UpdateMaxHistory<TYPE>(side, from, to);
-
       move_stack_[last_++] = move;
     }
 
-    ScoreMoves<TYPE>(start, prev_best, iid_move, killer_1, killer_2, side);
+    // 前回の最善手とIIDムーブにだけ点数をつけ、
+    // 残りは取り出す時まで点数をつけるのを遅らせる。
+    constexpr i32 UNSCORED_SCORE = TYPE == GenMoveType::CAPTURE
+    ? UNSCORED_CAPTURE_SCORE : UNSCORED_NON_CAPTURE_SCORE;
+    for (u32 i = start; i < last_; ++i) {
+      if (EqualMove(move_stack_[i], prev_best)) {
+        // 前回の最善手。
+        score_stack_[i] = BEST_MOVE_SCORE;
+      } else if (EqualMove(move_stack_[i], iid_move)) {
+        // IIDムーブ。
+        score_stack_[i] = IID_MOVE_SCORE;
+      } else {
+        score_stack_[i] = UNSCORED_SCORE;
+        if (TYPE == GenMoveType::CAPTURE) {
+          has_unscored_captures_ = true;
+        } else {
+          has_unscored_non_captures_ = true;
+        }
+      }
+    }
   }
 
   // 実体化。
   template void MoveMaker::GenMovesCore<GenMoveType::NON_CAPTURE>
-  (Move, Move, Move, Move);
+  (Move, Move);
   template void MoveMaker::GenMovesCore<GenMoveType::CAPTURE>
-  (Move, Move, Move, Move);
+  (Move, Move);
 
   // 指し手のスコアを計算する。
   template<GenMoveType>
@@ -360,8 +633,17 @@ namespace Sayuri {
     constexpr int MAX_HISTORY_SCORE_SHIFT = 9;
 
     // ヒストリーを使って点数をつけていく。
-    return (engine_ptr_->shared_st_ptr_->history_[side][from][to]
+    i32 score = (engine_ptr_->order_st_ptr_->history_[side][from][to]
     << MAX_HISTORY_SCORE_SHIFT) / history_max_;
+
+    // 継続ヒストリーの点数を足す。
+    if (cont_history_ptr_) {
+      score += (static_cast<u64>(cont_history_ptr_
+      [engine_ptr_->basic_st_.piece_board_[from]][to])
+      << MAX_HISTORY_SCORE_SHIFT) / cont_history_max_;
+    }
+
+    return score;
   }
   template<>
   inline i32 MoveMaker::CalScore<GenMoveType::CAPTURE>
@@ -369,36 +651,46 @@ namespace Sayuri {
     // 駒を取る手のビットシフト。
     constexpr int CAPTURE_SCORE_SHIFT = 12;
 
-    // SEEで点数をつけていく。
-    return engine_ptr_->SEE(move) << CAPTURE_SCORE_SHIFT;
+    // SEEで点数をつけていく。 (損する手はマイナスになる。)
+    return engine_ptr_->SEE(move) * (1 << CAPTURE_SCORE_SHIFT);
   }
 
-  // 候補手に点数をつける。
+  // まだ点数のない候補手に点数をつける。
   template<GenMoveType TYPE>
-  void MoveMaker::ScoreMoves(u32 start, Move prev_best,
-  Move iid_move, Move killer_1, Move killer_2, Side side) {
-    // --- 評価値の定義 --- //
-    // キラームーブの点数。
-    constexpr i32 KILLER_2_MOVE_SCORE = 0x400;
-    constexpr i32 KILLER_1_MOVE_SCORE = KILLER_2_MOVE_SCORE << 1;
-    // 駒を取る手のビットシフト。
-    // constexpr int CAPTURE_SCORE_SHIFT = 12;
-    // 相手キングをチェックする手の点数。
-    constexpr i32 CHECKING_MOVE_SCORE = 1 << 28;
-    // IIDで得た最善手の点数。
-    constexpr i32 IID_MOVE_SCORE = CHECKING_MOVE_SCORE << 1;
-    // 前回の繰り返しでトランスポジションテーブルから得た最善手の点数。
-    constexpr i32 BEST_MOVE_SCORE = IID_MOVE_SCORE << 1;
-    // 悪い取る手の点数。
-    // constexpr i32 BAD_CAPTURE_SCORE = -1;
+  void MoveMaker::ScoreMoves() {
+    constexpr i32 UNSCORED_SCORE = TYPE == GenMoveType::CAPTURE
+    ? UNSCORED_CAPTURE_SCORE : UNSCORED_NON_CAPTURE_SCORE;
+
+    Side side = engine_ptr_->basic_st_.to_move_;
+
+    // ヒストリーの最大値を更新。 (テンプレート部品)
+    for (u32 i = 0; i < last_; ++i) {
+      if (score_stack_[i] == UNSCORED_SCORE) {
+        UpdateMaxHistory<TYPE>(side, Get<FROM>(move_stack_[i]),
+        Get<TO>(move_stack_[i]));
+      }
+    }
 
     Bitboard enemy_king_bb =
     engine_ptr_->basic_st_.position_[Util::GetOppositeSide(side)][KING];
-    for (u32 i = start; i < last_; ++i) {
+    for (u32 i = 0; i < last_; ++i) {
+      if (score_stack_[i] != UNSCORED_SCORE) continue;
+
       // 手の情報を得る。
       Square from = Get<FROM>(move_stack_[i]);
       Square to = Get<TO>(move_stack_[i]);
 
+      // 損をする駒を取る手は、チェックする手でも最後に回す。
+      // (Quiesce()はこの点数の符号で損をする駒を取る手を読まない。)
+      i32 capture_score = 0;
+      if (TYPE == GenMoveType::CAPTURE) {
+        capture_score = CalScore<TYPE>(move_stack_[i], side, from, to);
+        if (capture_score < 0) {
+          score_stack_[i] = capture_score;
+          continue;
+        }
+      }
+
       // 相手キングをチェックする手かどうか調べる。
       bool is_checking_move = false;
       switch (engine_ptr_->basic_st_.piece_board_[from]) {
@@ -433,31 +725,33 @@ namespace Sayuri {
       }
 
       // 特殊な手の点数をつける。
-      if (EqualMove(move_stack_[i], prev_best)) {
-        // 前回の最善手。
-        score_stack_[i] = BEST_MOVE_SCORE;
-      } else if (EqualMove(move_stack_[i], iid_move)) {
-        // IIDムーブ。
-        score_stack_[i] = IID_MOVE_SCORE;
-      } else if (is_checking_move) {
+      if (is_checking_move) {
         // 相手キングをチェックする手。
         score_stack_[i] = CHECKING_MOVE_SCORE;
-      } else if (EqualMove(move_stack_[i], killer_1)) {
+      } else if (EqualMove(move_stack_[i], killer_1_)) {
         // キラームーブ。
         score_stack_[i] = KILLER_1_MOVE_SCORE;
-      } else if (EqualMove(move_stack_[i], killer_2)) {
+      } else if (EqualMove(move_stack_[i], killer_2_)) {
         // キラームーブ。
         score_stack_[i] = KILLER_2_MOVE_SCORE;
+      } else if (EqualMove(move_stack_[i], counter_move_)) {
+        // カウンタームーブ。
+        score_stack_[i] = COUNTER_MOVE_SCORE;
       } else {
         // その他の手を各候補手のタイプに分ける。
-        score_stack_[i] = CalScore<TYPE>(move_stack_[i], side, from, to);
+        score_stack_[i] = TYPE == GenMoveType::CAPTURE ? capture_score
+        : CalScore<TYPE>(move_stack_[i], side, from, to);
       }
     }
+
+    if (TYPE == GenMoveType::CAPTURE) {
+      has_unscored_captures_ = false;
+    } else {
+      has_unscored_non_captures_ = false;
+    }
   }
 
   // 実体化。
-  template void MoveMaker::ScoreMoves<GenMoveType::NON_CAPTURE>
-  (u32, Move, Move, Move, Move, Side);
-  template void MoveMaker::ScoreMoves<GenMoveType::CAPTURE>
-  (u32, Move, Move, Move, Move, Side);
+  template void MoveMaker::ScoreMoves<GenMoveType::NON_CAPTURE>();
+  template void MoveMaker::ScoreMoves<GenMoveType::CAPTURE>();
 }  // namespace Sayuri
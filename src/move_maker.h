@@ -31,7 +31,7 @@
 #define MOVE_MAKER_H_dd1bb50e_83bf_4b24_af8b_7c7bf60bc063
 
 #include <iostream>
-#include <mutex>
+#include <atomic>
 #include <cstddef>
 #include "common.h"
 
@@ -80,7 +80,10 @@ namespace Sayuri {
       // ============== //
       /**
        * スタックに候補手を生成する。
-       * 自らチェックされる手も作る。
+       * 合法手だけを作る。 (チェックされていれば、それを回避する手だけ。)
+       * 前回の最善手とIIDムーブ以外の点数付けは、
+       * PickMove()でその種類の手が必要になるまで遅らせる。
+       * (駒を取る手、駒を取らない手、損をする駒を取る手の順。)
        * @param <TYPE> 生成する手の種類。
        * - NON_CAPTURE: 駒を取らない手。
        * - CAPTURE: 駒を取る手。
@@ -89,11 +92,13 @@ namespace Sayuri {
        * @param iid_move IIDによる最善手。
        * @param killer_1 同一レベルでのキラームーブ。
        * @param killer_2 2プライ前のレベルのキラームーブ。
+       * @param last_move 直前の相手の手。 (カウンタームーブと
+       * 継続ヒストリーに使う。) 無ければ0。
        * @return 生成した候補手の数。
        */
       template<GenMoveType TYPE>
       int GenMoves(Move prev_best, Move iid_move, Move killer_1,
-      Move killer_2);
+      Move killer_2, Move last_move);
 
       /**
        * スタックに候補手を再生成する。
@@ -101,6 +106,7 @@ namespace Sayuri {
        */
       int RegenMoves() {
         last_ = max_;
+        is_shared_ = false;
         return CountMoves();
       }
 
@@ -108,19 +114,55 @@ namespace Sayuri {
       void ResetStack() {
         last_ = max_ = 0;
         history_max_ = 1;
+        has_unscored_captures_ = has_unscored_non_captures_ = false;
+        is_shared_ = false;
       }
 
       /**
        * 次の候補手を取り出す。
+       * 共有前は1つのスレッドだけが呼ぶので、ロックしない。
+       * 点数のない手が一番上に来たら、その種類の手に点数をつける。
+       * (エンジンの局面が候補手を生成した時の局面である必要がある。)
+       * 共有後は並べ替え済みのスタックからアトミックなカーソルで取り出す。
        * @return 次の候補手。 なければ、0。
        */
       Move PickMove();
 
+      /**
+       * 直前にPickMove()で取り出した候補手の点数を返す。
+       * 共有前だけ有効。 (共有後はスタックの並びが変わる。)
+       * 駒を取る手はSEEで点数をつけるので、マイナスなら損をする駒を取る手。
+       * (チェックする手でも損をする駒を取る手はマイナスになる。
+       * 前回の最善手とIIDの最善手だけはSEEに関係なくプラスになる。)
+       * @return 直前に取り出した候補手の点数。
+       */
+      i32 GetPickedScore() const {return score_stack_[last_];}
+
+      /**
+       * 点数をつけずに、スタックの一番上の候補手を取り出す。
+       * 順番を気にしないPerft用。 PickMove()と混ぜて使わないこと。
+       * @return 次の候補手。 なければ、0。
+       */
+      Move PopMove() {
+        return last_ ? move_stack_[--last_] : 0;
+      }
+
+      /**
+       * 他のスレッドと候補手を共有する準備をする。
+       * まだ点数のない候補手に全て点数をつけ、点数順に並べ替える。
+       * 他のスレッドにPickMove()させる前に呼ぶ。
+       * (他のスレッドはエンジンの局面を参照できないため。)
+       * 既に共有していれば何もしない。
+       */
+      void PrepareForSharing();
+
       /**
        * スタック内の残っている候補手の数を返す。
        * @return 残っている候補手の数。
        */
-      int CountMoves() const {return last_;}
+      int CountMoves() const {
+        return is_shared_ ? shared_last_.load() : last_;
+      }
 
     private:
       /** フレンドのデバッグ用関数。 */
@@ -141,39 +183,60 @@ namespace Sayuri {
       template<GenMoveType TYPE>
       friend struct SetScore;
 
+      /**
+       * 直前の相手の手から、カウンタームーブと継続ヒストリーを準備する。
+       * @param last_move 直前の相手の手。 無ければ0。
+       */
+      void SetLastMove(Move last_move);
+
+      /**
+       * ピンされている自分の駒と、キングをチェックしている相手の駒を調べ、
+       * キング以外の駒が動けるマスを準備する。 (ノード毎に1回)
+       */
+      void SetPinsAndChecks();
+
+      /**
+       * アンパッサンが合法手かどうか判定する。
+       * 2つのポーンが同じランクから消えるので、ピンとは別に調べる。
+       * @param side 指し手のサイド。
+       * @param from 取るポーンの位置。
+       * @param to アンパッサンのマス。
+       * @return 合法手ならtrue。
+       */
+      bool IsLegalEnPassant(Side side, Square from, Square to) const;
+
+      /**
+       * キングの移動先が相手に攻撃されていないかどうか判定する。
+       * (キングの背後に抜ける飛び駒の利きも攻撃とみなす。)
+       * @param side キングのサイド。
+       * @param to キングの移動先。
+       * @return 攻撃されていなければtrue。
+       */
+      bool IsSafeForKing(Side side, Square to) const;
+
       /**
        * スタックに候補手を生成する。 (内部用)
-       * 自らチェックされる手も作る。
+       * SetPinsAndChecks()の結果を使って合法手だけを作る。
        * @param <TYPE> 生成する手の種類。
        * - NON_CAPTURE: 駒を取らない手。
        * - CAPTURE: 駒を取る手。
        * - ALL: 上記の両方。
        * @param prev_best Iterative Deepeningによる前回の繰り返しの最善手。
        * @param iid_move IIDによる最善手。
-       * @param killer_1 同一レベルでのキラームーブ。
-       * @param killer_2 2プライ前のレベルのキラームーブ。
-       * @return 生成した候補手の数。
        */
       template<GenMoveType TYPE>
-      void GenMovesCore(Move prev_best, Move iid_move, Move killer_1,
-      Move killer_2);
+      void GenMovesCore(Move prev_best, Move iid_move);
 
       /**
-       * 候補手に点数をつける。
-       * @param <TYPE> 生成する手の種類。
+       * まだ点数のない候補手に点数をつける。
+       * @param <TYPE> 点数をつける手の種類。
        * - NON_CAPTURE: 駒を取らない手。
        * - CAPTURE: 駒を取る手。
-       * - ALL: 上記の両方。
-       * @param start 点数をつける候補手の最初のインデックス。
-       * @param prev_best Iterative Deepeningによる前回の繰り返しの最善手。
-       * @param iid_move IIDによる最善手。
-       * @param killer_1 同一レベルでのキラームーブ。
-       * @param killer_2 2プライ前のレベルのキラームーブ。
-       * @param side 候補手のサイド。
+       * (キラームーブはkiller_1_、killer_2_、
+       * カウンタームーブはcounter_move_を使う。)
        */
       template<GenMoveType TYPE>
-      void ScoreMoves(u32 start, Move prev_best, Move iid_move,
-      Move killer_1, Move killer_2, Side side);
+      void ScoreMoves();
 
       // ================ //
       // テンプレート部品 //
@@ -215,6 +278,35 @@ namespace Sayuri {
       template<GenMoveType TYPE>
       i32 CalScore(Move move, Side side, Square from, Square to) const;
 
+      // ============ //
+      // 評価値の定義 //
+      // ============ //
+      /**
+       * カウンタームーブの点数。
+       * (ヒストリーと継続ヒストリーの点数の合計以上)
+       */
+      static constexpr i32 COUNTER_MOVE_SCORE = 0x400;
+      /** 2プライ前のキラームーブの点数。 */
+      static constexpr i32 KILLER_2_MOVE_SCORE = COUNTER_MOVE_SCORE << 1;
+      /** 同一レベルのキラームーブの点数。 */
+      static constexpr i32 KILLER_1_MOVE_SCORE = KILLER_2_MOVE_SCORE << 1;
+      /** 相手キングをチェックする手の点数。 */
+      static constexpr i32 CHECKING_MOVE_SCORE = 1 << 28;
+      /** IIDで得た最善手の点数。 */
+      static constexpr i32 IID_MOVE_SCORE = CHECKING_MOVE_SCORE << 1;
+      /** 前回の繰り返しでトランスポジションテーブルから得た最善手の点数。 */
+      static constexpr i32 BEST_MOVE_SCORE = IID_MOVE_SCORE << 1;
+      /**
+       * まだ点数のない駒を取る手の仮の点数。
+       * (IIDムーブより下で、他のどの点数より上。)
+       */
+      static constexpr i32 UNSCORED_CAPTURE_SCORE = IID_MOVE_SCORE - 1;
+      /**
+       * まだ点数のない駒を取らない手の仮の点数。
+       * (損をしない駒を取る手より下で、損をする駒を取る手より上。)
+       */
+      static constexpr i32 UNSCORED_NON_CAPTURE_SCORE = -1;
+
       // ========== //
       // メンバ変数 //
       // ========== //
@@ -232,9 +324,44 @@ namespace Sayuri {
 
       /** ヒストリーの最大値。 */
       u64 history_max_;
+      /** 直前の相手の手に対するカウンタームーブ。 無ければ0。 */
+      Move counter_move_;
+      /**
+       * 直前の相手の手に対する継続ヒストリーのテーブル。 無ければnullptr。
+       * [駒の種類][to]
+       */
+      const u32 (* cont_history_ptr_)[NUM_SQUARES];
+      /** 継続ヒストリーの最大値。 */
+      u64 cont_history_max_;
+      /** 同一レベルでのキラームーブ。 */
+      Move killer_1_;
+      /** 2プライ前のレベルのキラームーブ。 */
+      Move killer_2_;
+      /** まだ点数のない駒を取る手があるかどうか。 */
+      bool has_unscored_captures_;
+      /** まだ点数のない駒を取らない手があるかどうか。 */
+      bool has_unscored_non_captures_;
+
+      /** ピンされている自分の駒。 */
+      Bitboard pinned_;
+      /**
+       * ピンされている駒が動ける直線。 (ピンしている駒を含む。)
+       * [ピンされている駒の位置]
+       */
+      Bitboard pin_line_[NUM_SQUARES];
+      /** 自分のキングをチェックしている相手の駒。 */
+      Bitboard checkers_;
+      /**
+       * キング以外の駒が動けるマス。
+       * チェックされていれば、チェックしている駒とその間のマス。
+       * 両王手なら0。
+       */
+      Bitboard evasion_mask_;
 
-      /** ミューテックス。 */
-      std::mutex mutex_;
+      /** 他のスレッドと共有しているかどうか。 */
+      bool is_shared_;
+      /** 共有している時のスタックのインデックス。 */
+      std::atomic<u32> shared_last_;
   };
 }  // namespace Sayuri
 
@@ -52,6 +52,7 @@ namespace Sayuri {
   enable_history_(true),
   enable_killer_(true),
   enable_ttable_(true),
+  enable_quiesce_ttable_(true),
   enable_iid_(true),
   iid_limit_depth_(5),
   iid_search_depth_(4),
@@ -129,6 +130,7 @@ namespace Sayuri {
     enable_history_ = params.enable_history_;
     enable_killer_ = params.enable_killer_;
     enable_ttable_ = params.enable_ttable_;
+    enable_quiesce_ttable_ = params.enable_quiesce_ttable_;
     enable_iid_ = params.enable_iid_;
     iid_limit_depth_ = params.iid_limit_depth_;
     iid_search_depth_ = params.iid_search_depth_;
@@ -162,6 +162,11 @@ namespace Sayuri {
        * @return 有効無効。
        */
       bool enable_ttable() const {return enable_ttable_;}
+      /**
+       * アクセサ - トランスポジションテーブル - クイース探索で使うかどうか。
+       * @return 有効無効。
+       */
+      bool enable_quiesce_ttable() const {return enable_quiesce_ttable_;}
 
       // --- Internal Iterative Deepening --- //
       /**
@@ -416,6 +421,13 @@ namespace Sayuri {
        * @param enable 有効無効。
        */
       void enable_ttable(bool enable) {enable_ttable_ = enable;}
+      /**
+       * ミューテータ - トランスポジションテーブル - クイース探索で使うかどうか。
+       * @param enable 有効無効。
+       */
+      void enable_quiesce_ttable(bool enable) {
+        enable_quiesce_ttable_ = enable;
+      }
 
       // --- Internal Iterative Deepening --- //
       /**
@@ -669,6 +681,8 @@ namespace Sayuri {
       // --- トランスポジションテーブル --- //
       /** トランスポジションテーブル - 有効無効。 */
       bool enable_ttable_;
+      /** トランスポジションテーブル - クイース探索で使うかどうか。 */
+      bool enable_quiesce_ttable_;
 
       // --- Internal Iterative Deepening --- //
       /** Internal Iterative Deepening - 有効無効。 */
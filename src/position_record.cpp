@@ -49,7 +49,7 @@ namespace Sayuri {
     INIT_ARRAY(piece_board_);
     INIT_ARRAY(side_board_);
     INIT_ARRAY(side_pieces_);
-    INIT_ARRAY(blocker_);
+    blocker_ = 0;
     INIT_ARRAY(king_);
     INIT_ARRAY(has_castled_);
     INIT_ARRAY(position_memo_);
@@ -129,10 +129,10 @@ namespace Sayuri {
         return side_pieces_;
       }
       /**
-       * アクセサ - 全駒の配置のビットボード。 [角度]
+       * アクセサ - 全駒の配置のビットボード。
        * @return 全駒の配置のビットボード。
        */
-      const Bitboard (& blocker() const)[NUM_ROTS] {return blocker_;}
+      Bitboard blocker() const {return blocker_;}
       /**
        * アクセサ - 各サイドのキングの位置。
        * @return 各サイドのキングの位置。 [サイド]
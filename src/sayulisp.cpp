@@ -1031,7 +1031,7 @@ namespace Sayuri {
       // セット。
       Side side = ptr->car()->car()->number();
       PieceType piece_type = ptr->car()->cdr()->car()->number();
-      position[side][piece_type] |= Util::SQUARE[square][R0];
+      position[side][piece_type] |= Util::SQUARE[square];
 
       Next(&ptr);
     }
@@ -1313,12 +1313,21 @@ namespace Sayuri {
     message_func_map_["@go-nodes"] =
     INSERT_MESSAGE_FUNCTION(GoNodes);
 
+    message_func_map_["@perft"] =
+    INSERT_MESSAGE_FUNCTION(Perft);
+
     message_func_map_["@set-hash-size"] =
     INSERT_MESSAGE_FUNCTION(SetHashSize);
 
     message_func_map_["@clear-hash"] =
     INSERT_MESSAGE_FUNCTION(ClearHash);
 
+    message_func_map_["@save-hash"] =
+    INSERT_MESSAGE_FUNCTION(SaveHash);
+
+    message_func_map_["@load-hash"] =
+    INSERT_MESSAGE_FUNCTION(LoadHash);
+
     message_func_map_["@set-threads"] =
     INSERT_MESSAGE_FUNCTION(SetThreads);
 
@@ -1403,6 +1412,9 @@ namespace Sayuri {
     message_func_map_["@enable-hash-table"] =
     INSERT_MESSAGE_FUNCTION(SetEnableHashTable);
 
+    message_func_map_["@enable-quiesce-hash-table"] =
+    INSERT_MESSAGE_FUNCTION(SetEnableQuiesceHashTable);
+
     message_func_map_["@enable-iid"] =
     INSERT_MESSAGE_FUNCTION(SetEnableIID);
 
@@ -2245,7 +2257,7 @@ namespace Sayuri {
 
     // 思考開始。
     PVLine pv_line = engine_ptr_->Calculate(shell_ptr_->num_threads(),
-    candidate_vec, *shell_ptr_);
+    shell_ptr_->enable_lazy_smp(), candidate_vec, *shell_ptr_);
 
     // 最善手、Ponderをアウトプットリスナーに送る。
     std::ostringstream oss;
@@ -2383,6 +2395,51 @@ namespace Sayuri {
     return GoFunc(MAX_PLYS, node, INT_MAX, *candidate_list_ptr);
   }
 
+  // %%% @perft
+  DEF_MESSAGE_FUNCTION(EngineSuite::Perft) {
+    // 準備。
+    LObject* args_ptr = nullptr;
+    Sayulisp::GetReadyForMessageFunction(symbol, args, 1, &args_ptr);
+
+    // 深さを得る。
+    LPointer depth_ptr = caller->Evaluate(args_ptr->car());
+    Lisp::CheckType(*depth_ptr, LType::NUMBER);
+    int depth = depth_ptr->number();
+    Lisp::Next(&args_ptr);
+
+    // もしあるなら、ハッシュテーブルのサイズを得る。
+    std::size_t hash_size = 0;
+    if (args_ptr->IsPair()) {
+      LPointer size_ptr = caller->Evaluate(args_ptr->car());
+      Lisp::CheckType(*size_ptr, LType::NUMBER);
+      hash_size = Util::GetMax(size_ptr->number(), 0.0);
+    }
+
+    // Perft実行。
+    TimePoint start_time = SysClock::now();
+    std::vector<std::pair<Move, u64>> result =
+    engine_ptr_->Perft(depth, shell_ptr_->num_threads(), hash_size);
+    int time = Chrono::duration_cast<Chrono::milliseconds>
+    (SysClock::now() - start_time).count();
+
+    // ルートの合法手毎のノード数のリストを作る。
+    u64 num_nodes = 0;
+    LPointerVec divide_vec;
+    for (auto& pair : result) {
+      num_nodes += pair.second;
+      divide_vec.push_back(Lisp::LPointerVecToList
+      ({Sayulisp::MoveToList(pair.first), Lisp::NewNumber(pair.second)}));
+    }
+
+    // (<ノード数> <ミリ秒> <NPS> <ルートの合法手毎のノード数>)
+    return Lisp::LPointerVecToList({
+      Lisp::NewNumber(num_nodes),
+      Lisp::NewNumber(time),
+      Lisp::NewNumber((num_nodes * 1000) / Util::GetMax(time, 1)),
+      Lisp::LPointerVecToList(divide_vec)
+    });
+  }
+
   // %%% @set-hash-size
   DEF_MESSAGE_FUNCTION(EngineSuite::SetHashSize) {
     // 準備。
@@ -2404,6 +2461,49 @@ namespace Sayuri {
     return ret_ptr;
   }
 
+  // %%% @save-hash
+  DEF_MESSAGE_FUNCTION(EngineSuite::SaveHash) {
+    // 準備。
+    LObject* args_ptr = nullptr;
+    Sayulisp::GetReadyForMessageFunction(symbol, args, 1, &args_ptr);
+
+    // ファイル名を得る。
+    LPointer file_name_ptr = caller->Evaluate(args_ptr->car());
+    Lisp::CheckType(*file_name_ptr, LType::STRING);
+
+    // 保存。
+    if (!(table_ptr_->Save(file_name_ptr->string(),
+    engine_ptr_->hash_key_seed()))) {
+      throw Lisp::GenError("@engine-error",
+      "Couldn't save the hash table to '"
+      + file_name_ptr->string() + "'.");
+    }
+
+    return Lisp::NewBoolean(true);
+  }
+
+  // %%% @load-hash
+  DEF_MESSAGE_FUNCTION(EngineSuite::LoadHash) {
+    // 準備。
+    LObject* args_ptr = nullptr;
+    Sayulisp::GetReadyForMessageFunction(symbol, args, 1, &args_ptr);
+
+    // ファイル名を得る。
+    LPointer file_name_ptr = caller->Evaluate(args_ptr->car());
+    Lisp::CheckType(*file_name_ptr, LType::STRING);
+
+    // 読み込み。
+    if (!(table_ptr_->Load(file_name_ptr->string(),
+    engine_ptr_->hash_key_seed()))) {
+      throw Lisp::GenError("@engine-error",
+      "Couldn't load the hash table from '"
+      + file_name_ptr->string() + "'. (Size of the table and seed of"
+      " hash keys must be the same as when saved.)");
+    }
+
+    return Lisp::NewBoolean(true);
+  }
+
   // %%% @set-threads
   DEF_MESSAGE_FUNCTION(EngineSuite::SetThreads) {
     // 準備。
@@ -2420,6 +2520,8 @@ namespace Sayuri {
 
     // スレッド数を更新。
     shell_ptr_->num_threads(threads);
+    engine_ptr_->SetNumThreads(threads);
+    table_ptr_->num_threads(threads);
 
     return ret_ptr;
   }
@@ -3864,19 +3966,19 @@ namespace Sayuri {
     {
       double value = 0.0;
       // 先ずは白。
-      if (!(board.position_[WHITE][QUEEN] & Util::SQUARE[D1][R0])) {
+      if (!(board.position_[WHITE][QUEEN] & Util::SQUARE[D1])) {
         value += Util::CountBits(board.position_[WHITE][KNIGHT]
-        & (Util::SQUARE[B1][R0] | Util::SQUARE[G1][R0]))
+        & (Util::SQUARE[B1] | Util::SQUARE[G1]))
         + Util::CountBits(board.position_[WHITE][BISHOP]
-        & (Util::SQUARE[C1][R0] | Util::SQUARE[F1][R0]));
+        & (Util::SQUARE[C1] | Util::SQUARE[F1]));
       }
 
       // 次に黒。
-      if (!(board.position_[BLACK][QUEEN] & Util::SQUARE[D8][R0])) {
+      if (!(board.position_[BLACK][QUEEN] & Util::SQUARE[D8])) {
         value -= Util::CountBits(board.position_[BLACK][KNIGHT]
-        & (Util::SQUARE[B8][R0] | Util::SQUARE[G8][R0]))
+        & (Util::SQUARE[B8] | Util::SQUARE[G8]))
         + Util::CountBits(board.position_[BLACK][BISHOP]
-        & (Util::SQUARE[C8][R0] | Util::SQUARE[F8][R0]));
+        & (Util::SQUARE[C8] | Util::SQUARE[F8]));
       }
 
       ret.push_back(std::make_pair("early_queen_starting",
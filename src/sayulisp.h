@@ -680,6 +680,9 @@ namespace Sayuri {
       /** 指定ノード数で思考する。 */
       DEF_MESSAGE_FUNCTION(GoNodes);
 
+      /** Perftで末端ノード数を数える。 */
+      DEF_MESSAGE_FUNCTION(Perft);
+
       /** ハッシュテーブルのサイズを設定する。 */
       DEF_MESSAGE_FUNCTION(SetHashSize);
 
@@ -690,6 +693,12 @@ namespace Sayuri {
         return Lisp::NewBoolean(true);
       }
 
+      /** ハッシュテーブルをファイルに保存する。 */
+      DEF_MESSAGE_FUNCTION(SaveHash);
+
+      /** ハッシュテーブルをファイルから読み込む。 */
+      DEF_MESSAGE_FUNCTION(LoadHash);
+
       /** スレッド数を設定する。 */
       DEF_MESSAGE_FUNCTION(SetThreads);
 
@@ -840,6 +849,12 @@ namespace Sayuri {
         SET_BOOLEAN_PARAM(enable_ttable);
       }
 
+      // %%% @enable-quiesce-hash-table
+      /** SearchParams - enable-quiesce-hash-table */
+      DEF_MESSAGE_FUNCTION(SetEnableQuiesceHashTable) {
+        SET_BOOLEAN_PARAM(enable_quiesce_ttable);
+      }
+
       // %%% @enable-iid
       /** SearchParams - enable-iid */
       DEF_MESSAGE_FUNCTION(SetEnableIID) {
@@ -0,0 +1,124 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2018 Hironori Ishibashi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file thread_pool.cpp
+ * @author Hironori Ishibashi
+ * @brief 使い回す探索用スレッドのプールの実装。
+ */
+
+#include "thread_pool.h"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <system_error>
+#include "common.h"
+
+/** Sayuri 名前空間。 */
+namespace Sayuri {
+  // ==================== //
+  // コンストラクタと代入 //
+  // ==================== //
+  // コンストラクタ。
+  ThreadPool::ThreadPool(int num_threads) :
+  num_threads_(Util::GetMax(num_threads, 0)),
+  worker_table_(new Worker[Util::GetMax(num_threads, 0)]),
+  num_running_(0),
+  is_quitting_(false) {
+    for (int i = 0; i < num_threads_; ++i) {
+      Worker* worker_ptr = &(worker_table_[i]);
+      worker_ptr->thread_ = std::thread([this, worker_ptr]() {
+        this->ThreadMain(*worker_ptr);
+      });
+    }
+  }
+
+  // デストラクタ。
+  ThreadPool::~ThreadPool() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+      is_quitting_ = true;
+      for (int i = 0; i < num_threads_; ++i) {
+        worker_table_[i].cond_.notify_one();
+      }
+    }
+
+    for (int i = 0; i < num_threads_; ++i) {
+      try {
+        worker_table_[i].thread_.join();
+      } catch (const std::system_error&) {
+        // 無視。
+      }
+    }
+  }
+
+  // ============== //
+  // パブリック関数 //
+  // ============== //
+  // スレッドに仕事を渡して起こす。
+  void ThreadPool::Run(int index, std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    Worker& worker = worker_table_[index];
+
+    // 前の仕事が終わるまで待つ。
+    while (worker.task_) done_cond_.wait(lock);
+
+    worker.task_ = task;
+    ++num_running_;
+    worker.cond_.notify_one();
+  }
+
+  // 全てのスレッドの仕事が終わるのを待つ。
+  void ThreadPool::WaitForAll() {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    while (num_running_ > 0) done_cond_.wait(lock);
+  }
+
+  // ================ //
+  // プライベート関数 //
+  // ================ //
+  // スレッドの本体。
+  void ThreadPool::ThreadMain(Worker& worker) {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    while (true) {
+      // 仕事が来るまで待機。
+      while (!(worker.task_ || is_quitting_)) worker.cond_.wait(lock);
+      if (!(worker.task_)) break;
+
+      // 仕事。 (ロックは外しておく。)
+      lock.unlock();
+      worker.task_();
+      lock.lock();
+
+      // 終了を通知。
+      worker.task_ = nullptr;
+      --num_running_;
+      done_cond_.notify_all();
+    }
+  }
+}  // namespace Sayuri
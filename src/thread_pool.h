@@ -0,0 +1,134 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2018 Hironori Ishibashi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file thread_pool.h
+ * @author Hironori Ishibashi
+ * @brief 使い回す探索用スレッドのプール。
+ */
+
+#ifndef THREAD_POOL_H_dd1bb50e_83bf_4b24_af8b_7c7bf60bc063
+#define THREAD_POOL_H_dd1bb50e_83bf_4b24_af8b_7c7bf60bc063
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "common.h"
+
+/** Sayuri 名前空間。 */
+namespace Sayuri {
+  /**
+   * スレッドのプール。
+   * スレッドは作られた後、仕事を渡されるまで待機し、
+   * 仕事が終わると再び待機する。 スレッドはデストラクタで終了する。
+   */
+  class ThreadPool {
+    public:
+      // ==================== //
+      // コンストラクタと代入 //
+      // ==================== //
+      /**
+       * コンストラクタ。
+       * @param num_threads スレッドの数。
+       */
+      explicit ThreadPool(int num_threads);
+      /** スレッドは共有できないので、コピーしない。 */
+      ThreadPool(const ThreadPool&) = delete;
+      /** スレッドは共有できないので、ムーブしない。 */
+      ThreadPool(ThreadPool&&) = delete;
+      /** スレッドは共有できないので、コピーしない。 */
+      ThreadPool& operator=(const ThreadPool&) = delete;
+      /** スレッドは共有できないので、ムーブしない。 */
+      ThreadPool& operator=(ThreadPool&&) = delete;
+      /** デストラクタ。 待機中のスレッドを終了させる。 */
+      virtual ~ThreadPool();
+
+      // ============== //
+      // パブリック関数 //
+      // ============== //
+      /**
+       * スレッドに仕事を渡して起こす。
+       * そのスレッドの前の仕事が終わっていなければ、終わるまで待つ。
+       * @param index スレッドの番号。
+       * @param task 仕事。
+       */
+      void Run(int index, std::function<void()> task);
+
+      /** 全てのスレッドの仕事が終わるのを待つ。 */
+      void WaitForAll();
+
+      // ======== //
+      // アクセサ //
+      // ======== //
+      /**
+       * アクセサ - スレッドの数。
+       * @return スレッドの数。
+       */
+      int num_threads() const {return num_threads_;}
+
+    private:
+      // ========== //
+      // 内部クラス //
+      // ========== //
+      /** 1つのスレッドとその仕事。 */
+      struct Worker {
+        /** スレッド。 */
+        std::thread thread_;
+        /** 仕事。 空なら待機中。 */
+        std::function<void()> task_;
+        /** スレッドを起こすためのコンディション。 */
+        std::condition_variable cond_;
+      };
+
+      // ================ //
+      // プライベート関数 //
+      // ================ //
+      /**
+       * スレッドの本体。
+       * @param worker 担当するWorker。
+       */
+      void ThreadMain(Worker& worker);
+
+      // ========== //
+      // メンバ変数 //
+      // ========== //
+      /** スレッドの数。 */
+      int num_threads_;
+      /** Workerのテーブル。 [スレッドの番号] */
+      std::unique_ptr<Worker[]> worker_table_;
+      /** 仕事中のスレッドの数。 */
+      int num_running_;
+      /** 終了フラグ。 */
+      bool is_quitting_;
+      /** ミューテックス。 */
+      std::mutex mutex_;
+      /** 仕事の終了を待つためのコンディション。 */
+      std::condition_variable done_cond_;
+  };
+}  // namespace Sayuri
+
+#endif
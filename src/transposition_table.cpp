@@ -31,9 +31,21 @@
 
 #include <iostream>
 #include <utility>
-#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
 #include <cstddef>
 #include "common.h"
+#include "chess_util.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /** Sayuri 名前空間。 */
 namespace Sayuri {
@@ -45,77 +57,69 @@ namespace Sayuri {
   // ==================== //
   // コンストラクタ。
   TranspositionTable::TranspositionTable(std::size_t table_size) :
-  null_entry_(),
-  num_entries_(1),
-  num_used_entries_(0),
-  entry_table_(nullptr),
+  num_buckets_(1),
+  memory_(nullptr),
+  memory_size_(0),
+  is_mapped_(false),
+  bucket_table_(nullptr),
   index_mask_(0),
-  age_(0x00010000UL) {
-    // エントリーをいくつ作るか決める。
-    // TTEntryのサイズは32バイトと決め打ちする。
-    u64 temp = table_size / TTEntry::TTENTRY_HARD_CODED_SIZE;
-    temp = temp < 1 ? 1 : temp;
-
-    // 以下は最上位ビットだけを残し、他のビットをゼロにするアルゴリズム。
-    temp = (temp & 0xffffffff00000000ULL)
-    ? (temp & 0xffffffff00000000ULL) : temp;
-
-    temp = (temp & 0xffff0000ffff0000ULL)
-    ? (temp & 0xffff0000ffff0000ULL) : temp;
-
-    temp = (temp & 0xff00ff00ff00ff00ULL)
-    ? (temp & 0xff00ff00ff00ff00ULL) : temp;
-
-    temp = (temp & 0xf0f0f0f0f0f0f0f0ULL)
-    ? (temp & 0xf0f0f0f0f0f0f0f0ULL) : temp;
-
-    temp = (temp & 0xccccccccccccccccULL)
-    ? (temp & 0xccccccccccccccccULL) : temp;
-
-    temp = (temp & 0xaaaaaaaaaaaaaaaaULL)
-    ? (temp & 0xaaaaaaaaaaaaaaaaULL) : temp;
-
-    num_entries_ = temp;
-    index_mask_ = temp - 1;
-
-    // テーブルを作成。
-    entry_table_.reset(new TTEntry[num_entries_]);
+  age_(0),
+  key_salt_(0),
+  generation_(0),
+  use_large_pages_(UCI_DEFAULT_LARGE_PAGES),
+  is_large_pages_(false),
+  num_threads_(1) {
+    SetSize(table_size);
   }
 
   // コピーコンストラクタ。
   TranspositionTable::TranspositionTable(const TranspositionTable& table) :
-  null_entry_(),
-  num_entries_(table.num_entries_),
-  num_used_entries_(table.num_used_entries_),
-  entry_table_(new TTEntry[table.num_entries_]),
+  num_buckets_(1),
+  memory_(nullptr),
+  memory_size_(0),
+  is_mapped_(false),
+  bucket_table_(nullptr),
   index_mask_(table.index_mask_),
-  age_(table.age_) {
-    for (std::size_t i = 0; i < num_entries_; ++i) {
-      entry_table_[i] = table.entry_table_[i];
-    }
+  age_(table.age_),
+  key_salt_(table.key_salt_),
+  generation_(table.generation_),
+  use_large_pages_(table.use_large_pages_),
+  is_large_pages_(false),
+  num_threads_(table.num_threads_) {
+    Allocate(table.num_buckets_);
+    CopyBuckets(table);
   }
 
   // ムーブコンストラクタ。
   TranspositionTable::TranspositionTable( TranspositionTable&& table) :
-  null_entry_(),
-  num_entries_(table.num_entries_),
-  num_used_entries_(table.num_used_entries_),
-  entry_table_(std::move(table.entry_table_)),
+  num_buckets_(table.num_buckets_),
+  memory_(table.memory_),
+  memory_size_(table.memory_size_),
+  is_mapped_(table.is_mapped_),
+  bucket_table_(table.bucket_table_),
   index_mask_(table.index_mask_),
-  age_(table.age_) {}
+  age_(table.age_),
+  key_salt_(table.key_salt_),
+  generation_(table.generation_),
+  use_large_pages_(table.use_large_pages_),
+  is_large_pages_(table.is_large_pages_),
+  num_threads_(table.num_threads_) {
+    table.memory_ = nullptr;
+    table.memory_size_ = 0;
+    table.bucket_table_ = nullptr;
+  }
 
   // コピー代入演算子。
   TranspositionTable&
   TranspositionTable::operator=(const TranspositionTable& table) {
-    num_entries_ = table.num_entries_;
-    num_used_entries_ = table.num_used_entries_;
-    entry_table_.reset(nullptr);
-    entry_table_.reset(new TTEntry[num_entries_]);
-    for (std::size_t i = 0; i < num_entries_; ++i) {
-      entry_table_[i] = table.entry_table_[i];
-    }
+    use_large_pages_ = table.use_large_pages_;
+    num_threads_ = table.num_threads_;
+    Allocate(table.num_buckets_);
+    CopyBuckets(table);
     index_mask_ = table.index_mask_;
     age_ = table.age_;
+    key_salt_ = table.key_salt_;
+    generation_ = table.generation_;
 
     return *this;
   }
@@ -123,78 +127,407 @@ namespace Sayuri {
   // ムーブ代入演算子。
   TranspositionTable&
   TranspositionTable::operator=(TranspositionTable&& table) {
-    num_entries_ = table.num_entries_;
-    num_used_entries_ = table.num_used_entries_;
-    entry_table_ = std::move(table.entry_table_);
+    Free();
+    num_buckets_ = table.num_buckets_;
+    memory_ = table.memory_;
+    memory_size_ = table.memory_size_;
+    is_mapped_ = table.is_mapped_;
+    bucket_table_ = table.bucket_table_;
+    table.memory_ = nullptr;
+    table.memory_size_ = 0;
+    table.bucket_table_ = nullptr;
     index_mask_ = table.index_mask_;
     age_ = table.age_;
+    key_salt_ = table.key_salt_;
+    generation_ = table.generation_;
+    use_large_pages_ = table.use_large_pages_;
+    is_large_pages_ = table.is_large_pages_;
+    num_threads_ = table.num_threads_;
 
     return *this;
   }
 
+  // ============== //
+  // パブリック関数 //
+  // ============== //
   // テーブルにエントリーを追加する。
   void TranspositionTable::Add(Hash pos_hash, int depth, int score,
   ScoreType score_type, Move best_move) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-
-    // テーブルのインデックスを得る。
-    std::size_t index = pos_hash & index_mask_;
+    // バケツを得る。
+    TTBucket& bucket = bucket_table_[pos_hash & index_mask_];
 
     // depthをプラスにしておく。
     depth = depth < 0 ? 0 : depth;
 
-    // 空いているエントリーへの登録なら使用済みエントリー数をカウント。
-    if (entry_table_[index].depth() == 0) {
-      ++num_used_entries_;
+    // 登録するエントリー。
+    TTEntry new_entry(pos_hash, depth, score, score_type, best_move, age_);
+    new_entry.generation(generation_);
+
+    // 置き換えるスロットを探す。
+    // - 同じ局面のエントリーがあればそれ。
+    // - 無ければ最初の空きスロット。 (Clear()以前の世代のエントリーも空き。)
+    //   (スロットは先頭から埋まるので、本当の空きより後ろは全て空き。)
+    // - 無ければ「残り深さ - 8 * 古さ」が一番小さいもの。
+    // (注) 別スレッドと競合して壊れたエントリーは別の局面のものとして扱う。
+    TTSlot* empty_ptr = nullptr;
+    TTSlot* target_ptr = nullptr;
+    int min_value = 0;
+    TTEntry old_entry;
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+      TTSlot& slot = bucket.slots_[i];
+      slot.Load(old_entry, key_salt_);
+
+      if (!IsCurrent(old_entry)) {
+        if (!empty_ptr) empty_ptr = &slot;
+        if (!old_entry) break;
+        continue;
+      }
+
+      if (old_entry.pos_hash_ == pos_hash) {
+        // 同じ局面。 同じ年齢でより深いエントリーなら残す。
+        if ((old_entry.table_age() == age_)
+        && (old_entry.depth() > depth)) {
+          return;
+        }
+        slot.Store(new_entry, key_salt_);
+        return;
+      }
+
+      int value = old_entry.depth()
+      - (8 * ((age_ - old_entry.table_age()) & TTEntry::AGE_MASK));
+      if (!target_ptr || (value < min_value)) {
+        target_ptr = &slot;
+        min_value = value;
+      }
     }
 
-    // テーブルが若い時にに登録されているものなら上書き。
-    // depthがすでに登録されているエントリー以上なら登録。
-    u32 age_depth = age_ | depth;
-    if (entry_table_[index].age_depth_ <= age_depth) {
-      entry_table_[index].pos_hash_ = pos_hash;
-      entry_table_[index].age_depth_ = age_depth;
-      entry_table_[index].score_ = score;
-      entry_table_[index].score_type_ = score_type;
-      entry_table_[index].best_move_ = best_move;
-    }
+    if (empty_ptr) target_ptr = empty_ptr;
+    target_ptr->Store(new_entry, key_salt_);
   }
 
   // エントリーを登録。
   void TranspositionTable::Add(const TTEntry& entry) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-
-    // テーブルのインデックスを得る。
-    std::size_t index = entry.pos_hash_ & index_mask_;
-
-    // 空いているエントリーへの登録なら使用済みエントリー数をカウント。
-    if (entry_table_[index].depth() == 0) {
-      ++num_used_entries_;
+    TTBucket& bucket = bucket_table_[entry.pos_hash_ & index_mask_];
+
+    TTEntry new_entry(entry);
+    new_entry.generation(generation_);
+
+    // 同じ局面のスロットか空きスロットに登録。 無ければ先頭に上書き。
+    // (Clear()以前の世代のエントリーも空き。)
+    TTEntry old_entry;
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+      bucket.slots_[i].Load(old_entry, key_salt_);
+      if (!IsCurrent(old_entry)
+      || (old_entry.pos_hash_ == new_entry.pos_hash_)) {
+        bucket.slots_[i].Store(new_entry, key_salt_);
+        return;
+      }
     }
-
-    // 登録。
-    entry_table_[index] = entry;
+    bucket.slots_[0].Store(new_entry, key_salt_);
   }
 
   // 条件を満たすエントリーを返す。
-  const TTEntry& TranspositionTable::GetEntry(Hash pos_hash) const {
-    // エントリーを得る。
-    std::size_t index = pos_hash & index_mask_;
-
-    if (entry_table_[index].pos_hash_ == pos_hash) {
-      return entry_table_[index];
+  TTEntry TranspositionTable::GetEntry(Hash pos_hash) const {
+    // バケツを得る。
+    const TTBucket& bucket = bucket_table_[pos_hash & index_mask_];
+
+    // 書き込み途中のエントリーや別の局面のエントリーはハッシュが一致しない。
+    TTEntry entry;
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+      bucket.slots_[i].Load(entry, key_salt_);
+      if (IsCurrent(entry) && (entry.pos_hash_ == pos_hash)) return entry;
     }
 
     // 条件外なので、無効なエントリーを返す。
-    return null_entry_;
+    return TTEntry();
   }
 
   // テーブルの中身をクリアする。
   void TranspositionTable::Clear() {
-    age_ = 0x00010000UL;
-    num_used_entries_ = 0;
-    for (std::size_t i = 0; i < num_entries_; ++i) {
-      entry_table_[i] = TTEntry();
+    // 既存のエントリーは、ハッシュが一致しなくなり、
+    // 世代も変わるので空きスロットとして置き換えられる。
+    key_salt_ += 0x9e3779b97f4a7c15ULL;
+    generation_ = (generation_ + 1) & TTEntry::GENERATION_MASK;
+    GrowOld();
+  }
+
+  // テーブルのサイズを変更する。
+  void TranspositionTable::SetSize(std::size_t table_size) {
+    // 初期化のため、値を変更。
+    age_ = 0;
+    key_salt_ = 0;
+    generation_ = 0;
+
+    // バケツをいくつ作るか決める。
+    u64 temp = table_size / sizeof(TTBucket);
+    temp = temp < 1 ? 1 : temp;
+
+    // 以下は最上位ビットだけを残し、他のビットをゼロにするアルゴリズム。
+    temp = (temp & 0xffffffff00000000ULL)
+    ? (temp & 0xffffffff00000000ULL) : temp;
+
+    temp = (temp & 0xffff0000ffff0000ULL)
+    ? (temp & 0xffff0000ffff0000ULL) : temp;
+
+    temp = (temp & 0xff00ff00ff00ff00ULL)
+    ? (temp & 0xff00ff00ff00ff00ULL) : temp;
+
+    temp = (temp & 0xf0f0f0f0f0f0f0f0ULL)
+    ? (temp & 0xf0f0f0f0f0f0f0f0ULL) : temp;
+
+    temp = (temp & 0xccccccccccccccccULL)
+    ? (temp & 0xccccccccccccccccULL) : temp;
+
+    temp = (temp & 0xaaaaaaaaaaaaaaaaULL)
+    ? (temp & 0xaaaaaaaaaaaaaaaaULL) : temp;
+
+    index_mask_ = temp - 1;
+
+    // テーブルを作成。
+    Allocate(temp);
+    InitBuckets();
+  }
+
+  // テーブルをファイルに保存する。
+  bool TranspositionTable::Save(const std::string& file_name,
+  Hash key_seed) const {
+    std::ofstream ofs(file_name, std::ios::binary | std::ios::trunc);
+    if (!ofs) return false;
+
+    // ヘッダ。
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, "SAYURITT", sizeof(header.magic_));
+    header.version_ = FILE_VERSION;
+    header.bucket_size_ = sizeof(TTBucket);
+    header.num_buckets_ = num_buckets_;
+    header.key_seed_ = key_seed;
+    header.key_salt_ = key_salt_;
+    header.age_ = age_;
+    header.generation_ = generation_;
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // バケツのテーブル。
+    ofs.write(reinterpret_cast<const char*>(bucket_table_),
+    num_buckets_ * sizeof(TTBucket));
+
+    return static_cast<bool>(ofs);
+  }
+
+  // ファイルからテーブルを読み込む。
+  bool TranspositionTable::Load(const std::string& file_name,
+  Hash key_seed) {
+    std::ifstream ifs(file_name, std::ios::binary);
+    if (!ifs) return false;
+
+    // ヘッダをチェック。
+    FileHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+      return false;
+    }
+    if ((std::memcmp(header.magic_, "SAYURITT", sizeof(header.magic_)) != 0)
+    || (header.version_ != FILE_VERSION)
+    || (header.bucket_size_ != sizeof(TTBucket))
+    || (header.num_buckets_ == 0)
+    || ((header.num_buckets_ & (header.num_buckets_ - 1)) != 0)
+    || (header.key_seed_ != key_seed)) {
+      return false;
+    }
+
+    // テーブルのサイズはUCIのHashで決めるので、勝手に変えない。
+    if (header.num_buckets_ != num_buckets_) return false;
+
+    // ファイルのサイズをチェック。
+    std::size_t table_bytes = header.num_buckets_ * sizeof(TTBucket);
+    std::size_t file_size = sizeof(header) + table_bytes;
+    ifs.seekg(0, std::ios::end);
+    if (static_cast<std::size_t>(ifs.tellg()) != file_size) return false;
+
+    bool is_loaded = false;
+#if defined(__linux__)
+    // ファイルをメモリにマップする。 (コピーオンライト)
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      void* ptr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if (ptr != MAP_FAILED) {
+        Free();
+        num_buckets_ = header.num_buckets_;
+        memory_ = static_cast<char*>(ptr);
+        memory_size_ = file_size;
+        is_mapped_ = true;
+        bucket_table_ = reinterpret_cast<TTBucket*>(memory_ + sizeof(header));
+        is_loaded = true;
+      }
+    }
+#endif
+
+    if (!is_loaded) {
+      // マップできなければ読み込む。
+      ifs.clear();
+      ifs.seekg(sizeof(header), std::ios::beg);
+      Allocate(header.num_buckets_);
+      if (!ifs.read(reinterpret_cast<char*>(bucket_table_), table_bytes)) {
+        // 途中で失敗したので、空のテーブルにしておく。
+        index_mask_ = num_buckets_ - 1;
+        InitBuckets();
+        return false;
+      }
+    }
+
+    index_mask_ = num_buckets_ - 1;
+    age_ = header.age_ & TTEntry::AGE_MASK;
+    key_salt_ = header.key_salt_;
+    generation_ = header.generation_ & TTEntry::GENERATION_MASK;
+
+    return true;
+  }
+
+  // ラージページを使うかどうかを設定する。
+  void TranspositionTable::SetLargePages(bool enable) {
+    if (enable != use_large_pages_) {
+      use_large_pages_ = enable;
+      SetSize(GetSizeBytes());
+    }
+  }
+
+  // 使用済みエントリーの占める割合。
+  int TranspositionTable::GetUsedPermill() const {
+    constexpr std::size_t MAX_SAMPLES = 1000 / NUM_SLOTS;
+    std::size_t num_samples =
+    num_buckets_ < MAX_SAMPLES ? num_buckets_ : MAX_SAMPLES;
+
+    std::size_t num_used = 0;
+    TTEntry entry;
+    for (std::size_t i = 0; i < num_samples; ++i) {
+      for (int j = 0; j < NUM_SLOTS; ++j) {
+        bucket_table_[i].slots_[j].Load(entry, key_salt_);
+        if (IsCurrent(entry) && (entry.table_age() == age_)) ++num_used;
+      }
+    }
+
+    return (num_used * 1000) / (num_samples * NUM_SLOTS);
+  }
+
+  // ================ //
+  // プライベート関数 //
+  // ================ //
+  // バケツのテーブルを確保する。
+  void TranspositionTable::Allocate(std::size_t num_buckets) {
+    Free();
+
+    num_buckets_ = num_buckets;
+    std::size_t table_bytes = num_buckets_ * sizeof(TTBucket);
+    std::size_t align = alignof(TTBucket);
+
+#if defined(__linux__)
+    if (use_large_pages_ && (table_bytes >= LARGE_PAGE_SIZE)) {
+      // まずはhugetlbfsのページで確保してみる。
+      // (テーブルのサイズは2の累乗なので、ラージページの倍数。)
+      void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+      ptr = mmap(nullptr, table_bytes, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+      if (ptr != MAP_FAILED) {
+        memory_size_ = table_bytes;
+        is_large_pages_ = true;
+      } else {
+        // 確保できなければTransparent Huge Pagesを要求する。
+        // ラージページの境界に揃えるため、1ページ分余分に確保する。
+        memory_size_ = table_bytes + LARGE_PAGE_SIZE;
+        ptr = mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED) {
+          align = LARGE_PAGE_SIZE;
+          std::size_t address = reinterpret_cast<std::size_t>(ptr);
+          address = (address + (align - 1)) & ~(align - 1);
+#if defined(MADV_HUGEPAGE)
+          is_large_pages_ = madvise(reinterpret_cast<void*>(address),
+          table_bytes, MADV_HUGEPAGE) == 0;
+#endif
+        }
+      }
+
+      if (ptr != MAP_FAILED) {
+        memory_ = static_cast<char*>(ptr);
+        is_mapped_ = true;
+      }
+    }
+#endif
+
+    if (!memory_) {
+      // 通常のメモリ。 キャッシュラインに揃えるため、1つ余分に確保する。
+      memory_size_ = table_bytes + sizeof(TTBucket);
+      memory_ = new char[memory_size_];
+    }
+
+    std::size_t address = reinterpret_cast<std::size_t>(memory_);
+    address = (address + (align - 1)) & ~(align - 1);
+    bucket_table_ = reinterpret_cast<TTBucket*>(address);
+  }
+
+  // バケツのテーブルを解放する。
+  void TranspositionTable::Free() {
+    if (memory_) {
+#if defined(__linux__)
+      if (is_mapped_) {
+        munmap(memory_, memory_size_);
+      } else {
+        delete[] memory_;
+      }
+#else
+      delete[] memory_;
+#endif
+    }
+
+    memory_ = nullptr;
+    memory_size_ = 0;
+    is_mapped_ = false;
+    is_large_pages_ = false;
+    bucket_table_ = nullptr;
+  }
+
+  // 全てのバケツを空にする。
+  void TranspositionTable::InitBuckets() {
+    // 小さいテーブルのためにスレッドを作らない。
+    std::size_t num_threads = num_buckets_ / MIN_BUCKETS_PER_THREAD;
+    num_threads = num_threads < 1 ? 1 : num_threads;
+    if (num_threads > static_cast<std::size_t>(num_threads_)) {
+      num_threads = num_threads_;
+    }
+
+    // スレッドごとに受け持つ範囲を空にする。
+    TTBucket* bucket_table = bucket_table_;
+    std::size_t chunk = num_buckets_ / num_threads;
+    auto init_range = [bucket_table](std::size_t begin, std::size_t end) {
+      const TTEntry null_entry;
+      for (std::size_t i = begin; i < end; ++i) {
+        for (int j = 0; j < NUM_SLOTS; ++j) {
+          bucket_table[i].slots_[j].Store(null_entry, 0);
+        }
+      }
+    };
+
+    std::vector<std::thread> thread_vec;
+    for (std::size_t i = 1; i < num_threads; ++i) {
+      std::size_t end = (i + 1) == num_threads ? num_buckets_ : chunk * (i + 1);
+      thread_vec.push_back(std::thread(init_range, chunk * i, end));
+    }
+    init_range(0, num_threads == 1 ? num_buckets_ : chunk);
+    for (auto& thread : thread_vec) thread.join();
+  }
+
+  // テーブルの内容をコピーする。
+  void TranspositionTable::CopyBuckets(const TranspositionTable& table) {
+    TTEntry entry;
+    for (std::size_t i = 0; i < num_buckets_; ++i) {
+      for (int j = 0; j < NUM_SLOTS; ++j) {
+        table.bucket_table_[i].slots_[j].Load(entry, 0);
+        bucket_table_[i].slots_[j].Store(entry, 0);
+      }
     }
   }
 
@@ -202,10 +535,21 @@ namespace Sayuri {
   // エントリーのクラス //
   // ================== //
   // --- static定数 --- //
-  constexpr u32 TTEntry::DEPTH_MASK;
-  constexpr u32 TTEntry::AGE_MASK;
+  constexpr u64 TTEntry::SCORE_MASK;
+  constexpr u64 TTEntry::MOVE_MASK;
+  constexpr u64 TTEntry::TYPE_MASK;
+  constexpr u64 TTEntry::DEPTH_MASK;
+  constexpr int TTEntry::SCORE_SHIFT;
+  constexpr int TTEntry::MOVE_SHIFT;
+  constexpr int TTEntry::TYPE_SHIFT;
   constexpr int TTEntry::DEPTH_SHIFT;
   constexpr int TTEntry::AGE_SHIFT;
+  constexpr u32 TTEntry::AGE_MASK;
+  constexpr u32 TTEntry::TTENTRY_HARD_CODED_SIZE;
+  constexpr u32 TranspositionTable::FILE_VERSION;
+  constexpr int TranspositionTable::NUM_SLOTS;
+  constexpr std::size_t TranspositionTable::LARGE_PAGE_SIZE;
+  constexpr std::size_t TranspositionTable::MIN_BUCKETS_PER_THREAD;
 
   // ==================== //
   // コンストラクタと代入 //
@@ -214,42 +558,34 @@ namespace Sayuri {
   TTEntry::TTEntry(Hash pos_hash, int depth, int score,
   ScoreType score_type, Move best_move, u32 table_age) :
   pos_hash_(pos_hash),
-  age_depth_(table_age | depth),
-  score_(score),
-  score_type_(score_type),
-  best_move_(best_move) {}
+  data_(((static_cast<u64>(static_cast<u32>(score)) & SCORE_MASK)
+  << SCORE_SHIFT)
+  | ((static_cast<u64>(best_move) & MOVE_MASK) << MOVE_SHIFT)
+  | ((static_cast<u64>(static_cast<int>(score_type) + 1) & TYPE_MASK)
+  << TYPE_SHIFT)
+  | ((static_cast<u64>(Util::GetMin(Util::GetMax(depth, 0), 0xff))
+  & DEPTH_MASK) << DEPTH_SHIFT)
+  | ((static_cast<u64>(table_age) & AGE_MASK) << AGE_SHIFT)) {}
 
   // コンストラクタ。
   TTEntry::TTEntry() :
   pos_hash_(0),
-  age_depth_(0),
-  score_(0),
-  score_type_(ScoreType::ALPHA),
-  best_move_(0) {}
+  data_(0) {}
 
   // コピーコンストラクタ。
   TTEntry::TTEntry(const TTEntry& entry) :
   pos_hash_(entry.pos_hash_),
-  age_depth_(entry.age_depth_),
-  score_(entry.score_),
-  score_type_(entry.score_type_),
-  best_move_(entry.best_move_) {}
+  data_(entry.data_) {}
 
   // ムーブコンストラクタ。
   TTEntry::TTEntry(TTEntry&& entry) :
   pos_hash_(entry.pos_hash_),
-  age_depth_(entry.age_depth_),
-  score_(entry.score_),
-  score_type_(entry.score_type_),
-  best_move_(entry.best_move_) {}
+  data_(entry.data_) {}
 
   // コピー代入演算子。
   TTEntry& TTEntry::operator=(const TTEntry& entry) {
     pos_hash_ = entry.pos_hash_;
-    age_depth_ = entry.age_depth_;
-    score_ = entry.score_;
-    score_type_ = entry.score_type_;
-    best_move_ = entry.best_move_;
+    data_ = entry.data_;
 
     return *this;
   }
@@ -257,10 +593,7 @@ namespace Sayuri {
   // ムーブ代入演算子。
   TTEntry& TTEntry::operator=(TTEntry&& entry) {
     pos_hash_ = entry.pos_hash_;
-    age_depth_ = entry.age_depth_;
-    score_ = entry.score_;
-    score_type_ = entry.score_type_;
-    best_move_ = entry.best_move_;
+    data_ = entry.data_;
 
     return *this;
   }
@@ -32,7 +32,8 @@
 
 #include <iostream>
 #include <memory>
-#include <mutex>
+#include <string>
+#include <atomic>
 #include <cstddef>
 #include "common.h"
 
@@ -40,22 +41,43 @@
 namespace Sayuri {
   class TranspositionTable;
 
-  /** トランスポジションテーブルのエントリー。 */
+  /**
+   * トランスポジションテーブルのエントリー。
+   * 64ビットに圧縮したデータとポジションのハッシュの組。
+   */
   class TTEntry {
     private:
-      /** 残り探索深さのマスク。 **/
-      constexpr static u32 DEPTH_MASK = 0x0000ffffUL;
-      /** テーブルの年齢のマスク。 **/
-      constexpr static u32 AGE_MASK = 0xffff0000UL;
-
-      /** 残り探索深さシフト。 */
-      constexpr static int DEPTH_SHIFT = 0;
-      /** テーブルの年齢シフト。 */
-      constexpr static int AGE_SHIFT = 16;
+      /** 評価値のマスク。 (符号付き24 bits) */
+      constexpr static u64 SCORE_MASK = 0xffffffULL;
+      /** 評価値の符号ビット。 */
+      constexpr static u64 SCORE_SIGN = 0x800000ULL;
+      /** クリアの世代のマスク。 */
+      constexpr static u64 GENERATION_MASK = 0xffULL;
+      /** 最善手のマスク。 (Move::BASE_MASKの15 bits) */
+      constexpr static u64 MOVE_MASK = 0x7fffULL;
+      /** 評価値の種類のマスク。 (0は空きエントリー) */
+      constexpr static u64 TYPE_MASK = 0x3ULL;
+      /** 残り探索深さのマスク。 */
+      constexpr static u64 DEPTH_MASK = 0xffULL;
+
+      /** 評価値のシフト。 */
+      constexpr static int SCORE_SHIFT = 0;
+      /** クリアの世代のシフト。 */
+      constexpr static int GENERATION_SHIFT = 24;
+      /** 最善手のシフト。 */
+      constexpr static int MOVE_SHIFT = 32;
+      /** 評価値の種類のシフト。 */
+      constexpr static int TYPE_SHIFT = 47;
+      /** 残り探索深さのシフト。 */
+      constexpr static int DEPTH_SHIFT = 49;
+      /** テーブルの年齢のシフト。 */
+      constexpr static int AGE_SHIFT = 57;
 
     public:
-      /** TTEntryの決め打ちサイズ。 */
-      constexpr static u32 TTENTRY_HARD_CODED_SIZE = 32;
+      /** テーブルの年齢のマスク。 */
+      constexpr static u32 AGE_MASK = 0x7fUL;
+      /** テーブル上のエントリーの決め打ちサイズ。 (ハッシュ + データ) */
+      constexpr static u32 TTENTRY_HARD_CODED_SIZE = 16;
 
       // ==================== //
       // コンストラクタと代入 //
@@ -103,7 +125,7 @@ namespace Sayuri {
        * 内容が有効かどうか。
        */
       explicit operator bool() const {
-        return age_depth_ != 0;
+        return ((data_ >> TYPE_SHIFT) & TYPE_MASK) != 0;
       }
 
       // ======== //
@@ -119,35 +141,61 @@ namespace Sayuri {
        * @return 残り深さ。
        */
       int depth() const {
-        return age_depth_ & DEPTH_MASK;
+        return (data_ >> DEPTH_SHIFT) & DEPTH_MASK;
       }
       /**
        * アクセサ - 評価値。
        * @return 評価値。
        */
-      int score() const {return score_;}
+      int score() const {
+        return static_cast<int>
+        (((data_ >> SCORE_SHIFT) & SCORE_MASK) ^ SCORE_SIGN)
+        - static_cast<int>(SCORE_SIGN);
+      }
       /**
        * アクセサ - 評価値の種類。
        * @return 評価値の種類。
        */
-      ScoreType score_type() const {return score_type_;}
+      ScoreType score_type() const {
+        return static_cast<ScoreType>(((data_ >> TYPE_SHIFT) & TYPE_MASK) - 1);
+      }
       /**
-       * アクセサ - 最善手。
+       * アクセサ - 最善手。 (駒の移動と昇格のみ)
        * @return 最善手。
        */
-      Move best_move() const {return best_move_;}
+      Move best_move() const {
+        return (data_ >> MOVE_SHIFT) & MOVE_MASK;
+      }
       /**
        * アクセサ - トランスポジションテーブルの年齢。
        * @return トランスポジションテーブルの年齢。
        */
       u32 table_age() const {
-        return age_depth_ & AGE_MASK;
+        return (data_ >> AGE_SHIFT) & AGE_MASK;
+      }
+      /**
+       * アクセサ - 登録した時のテーブルのクリアの世代。
+       * @return テーブルのクリアの世代。
+       */
+      u32 generation() const {
+        return (data_ >> GENERATION_SHIFT) & GENERATION_MASK;
       }
 
     private:
       /** TranspositionTableはフレンド。 */
       friend class TranspositionTable;
 
+      /**
+       * ミューテータ - テーブルのクリアの世代。
+       * (TranspositionTableが登録する時に書き込む。)
+       * @param generation テーブルのクリアの世代。
+       */
+      void generation(u32 generation) {
+        data_ = (data_ & ~(GENERATION_MASK << GENERATION_SHIFT))
+        | ((static_cast<u64>(generation) & GENERATION_MASK)
+        << GENERATION_SHIFT);
+      }
+
       // ========== //
       // メンバ変数 //
       // ========== //
@@ -155,16 +203,14 @@ namespace Sayuri {
       Hash pos_hash_;
       /**
        * ビットフィールド。
-       * - テーブルの年齢(上位16 bits)。
-       * - 残り探索深さ(下位16 bits)。
-       */
-      u32 age_depth_;
-      /** 評価値。 */
-      i32 score_;
-      /** 評価値の種類。 */
-      ScoreType score_type_;
-      /** 最善手。 */
-      Move best_move_;
+       * - 評価値(0 - 23 bits)。
+       * - テーブルのクリアの世代(24 - 31 bits)。
+       * - 最善手(32 - 46 bits)。
+       * - 評価値の種類 + 1 (47 - 48 bits)。 0なら空きエントリー。
+       * - 残り探索深さ(49 - 56 bits)。
+       * - テーブルの年齢(57 - 63 bits)。
+       */
+      u64 data_;
   };
 
   /** トランスポジションテーブルのクラス。 */
@@ -199,7 +245,7 @@ namespace Sayuri {
        */
       TranspositionTable& operator=(TranspositionTable&& table);
       /** デストラクタ。 */
-      virtual ~TranspositionTable() {}
+      virtual ~TranspositionTable() {Free();}
       /** コンストラクタ。 (削除) */
       TranspositionTable() = delete;
 
@@ -207,7 +253,7 @@ namespace Sayuri {
       // パブリック関数 //
       // ============== //
       /**
-       * テーブルにエントリーを追加。
+       * テーブルにエントリーを追加。 ロックはしない。
        * @param pos_hash ポジションのハッシュ。
        * @param depth 残り深さ。
        * @param score 評価値。
@@ -218,86 +264,82 @@ namespace Sayuri {
       Move best_move);
 
       /**
-       * テーブルにエントリーを追加。
+       * テーブルにエントリーを追加。 ロックはしない。
        * @param entry 登録するエントリー。
        */
       void Add(const TTEntry& entry);
 
       /**
-       * 条件を満たすエントリーを得る。
+       * 条件を満たすエントリーを得る。 ロックはしない。
+       * 書き込み途中のエントリーはハッシュの照合で弾かれる。
        * @param pos_hash 条件のハッシュ。
-       * @return 条件を満たすエントリー。
+       * @return 条件を満たすエントリーのコピー。 無ければ無効なエントリー。
        */
-      const TTEntry& GetEntry(Hash pos_hash) const;
+      TTEntry GetEntry(Hash pos_hash) const;
 
       /** 年を取る。 */
-      void GrowOld() {age_ += 0x00010000UL;}
+      void GrowOld() {age_ = (age_ + 1) & TTEntry::AGE_MASK;}
 
       /**
        * テーブル内容をクリアする。
+       * メモリには触らず、ハッシュに混ぜる値と世代を変えて
+       * 既存のエントリーを全て無効にする。 (テーブルのサイズに関わらず一瞬)
        */
       void Clear();
 
       /**
        * テーブルのサイズを変更する。 内容は初期化される。
+       * テーブルのメモリは num_threads() 個のスレッドで並列に初期化し、
+       * NUMA環境では各スレッドのノードにページを分散させる。
        * @param table_size 新しいサイズ。
        */
-      void SetSize(std::size_t table_size) {
-        // 初期化のため、値を変更。
-        age_ = 0x00010000UL;
-        num_used_entries_ = 0;
-
-        // エントリーをいくつ作るか決める。
-        u64 temp = table_size / TTEntry::TTENTRY_HARD_CODED_SIZE;
-        temp = temp < 1 ? 1 : temp;
-
-        // 以下は最上位ビットだけを残し、他のビットをゼロにするアルゴリズム。
-        temp = (temp & 0xffffffff00000000ULL)
-        ? (temp & 0xffffffff00000000ULL) : temp;
-
-        temp = (temp & 0xffff0000ffff0000ULL)
-        ? (temp & 0xffff0000ffff0000ULL) : temp;
-
-        temp = (temp & 0xff00ff00ff00ff00ULL)
-        ? (temp & 0xff00ff00ff00ff00ULL) : temp;
+      void SetSize(std::size_t table_size);
 
-        temp = (temp & 0xf0f0f0f0f0f0f0f0ULL)
-        ? (temp & 0xf0f0f0f0f0f0f0f0ULL) : temp;
-
-        temp = (temp & 0xccccccccccccccccULL)
-        ? (temp & 0xccccccccccccccccULL) : temp;
-
-        temp = (temp & 0xaaaaaaaaaaaaaaaaULL)
-        ? (temp & 0xaaaaaaaaaaaaaaaaULL) : temp;
+      /**
+       * テーブルをファイルに保存する。
+       * ヘッダ(サイズ、年齢、ハッシュ値の種など)の後に
+       * バケツのテーブルをそのまま書き出す。
+       * @param file_name ファイル名。
+       * @param key_seed 局面のハッシュ値を生成した乱数の種。
+       * @return 保存できたらtrue。
+       */
+      bool Save(const std::string& file_name, Hash key_seed) const;
 
-        num_entries_ = temp;
-        index_mask_ = temp - 1;
+      /**
+       * Save()で保存したファイルからテーブルを読み込む。
+       * 可能ならファイルをメモリにマップして、そのままテーブルとして使う。
+       * (書き込みはファイルに反映されない。)
+       * @param file_name ファイル名。
+       * @param key_seed 局面のハッシュ値を生成した乱数の種。
+       * 保存した時と違えば読み込まない。
+       * @return 読み込めたらtrue。
+       * (ヘッダが合わなければテーブルは変わらない。
+       * テーブルのサイズが保存した時と違っても読み込まない。)
+       */
+      bool Load(const std::string& file_name, Hash key_seed);
 
-        // テーブルを作成。
-        entry_table_.reset(nullptr);
-        entry_table_.reset(new TTEntry[num_entries_]);
-      }
+      /**
+       * ラージページを使うかどうかを設定する。
+       * 設定が変わればテーブルを確保し直す。 (内容は初期化される。)
+       * @param enable 使うならtrue。
+       */
+      void SetLargePages(bool enable);
 
       /**
        * テーブルのサイズを返す。 (バイト)
        * @return テーブルのサイズ。
        */
       std::size_t GetSizeBytes() const {
-        return num_entries_ * sizeof(TTEntry);
+        return num_buckets_ * sizeof(TTBucket);
       }
 
       /**
        * 使用済みエントリーの占める割合。 (パーミル)
+       * テーブルの先頭の最大1000エントリーのうち、
+       * 現在の年齢のエントリーの数から概算する。
        * @return 使用済みエントリーの占める割合。
        */
-      int GetUsedPermill() const {
-        return (num_used_entries_ * 1000) / num_entries_;
-      }
-
-      /** トランスポジションテーブルのロックでロックする。 */
-      void Lock() {mutex_.lock();}
-      /** トランスポジションテーブルのロックのロックを解除する。。 */
-      void Unlock() {mutex_.unlock();}
+      int GetUsedPermill() const;
 
       // ======== //
       // アクセサ //
@@ -307,28 +349,181 @@ namespace Sayuri {
        * @return 年齢。
        */
       int age() const {return age_;}
+      /**
+       * アクセサ - ラージページを使う設定かどうか。
+       * @return ラージページを使う設定ならtrue。
+       */
+      bool use_large_pages() const {return use_large_pages_;}
+      /**
+       * アクセサ - ラージページを要求してメモリを確保できたかどうか。
+       * @return ラージページを要求して確保できたならtrue。
+       */
+      bool is_large_pages() const {return is_large_pages_;}
+      /**
+       * アクセサ - テーブルを初期化するスレッドの数。
+       * @return テーブルを初期化するスレッドの数。
+       */
+      int num_threads() const {return num_threads_;}
+
+      // ============ //
+      // ミューテータ //
+      // ============ //
+      /**
+       * ミューテータ - テーブルを初期化するスレッドの数。
+       * @param num_threads テーブルを初期化するスレッドの数。
+       */
+      void num_threads(int num_threads) {
+        num_threads_ = num_threads < 1 ? 1 : num_threads;
+      }
 
     private:
       /** フレンドのデバッグ用関数。 */
       friend int DebugMain(int argc, char* argv[]);
 
+      /**
+       * テーブル上のエントリー。
+       * ロックしない代わりに、ハッシュをデータとXORして保存する。
+       * 読み込んだハッシュとデータをXORして元のハッシュに戻らなければ、
+       * 別スレッドによる書き込み途中のエントリー。
+       */
+      struct TTSlot {
+        /** ポジションのハッシュ ^ データ。 */
+        std::atomic<u64> key_;
+        /** 圧縮されたデータ。 */
+        std::atomic<u64> data_;
+
+        /**
+         * エントリーを読み込む。
+         * @param entry 読み込み先。
+         * @param key_salt ハッシュに混ぜる値。
+         */
+        void Load(TTEntry& entry, Hash key_salt) const {
+          u64 key = key_.load(std::memory_order_relaxed);
+          u64 data = data_.load(std::memory_order_relaxed);
+          entry.pos_hash_ = key ^ data ^ key_salt;
+          entry.data_ = data;
+        }
+        /**
+         * エントリーを書き込む。
+         * @param entry 書き込むエントリー。
+         * @param key_salt ハッシュに混ぜる値。
+         */
+        void Store(const TTEntry& entry, Hash key_salt) {
+          key_.store(entry.pos_hash_ ^ entry.data_ ^ key_salt,
+          std::memory_order_relaxed);
+          data_.store(entry.data_, std::memory_order_relaxed);
+        }
+      };
+
+      /** 保存するファイルのヘッダ。 */
+      struct FileHeader {
+        /** ファイルの識別子。 ("SAYURITT") */
+        char magic_[8];
+        /** フォーマットのバージョン。 */
+        u32 version_;
+        /** バケツのサイズ。 (バイト) */
+        u32 bucket_size_;
+        /** バケツの個数。 */
+        u64 num_buckets_;
+        /** 局面のハッシュ値を生成した乱数の種。 */
+        u64 key_seed_;
+        /** 全てのエントリーのハッシュに混ぜる値。 */
+        u64 key_salt_;
+        /** 年齢。 */
+        u32 age_;
+        /** クリアの世代。 */
+        u32 generation_;
+        /** 予約領域。 (バケツのテーブルをキャッシュラインに揃える。) */
+        u8 reserved_[16];
+      };
+
+      /** ファイルのフォーマットのバージョン。 */
+      constexpr static u32 FILE_VERSION = 2;
+
+      /** 1つのバケツに入るエントリーの数。 */
+      constexpr static int NUM_SLOTS = 4;
+
+      /**
+       * エントリーのバケツ。
+       * キャッシュライン(64バイト)に揃え、1回のメモリアクセスで探索する。
+       */
+      struct alignas(64) TTBucket {
+        /** エントリー。 */
+        TTSlot slots_[NUM_SLOTS];
+      };
+
+      /** ラージページのサイズ。 */
+      constexpr static std::size_t LARGE_PAGE_SIZE = 2ULL * 1024ULL * 1024ULL;
+
+      /** 初期化の時、1スレッドが受け持つ最小のバケツの数。 (4 MB) */
+      constexpr static std::size_t MIN_BUCKETS_PER_THREAD = 1ULL << 16;
+
+      /**
+       * バケツのテーブルを確保する。 内容は不定。
+       * ラージページが使えればラージページで確保し、
+       * 使えなければ通常のメモリで確保する。
+       * @param num_buckets バケツの数。
+       */
+      void Allocate(std::size_t num_buckets);
+
+      /** バケツのテーブルを解放する。 */
+      void Free();
+
+      /**
+       * 全てのバケツを空にする。
+       * num_threads_個のスレッドで分担して書き込む。 (ファーストタッチ)
+       */
+      void InitBuckets();
+
+      /**
+       * テーブルの内容をコピーする。
+       * @param table コピー元。
+       */
+      void CopyBuckets(const TranspositionTable& table);
+
+      /**
+       * 現在の世代の有効なエントリーかどうか。
+       * (Clear()以前のエントリーは空きと同じ。)
+       * @param entry 調べるエントリー。
+       * @return 現在の世代の有効なエントリーならtrue。
+       */
+      bool IsCurrent(const TTEntry& entry) const {
+        return entry && (entry.generation() == generation_);
+      }
+
       // ========== //
       // メンバ変数 //
       // ========== //
-      /** 無効なエントリー。 */
-      const TTEntry null_entry_;
-      /** エントリーの個数。 */
-      std::size_t num_entries_;
-      /** 使用済みのエントリーの個数。 */
-      std::size_t num_used_entries_;
-      /** エントリーを登録するテーブル。 */
-      std::unique_ptr<TTEntry[]> entry_table_;
-      /** エントリーのインデックスを得るためのマスク。 */
+      /** バケツの個数。 */
+      std::size_t num_buckets_;
+      /** テーブルのメモリ。 (揃える前の先頭) */
+      char* memory_;
+      /** 確保したメモリのサイズ。 (バイト) */
+      std::size_t memory_size_;
+      /** memory_がmmap()で確保されたものかどうか。 */
+      bool is_mapped_;
+      /** バケツのテーブル。 (memory_内をキャッシュラインに揃えたもの) */
+      TTBucket* bucket_table_;
+      /** バケツのインデックスを得るためのマスク。 */
       Hash index_mask_;
       /** 年齢。 */
       u32 age_;
-      /** ミューテックス。 */
-      std::mutex mutex_;
+      /**
+       * 全てのエントリーのハッシュに混ぜる値。
+       * Clear()で変えると、それ以前のエントリーはどの局面とも一致しなくなる。
+       */
+      Hash key_salt_;
+      /**
+       * クリアの世代。 Clear()で進める。
+       * 世代の違うエントリーは空きスロットとして扱う。
+       */
+      u32 generation_;
+      /** ラージページを使う設定かどうか。 */
+      bool use_large_pages_;
+      /** ラージページを要求して確保できたかどうか。 */
+      bool is_large_pages_;
+      /** テーブルを初期化するスレッドの数。 */
+      int num_threads_;
   };
 }  // namespace Sayuri
 
@@ -69,7 +69,9 @@ namespace Sayuri {
   moves_to_search_(0),
   enable_pondering_(UCI_DEFAULT_PONDER),
   num_threads_(UCI_DEFAULT_THREADS),
+  enable_lazy_smp_(UCI_DEFAULT_LAZY_SMP),
   analyse_mode_(UCI_DEFAULT_ANALYSE_MODE),
+  hash_file_(UCI_DEFAULT_HASH_FILE),
   output_listeners_(0) {
     // コマンドを登録する。
     // uciコマンド。
@@ -106,6 +108,14 @@ namespace Sayuri {
     // ponderhitコマンド。
     uci_command_.Add("ponderhit", {"ponderhit"},
     [this](UCICommand::CommandArgs& args) {this->CommandPonderHit(args);});
+
+    // perftコマンド。 (独自拡張)
+    uci_command_.Add("perft", {"perft", "hash"},
+    [this](UCICommand::CommandArgs& args) {this->CommandPerft(args);});
+
+    // divideコマンド。 (独自拡張)
+    uci_command_.Add("divide", {"divide", "hash"},
+    [this](UCICommand::CommandArgs& args) {this->CommandDivide(args);});
   }
 
   // コピーコンストラクタ。
@@ -115,7 +125,9 @@ namespace Sayuri {
   moves_to_search_(shell.moves_to_search_),
   enable_pondering_(shell.enable_pondering_),
   num_threads_(shell.num_threads_),
+  enable_lazy_smp_(shell.enable_lazy_smp_),
   analyse_mode_(shell.analyse_mode_),
+  hash_file_(shell.hash_file_),
   output_listeners_(shell.output_listeners_) {
   }
 
@@ -126,7 +138,9 @@ namespace Sayuri {
   moves_to_search_(std::move(shell.moves_to_search_)),
   enable_pondering_(shell.enable_pondering_),
   num_threads_(shell.num_threads_),
+  enable_lazy_smp_(shell.enable_lazy_smp_),
   analyse_mode_(shell.analyse_mode_),
+  hash_file_(std::move(shell.hash_file_)),
   output_listeners_(std::move(shell.output_listeners_)) {
   }
 
@@ -137,7 +151,9 @@ namespace Sayuri {
     moves_to_search_ = shell.moves_to_search_;
     enable_pondering_ = shell.enable_pondering_;
     num_threads_ = shell.num_threads_;
+    enable_lazy_smp_ = shell.enable_lazy_smp_;
     analyse_mode_ = shell.analyse_mode_;
+    hash_file_ = shell.hash_file_;
     output_listeners_ = shell.output_listeners_;
     return *this;
   }
@@ -149,7 +165,9 @@ namespace Sayuri {
     moves_to_search_ = std::move(shell.moves_to_search_);
     enable_pondering_ = shell.enable_pondering_;
     num_threads_ = shell.num_threads_;
+    enable_lazy_smp_ = shell.enable_lazy_smp_;
     analyse_mode_ = shell.analyse_mode_;
+    hash_file_ = std::move(shell.hash_file_);
     output_listeners_ = std::move(shell.output_listeners_);
     return *this;
   }
@@ -315,6 +333,23 @@ namespace Sayuri {
     }
   }
 
+  // ポーンや評価値のハッシュテーブルの統計を出力する。
+  void UCIShell::PrintTableInfo(const std::string& name, u64 num_probes,
+  u64 num_hits) {
+    std::unique_lock<std::mutex> lock(print_mutex_);  // ロック。
+
+    std::ostringstream sout;
+    sout << "info string " << name << " probes " << num_probes;
+    sout << " hits " << num_hits;
+    sout << " hitpermill "
+    << (num_probes ? ((num_hits * 1000) / num_probes) : 0);
+
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+  }
+
   // 探索スレッド。
   void UCIShell::ThreadThinking() {
     // アナライズモードならトランスポジションテーブルを初期化。
@@ -327,7 +362,8 @@ namespace Sayuri {
 
     // 思考開始。
     PVLine pv_line =
-    engine_ptr_->Calculate(num_threads_, moves_to_search_, *this);
+    engine_ptr_->Calculate(num_threads_, enable_lazy_smp_, moves_to_search_,
+    *this);
 
     // 最善手を表示。
     std::ostringstream sout;
@@ -349,6 +385,72 @@ namespace Sayuri {
     }
   }
 
+  // Perftを実行して結果を出力する。
+  void UCIShell::RunPerft(UCICommand::CommandArgs& args,
+  const std::string& command_name, bool print_divide) {
+    // 深さ。 (コマンド名の次のトークン)
+    int depth = 0;
+    try {
+      depth = std::stoi(args[command_name].at(1));
+    } catch (...) {
+      return;
+    }
+
+    // hashサブコマンド。 (メガバイト)
+    std::size_t hash_size = 0;
+    if (args.find("hash") != args.end()) {
+      try {
+        hash_size = std::stoull(args["hash"].at(1)) * 1024ull * 1024ull;
+      } catch (...) {
+        // 無視。
+      }
+    }
+
+    // 思考スレッドを終了させる。
+    engine_ptr_->StopCalculation();
+    try {
+      thinking_thread_.join();
+    } catch (const std::system_error&) {
+      // 無視。
+    }
+
+    // Perft実行。
+    TimePoint start_time = SysClock::now();
+    std::vector<std::pair<Move, u64>> result =
+    engine_ptr_->Perft(depth, num_threads_, hash_size);
+    int time = Chrono::duration_cast<Chrono::milliseconds>
+    (SysClock::now() - start_time).count();
+    if (time <= 0) time = 1;
+
+    std::unique_lock<std::mutex> lock(print_mutex_);  // ロック。
+
+    std::ostringstream sout;
+    u64 num_nodes = 0;
+    for (auto& pair : result) {
+      num_nodes += pair.second;
+
+      // ルートの合法手毎のノード数。
+      if (print_divide) {
+        sout.str("");
+        sout << Util::MoveToString(pair.first) << ": " << pair.second;
+        // 出力関数に送る。
+        for (auto& func : output_listeners_) {
+          func(sout.str());
+        }
+      }
+    }
+
+    sout.str("");
+    sout << "info depth " << depth;
+    sout << " time " << time;
+    sout << " nodes " << num_nodes;
+    sout << " nps " << (num_nodes * 1000) / time;
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+  }
+
   // =============== //
   // uciコマンド関数 //
   // =============== //
@@ -403,6 +505,26 @@ namespace Sayuri {
       func(sout.str());
     }
 
+    // トランスポジションテーブルにラージページを使うかどうか。
+    sout.str("");
+    sout << "option name Large Pages type check default ";
+    if (UCI_DEFAULT_LARGE_PAGES) sout << "true";
+    else sout << "false";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // 評価値のハッシュテーブルのサイズ。 (スレッド毎)
+    sout.str("");
+    sout << "option name Eval Hash type spin default "
+    << (UCI_DEFAULT_EVAL_TABLE_SIZE / (1024 * 1024)) << " min "
+    << 0 << " max " << (UCI_MAX_EVAL_TABLE_SIZE / (1024 * 1024));
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
     // スレッドの数。
     sout.str("");
     sout << "option name Threads type spin default "
@@ -412,6 +534,16 @@ namespace Sayuri {
       func(sout.str());
     }
 
+    // 並列探索にLazy SMPを使うかどうか。
+    sout.str("");
+    sout << "option name Lazy SMP type check default ";
+    if (UCI_DEFAULT_LAZY_SMP) sout << "true";
+    else sout << "false";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
     // アナライズモード。
     sout.str("");
     sout << "option name UCI_AnalyseMode type check default ";
@@ -422,6 +554,40 @@ namespace Sayuri {
       func(sout.str());
     }
 
+    // 局面のハッシュ値を生成する種。
+    sout.str("");
+    sout << "option name Hash Key Seed type string default "
+    << UCI_DEFAULT_HASH_KEY_SEED;
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルを保存するファイル。
+    sout.str("");
+    sout << "option name Hash File type string default "
+    << UCI_DEFAULT_HASH_FILE;
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルをファイルに保存。
+    sout.str("");
+    sout << "option name Save Hash type button";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルをファイルから読み込む。
+    sout.str("");
+    sout << "option name Load Hash type button";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
     // オーケー。
     // 出力関数に送る。
     for (auto& func : output_listeners_) {
@@ -429,9 +595,16 @@ namespace Sayuri {
     }
 
     // オプションの初期設定。
-    engine_ptr_->table().SetSize(UCI_DEFAULT_TABLE_SIZE);
     enable_pondering_ = UCI_DEFAULT_PONDER;
     num_threads_ = UCI_DEFAULT_THREADS;
+    enable_lazy_smp_ = UCI_DEFAULT_LAZY_SMP;
+    hash_file_ = UCI_DEFAULT_HASH_FILE;
+    engine_ptr_->SetNumThreads(num_threads_);
+    engine_ptr_->table().num_threads(num_threads_);
+    engine_ptr_->SetHashKeySeed(UCI_DEFAULT_HASH_KEY_SEED);
+    engine_ptr_->SetEvalTableSize(UCI_DEFAULT_EVAL_TABLE_SIZE);
+    engine_ptr_->table().SetLargePages(UCI_DEFAULT_LARGE_PAGES);
+    engine_ptr_->table().SetSize(UCI_DEFAULT_TABLE_SIZE);
   }
 
   // 「isready」コマンドのコールバック関数。
@@ -443,12 +616,9 @@ namespace Sayuri {
 
   // 「setoption」コマンドのコールバック関数。
   void UCIShell::CommandSetOption(UCICommand::CommandArgs& args) {
-    // nameとvalueがあるかどうか。
+    // nameがあるかどうか。
     // なければ設定できない。
-    if ((args.find("name") == args.end())
-    || (args.find("value") == args.end())) {
-      return;
-    }
+    if (args.find("name") == args.end()) return;
 
     // nameの文字列をくっつける。
     std::string name_str = "";
@@ -460,6 +630,46 @@ namespace Sayuri {
     // nameの文字を全部小文字にする。
     for (auto& c : name_str) c = std::tolower(c);
 
+    // ボタンのオプションの処理。 (valueを取らない。)
+    if (name_str == "clear hash") {
+      // トランスポジションテーブルの初期化。
+      engine_ptr_->table().Clear();
+      return;
+    } else if ((name_str == "save hash") || (name_str == "load hash")) {
+      // トランスポジションテーブルの保存と読み込み。
+      std::ostringstream sout;
+      std::string note = "";
+      if (name_str == "save hash") {
+        if (engine_ptr_->table().Save(hash_file_,
+        engine_ptr_->hash_key_seed())) {
+          sout << "info string Saved the hash table to '";
+        } else {
+          sout << "info string Couldn't save the hash table to '";
+        }
+      } else {
+        if (engine_ptr_->table().Load(hash_file_,
+        engine_ptr_->hash_key_seed())) {
+          sout << "info string Loaded the hash table from '";
+        } else {
+          sout << "info string Couldn't load the hash table from '";
+          // サイズか種が違うと読み込めないので、そのことも知らせる。
+          note = " (Hash and Hash Key Seed must be the same as when saved.)";
+        }
+      }
+      sout << hash_file_ << "'." << note;
+
+      // 出力関数に送る。
+      std::unique_lock<std::mutex> lock(print_mutex_);  // ロック。
+      for (auto& func : output_listeners_) {
+        func(sout.str());
+      }
+      return;
+    }
+
+    // valueがあるかどうか。
+    // なければ設定できない。
+    if (args.find("value") == args.end()) return;
+
     // nameごとの処理。
     if (name_str == "hash") {
       // トランスポジションテーブルのサイズ変更。
@@ -474,9 +684,21 @@ namespace Sayuri {
       } catch (...) {
         // 無視。
       }
-    } else if (name_str == "clear hash") {
-      // トランスポジションテーブルの初期化。
-      engine_ptr_->table().Clear();
+    } else if (name_str == "large pages") {
+      // ラージページの有効化、無効化。
+      if (args["value"][1] == "true") {
+        engine_ptr_->table().SetLargePages(true);
+      } else if (args["value"][1] == "false") {
+        engine_ptr_->table().SetLargePages(false);
+      }
+    } else if (name_str == "eval hash") {
+      // 評価値のハッシュテーブルのサイズ変更。 (スレッド毎、0なら使わない)
+      try {
+        engine_ptr_->SetEvalTableSize
+        (std::stoull(args["value"][1]) * 1024ull * 1024ull);
+      } catch (...) {
+        // 無視。
+      }
     } else if (name_str == "ponder") {
       // ponderの有効化、無効化。
       if (args["value"][1] == "true") enable_pondering_ = true;
@@ -486,9 +708,36 @@ namespace Sayuri {
       try {
         num_threads_ = Util::GetMax(std::stol(args["value"][1]), 1);
         Util::UpdateMin(num_threads_, UCI_MAX_THREADS);
+
+        // 探索用スレッドを用意しておく。
+        engine_ptr_->SetNumThreads(num_threads_);
+
+        // トランスポジションテーブルの初期化もそのスレッド数で行う。
+        engine_ptr_->table().num_threads(num_threads_);
       } catch (...) {
         // 無視。
       }
+    } else if (name_str == "lazy smp") {
+      // 並列探索のアルゴリズムの切り替え。 (trueならLazy SMP、falseならYBWC)
+      if (args["value"][1] == "true") enable_lazy_smp_ = true;
+      else if (args["value"][1] == "false") enable_lazy_smp_ = false;
+    } else if (name_str == "hash key seed") {
+      // 局面のハッシュ値を生成する種の変更。 (16進数も可)
+      try {
+        engine_ptr_->SetHashKeySeed(std::stoull(args["value"][1], nullptr, 0));
+      } catch (...) {
+        // 無視。
+      }
+    } else if (name_str == "hash file") {
+      // トランスポジションテーブルを保存するファイル名。
+      std::string file_name = "";
+      for (unsigned int i = 1; i < args["value"].size(); ++i) {
+        file_name += args["value"][i] + " ";
+      }
+      if (!file_name.empty()) {
+        file_name.pop_back();
+        hash_file_ = file_name;
+      }
     } else if (name_str == "uci_analysemode") {
       // アナライズモードの有効化、無効化。
       if (args["value"][1] == "true") analyse_mode_ = true;
@@ -670,6 +919,16 @@ namespace Sayuri {
     engine_ptr_->EnableInfiniteThinking(false);
   }
 
+  // 「perft」コマンドのコールバック関数。
+  void UCIShell::CommandPerft(UCICommand::CommandArgs& args) {
+    RunPerft(args, "perft", false);
+  }
+
+  // 「divide」コマンドのコールバック関数。
+  void UCIShell::CommandDivide(UCICommand::CommandArgs& args) {
+    RunPerft(args, "divide", true);
+  }
+
   // ============== //
   // パブリック関数 //
   // ============== //
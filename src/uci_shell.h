@@ -219,6 +219,15 @@ namespace Sayuri {
       void PrintFinalInfo(int depth, Chrono::milliseconds time,
       u64 num_nodes, int hashfull, int score,  PVLine& pv_line);
 
+      /**
+       * ポーンや評価値のハッシュテーブルの統計を出力する。
+       * @param name テーブルの名前。
+       * @param num_probes テーブルを調べた回数。
+       * @param num_hits テーブルにヒットした回数。
+       */
+      void PrintTableInfo(const std::string& name, u64 num_probes,
+      u64 num_hits);
+
       // ======== //
       // アクセサ //
       // ======== //
@@ -232,6 +241,11 @@ namespace Sayuri {
        * @return スレッドの数。
        */
       int num_threads() const {return num_threads_;}
+      /**
+       * アクセサ - 並列探索にLazy SMPを使うかどうか。
+       * @return Lazy SMPを使うならtrue。 YBWCならfalse。
+       */
+      bool enable_lazy_smp() const {return enable_lazy_smp_;}
 
       // ============ //
       // ミューテータ //
@@ -243,6 +257,13 @@ namespace Sayuri {
       void num_threads(int num_threads) {
         num_threads_ = Util::GetMax(num_threads, 1);
       }
+      /**
+       * ミューテータ - 並列探索にLazy SMPを使うかどうか。
+       * @param enable_lazy_smp Lazy SMPを使うならtrue。 YBWCならfalse。
+       */
+      void enable_lazy_smp(bool enable_lazy_smp) {
+        enable_lazy_smp_ = enable_lazy_smp;
+      }
 
     private:
       // ================ //
@@ -251,6 +272,15 @@ namespace Sayuri {
       /** 探索スレッド。 */
       void ThreadThinking();
 
+      /**
+       * Perftを実行して結果を出力する。
+       * @param args コマンドライン。 (深さとhashサブコマンド)
+       * @param command_name コマンド名。 (「perft」か「divide」)
+       * @param print_divide ルートの合法手毎のノード数も出力するかどうか。
+       */
+      void RunPerft(UCICommand::CommandArgs& args,
+      const std::string& command_name, bool print_divide);
+
       // =============== //
       // UCIコマンド関数 //
       // =============== //
@@ -294,6 +324,16 @@ namespace Sayuri {
        * @param args コマンドライン。
        */
       void CommandPonderHit(UCICommand::CommandArgs& args);
+      /**
+       * 「perft」コマンドのコールバック関数。 (独自拡張)
+       * @param args コマンドライン。
+       */
+      void CommandPerft(UCICommand::CommandArgs& args);
+      /**
+       * 「divide」コマンドのコールバック関数。 (独自拡張)
+       * @param args コマンドライン。
+       */
+      void CommandDivide(UCICommand::CommandArgs& args);
 
       // ======== //
       // 便利関数 //
@@ -329,8 +369,12 @@ namespace Sayuri {
       bool enable_pondering_;
       /** UCIオプション。 スレッドの数。 */
       int num_threads_;
+      /** UCIオプション。 並列探索にLazy SMPを使うかどうか。 */
+      bool enable_lazy_smp_;
       /** UCIオプション。 アナライズモード。 */
       bool analyse_mode_;
+      /** UCIオプション。 トランスポジションテーブルを保存するファイル。 */
+      std::string hash_file_;
 
       /** 出力用ミューテックス。 */
       static std::mutex print_mutex_;